@@ -27,6 +27,7 @@ from fontio3.CFF import (cffbounds,
                          privatedict)
 from fontio3.fontdata import deferreddictmeta
 from fontio3.utilities import walker, writer
+from fontio3.utilitiesbackend import utSubroutinize
 
 
 # -----------------------------------------------------------------------------
@@ -103,6 +104,48 @@ def _sfloat(s):
     except ValueError:
         return 0.0
 
+def _subroutinized(cs, localSubrs, globalSubrs, **kwArgs):
+    """
+    If the 'subroutinize' kwArg is True, returns a pair (charstrings,
+    globalSubrs): the specified charstrings flattened and then rebuilt to
+    call a new set of global subrs made from the runs of tokens they share.
+    The localSubrs list has the local subrs (or None) each charstring uses;
+    there are no local subrs afterwards. The 'subroutinizeBudget' kwArg
+    (default 30) is the most processor time, in seconds, to spend choosing
+    subrs.
+
+    Returns None if subroutinizing isn't asked for, runs out of time, can't
+    follow a charstring (one using arithmetic operators, say), or wouldn't
+    make things smaller.
+
+    >>> seg = utilities.fromhex("F7F7 F7F7 05 8B F7F7 8B F7F7 F7F7 8B 08")
+    >>> cs = [utilities.fromhex("8B 8B 15") + seg * n + b'\\x0e' for n in range(1, 5)]
+    >>> newCS, newSubrs = _subroutinized(cs, [None] * 4, [], subroutinize=True)
+    >>> sum(map(len, cs)), sum(map(len, newCS + newSubrs))
+    (166, 54)
+    >>> newCS[3].hex()
+    '211df7f7221d201d0e'
+    >>> print(_subroutinized(cs, [None] * 4, []))
+    None
+    """
+
+    if not kwArgs.get('subroutinize', False):
+        return None
+
+    r = utSubroutinize(
+      cs,
+      localSubrs,
+      globalSubrs,
+      float(kwArgs.get('subroutinizeBudget', 30)))
+
+    if r is None:
+        return None
+
+    oldSubrs = [globalSubrs] + list({id(x): x for x in localSubrs if x}.values())
+    oldSize = sum(map(len, cs)) + sum(len(b) for x in oldSubrs for b in x)
+    newSize = sum(map(len, r[0])) + sum(map(len, r[1]))
+    return (r if newSize < oldSize else None)
+
 def _validate_glyphNames(d, **kwArgs):
     isOK = True
     logger = kwArgs['logger']
@@ -380,6 +423,11 @@ class CFF(object, metaclass=deferreddictmeta.FontDataMetaclass):
         """
         Adds the binary data for the CFF object to the specified LinkedWriter.
 
+        If the 'subroutinize' kwArg is True, the CharStrings are flattened
+        and rewritten to call a new set of global subrs, replacing the
+        font's own subrs, as long as that makes them smaller. See
+        _subroutinized for the 'subroutinizeBudget' kwArg.
+
         >>> d = utilities.fromhex(_testingData)
         >>> w = walker.StringWalker(d)
         >>> obj = CFF.fromwalker(w)
@@ -483,49 +531,62 @@ class CFF(object, metaclass=deferreddictmeta.FontDataMetaclass):
         oFunc.maxoffset = w._byteLength() - idxbase
         w.setDeferredValue(tdOffSize, "B", oFunc.numBytes())
 
-        # String INDEX
-        cffindex.buildBinary(fontstrings, w)
-
-        # Global Subr INDEX
-        gsr = ceCopy.get('_globalsubrs', [])
-        cffindex.buildBinary(gsr, w)
-
-        # Encodings
-        if 'encoding' in cffstakes:
-            w.stakeCurrentWithValue(cffstakes['encoding'])
-            enc.buildBinary(w, **kwArgs)
-
-        # Charsets
-        if 'charset' in cffstakes:
-            w.stakeCurrentWithValue(cffstakes['charset'])
-            cs.buildBinary(w, strings=fontstrings, **kwArgs)
-
-        # CharStrings INDEX
-        w.stakeCurrentWithValue(cffstakes['charstrings'])
-        cs = []
+        # CharStrings are built here, since subroutinizing them replaces
+        # the Global Subr INDEX and the Local Subr INDEX
+        chrstrs = []
         private = ceCopy.get('_private', privatedict.PrivateDict())
         for i in range(len(self)):
 
             if i in self._dOrig:
                 # not modified; use the original binary charstring
-                cs.append(ceCopy['_charstrings'][i])
+                chrstrs.append(ceCopy['_charstrings'][i])
             else:
                 # modified; rebuild binary
                 try:
                     obj = self[i]
                     if obj.isComposite:
-                        cs.append(
+                        chrstrs.append(
                           obj.binaryString(
                             private=private,
                             accent=self[obj.accentGlyph],
                             base=self[obj.baseGlyph]))
                     else:
-                        cs.append(obj.binaryString(private=private))
+                        chrstrs.append(obj.binaryString(private=private))
                 except ValueError as exc:
                     # raise (new) exception, adding glyph id info
                     raise ValueError("Error building glyph %d: %s" % (i, exc.message))
 
-        cffindex.buildBinary(cs, w)
+        gsr = ceCopy.get('_globalsubrs', [])
+        lsr = private.get('localsubrs', None)
+        subroutinized = _subroutinized(
+          chrstrs,
+          [lsr] * len(chrstrs),
+          gsr,
+          **kwArgs)
+
+        if subroutinized is not None:
+            chrstrs, gsr = subroutinized
+            lsr = None
+
+        # String INDEX
+        cffindex.buildBinary(fontstrings, w)
+
+        # Global Subr INDEX
+        cffindex.buildBinary(gsr, w)
+
+        # Encodings
+        if 'encoding' in cffstakes:
+            w.stakeCurrentWithValue(cffstakes['encoding'])
+            enc.buildBinary(w, **kwArgs)
+
+        # Charsets
+        if 'charset' in cffstakes:
+            w.stakeCurrentWithValue(cffstakes['charset'])
+            cs.buildBinary(w, strings=fontstrings, **kwArgs)
+
+        # CharStrings INDEX
+        w.stakeCurrentWithValue(cffstakes['charstrings'])
+        cffindex.buildBinary(chrstrs, w)
 
         # offSize
         """
@@ -546,7 +607,7 @@ class CFF(object, metaclass=deferreddictmeta.FontDataMetaclass):
                     pd[pdk] = (v,)
                 else:
                     pd[pdk] = v
-        if 'localsubrs' in private:
+        if 'localsubrs' in private and subroutinized is None:
             pd[19] = private['localsubrs']
 
         cffdict.buildBinary(
@@ -558,7 +619,6 @@ class CFF(object, metaclass=deferreddictmeta.FontDataMetaclass):
         w.stakeCurrentWithValue(cffstakes['privateend'])
 
         # Local Subr INDEX
-        lsr = private.get('localsubrs', None)
         if lsr:
             cffindex.buildBinary(lsr, w)
 
@@ -570,7 +630,9 @@ class CFF(object, metaclass=deferreddictmeta.FontDataMetaclass):
     def buildBinary_CID(self, w, **kwArgs):
         """
         Adds the binary data for the CID-keyed CFF object to the
-        specified LinkedWriter.
+        specified LinkedWriter. The 'subroutinize' kwArg works as it does
+        for buildBinary; the new subrs are all global, so the FDs' Private
+        DICTs lose their local subrs.
 
         >>> d = utilities.fromhex(_testingData)
         >>> w = walker.StringWalker(d)
@@ -669,11 +731,41 @@ class CFF(object, metaclass=deferreddictmeta.FontDataMetaclass):
         oFunc.maxoffset = w._byteLength() - idxbase
         w.setDeferredValue(tdOffSize, "B", oFunc.numBytes())
 
+        # CharStrings are built here, since subroutinizing them replaces
+        # the Global Subr INDEX and the FDs' Local Subr INDEXes
+        chrstrs = []
+        for i in range(len(self)):
+
+            if i in self._dOrig:
+                # not modified; use the original binary charstring
+                chrstrs.append(ceCopy['_charstrings'][i])
+            else:
+                # modified; rebuild binary
+                obj = self[i]
+                if obj.isComposite:
+                    chrstrs.append(
+                      self[i].binaryString(
+                        private=ceCopy['_privatearray'][fds[i]],
+                        accent=self[obj.accentGlyph],
+                        base=self[obj.baseGlyph]))
+                else:
+                    chrstrs.append(
+                      self[i].binaryString(private=ceCopy['_privatearray'][fds[i]]))
+
+        gsr = ceCopy.get('_globalsubrs', [])
+        subroutinized = _subroutinized(
+          chrstrs,
+          [pvtarray[fds[i]].get('localsubrs', None) for i in range(len(self))],
+          gsr,
+          **kwArgs)
+
+        if subroutinized is not None:
+            chrstrs, gsr = subroutinized
+
         # String INDEX
         cffindex.buildBinary(fontstrings, w)
 
         # Global Subr INDEX
-        gsr = ceCopy.get('_globalsubrs', [])
         cffindex.buildBinary(gsr, w)
 
         # Encodings are not present/not allowed in CID
@@ -689,26 +781,7 @@ class CFF(object, metaclass=deferreddictmeta.FontDataMetaclass):
 
         # CharStrings INDEX
         w.stakeCurrentWithValue(cffstakes['charstrings'])
-        cs = []
-        for i in range(len(self)):
-
-            if i in self._dOrig:
-                # not modified; use the original binary charstring
-                cs.append(ceCopy['_charstrings'][i])
-            else:
-                # modified; rebuild binary
-                obj = self[i]
-                if obj.isComposite:
-                    cs.append(
-                      self[i].binaryString(
-                        private=ceCopy['_privatearray'][fds[i]],
-                        accent=self[obj.accentGlyph],
-                        base=self[obj.baseGlyph]))
-                else:
-                    cs.append(
-                      self[i].binaryString(private=ceCopy['_privatearray'][fds[i]]))
-
-        cffindex.buildBinary(cs, w)
+        cffindex.buildBinary(chrstrs, w)
 
         # FD INDEX (CID only)
         w.stakeCurrentWithValue(cffstakes['fdarray'])
@@ -725,7 +798,7 @@ class CFF(object, metaclass=deferreddictmeta.FontDataMetaclass):
                         pd[pdk] = (v,)
                     else:
                         pd[pdk] = v
-            if 'localsubrs' in private:
+            if 'localsubrs' in private and subroutinized is None:
                 pd[19] = private['localsubrs']
 
             w.stakeCurrentWithValue(cffstakes['privatestart%d' % (i,)])
@@ -751,7 +824,7 @@ class CFF(object, metaclass=deferreddictmeta.FontDataMetaclass):
 
         # Local Subr INDEXes from Privates
         for i,pd in enumerate(pvtarray):
-            if 'localsubrs' in pd:
+            if 'localsubrs' in pd and subroutinized is None:
                 w.stakeCurrentWithValue(cffstakes['lsrstart%d' % (i,)])
                 cffindex.buildBinary(
                   pd.localsubrs,
@@ -772,7 +845,12 @@ class CFF(object, metaclass=deferreddictmeta.FontDataMetaclass):
 
         ce = r.copyCreationExtras()
 
-        chrsr = ce.get('_charstrings').glyphsRenumbered(
+        chrs = ce.get('_charstrings')
+
+        if not isinstance(chrs, charstrings.CharStrings):
+            chrs = charstrings.CharStrings(enumerate(chrs))
+
+        chrsr = chrs.glyphsRenumbered(
           oldToNew,
           keepMissing = km)
         ce['_charstrings'] = chrsr
@@ -1339,9 +1417,7 @@ class CFF(object, metaclass=deferreddictmeta.FontDataMetaclass):
             we need to grab that first.
             """
             wSub = w.subWalker(td[17][0])
-            chrstrs = charstrings.CharStrings.fromwalker(
-              wSub,
-              )
+            chrstrs = cffindex.fromwalker(wSub)
 
         if fi.isCID:
             cidcount = td.get((12,34), (8720,))[0]
@@ -9,6 +9,7 @@ Support for sequences of Cubic_contour objects.
 """
 
 # System imports
+import array
 import itertools
 import logging
 import operator
@@ -223,6 +224,70 @@ class CFFContours(list, metaclass=seqmeta.FontDataMetaclass):
 
 
 
+    def packedSegments(self):
+        """
+        Returns an array('d') with the contours of self as cubic segments
+        packed 8 doubles apiece (x0, y0, x1, y1, x2, y2, x3, y3), as the
+        fastmath backend's fmCubicBounds expects them. Straight lines become
+        segments whose control points lie on their ends, and each contour is
+        closed back to its first point. Returns None if any contour is empty,
+        starts off-curve, or has a run of off-curve points other than a pair.
+
+        >>> list(_testingValues[2].packedSegments())
+        [5.0, 5.0, 7.0, 7.0, 9.0, 9.0, 10.0, 10.0, 10.0, 10.0, 10.0, 10.0, 5.0, 5.0, 5.0, 5.0]
+
+        With tight=False, fmCubicBounds matches CFFBounds.fromcontours (which
+        uses every point) once rounded:
+
+        >>> for obj in _testingValues:
+        ...     b = fastmathbackend.fmCubicBounds(obj.packedSegments())
+        ...     b = cffbounds.CFFBounds(*[int(round(n)) for n in b])
+        ...     print(b == cffbounds.CFFBounds.fromcontours(obj))
+        True
+        True
+        True
+        True
+
+        >>> c = contour_cubic.Contour_cubic([
+        ...   pointwithonoff.PointWithOnOff((5, 5), onCurve=True),
+        ...   pointwithonoff.PointWithOnOff((7, 7), onCurve=False)])
+        >>> print(CFFContours([c]).packedSegments())
+        None
+        """
+
+        v = []
+
+        for c in self:
+            n = len(c)
+
+            if (not n) or (not c[0].onCurve):
+                return None
+
+            pts = list(c) + [c[0]]
+            i = 0
+
+            while i < n:
+                p0 = pts[i]
+
+                if pts[i + 1].onCurve:
+                    p3 = pts[i + 1]
+                    v.extend([p0.x, p0.y, p0.x, p0.y, p3.x, p3.y, p3.x, p3.y])
+                    i += 1
+
+                elif (
+                  (i + 3 <= n) and
+                  (not pts[i + 2].onCurve) and
+                  pts[i + 3].onCurve):
+
+                    p1, p2, p3 = pts[i + 1:i + 4]
+                    v.extend([p0.x, p0.y, p1.x, p1.y, p2.x, p2.y, p3.x, p3.y])
+                    i += 3
+
+                else:
+                    return None
+
+        return array.array('d', v)
+
     def pointIterator(self):
         """
         Returns an iterator which yields individual PointWithOnOff objects, without
@@ -250,7 +315,8 @@ if 0:
     def __________________(): pass
 
 if __debug__:
-    from fontio3 import utilities
+    from fontio3 import fastmathbackend, utilities
+    from fontio3.CFF import cffbounds
     from fontio3.fontmath import contour_cubic
     from fontio3.fontmath import pointwithonoff
 
@@ -48,33 +48,9 @@ def _writeCffInteger(n, w):
     Writes integer 'n' to LinkedWriter 'w' using CFF DICT Operator
     Encoding scheme for integer values.
     """
-    if -107 <= n <= 107:
-        w.add("B", n + 139)
-        
-    elif 108 <= n <= 1131:
-        w.add("H", n + 0xF694)
-
-    elif -1131 <= n <= -108:
-        w.add("H", 0xFA94 - n)
-
-    elif -32768 <= n <= 32767:
-        w.add("Bh", 28, n)
-
-    else:
-        w.add("Bl", 29, n)
-
-        
-# -----------------------------------------------------------------------------
-
-#
-# Constants
-#
-
-_fpnybbles = [
-  '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '.', 'E', 'E-', '', '-']
-  
-_reservedOperands = (22, 23, 24, 25, 26, 27, 31, 255)
     
+    w.addString(utilitiesbackend.utEncodeDictOperands([n]))
+
 # -----------------------------------------------------------------------------
 
 #
@@ -111,6 +87,16 @@ def fromwalker(w, **kwArgs):
     {0: [0], 2: [300], (12, 0): [1]}
     >>> t
     [0, 2, (12, 0)]
+    
+    File walkers work too (their lengths are floats):
+    
+    >>> fd, path = tempfile.mkstemp()
+    >>> os.write(fd, data) == len(data)
+    True
+    >>> os.close(fd)
+    >>> fromwalker(filewalkerbit.FileWalkerBit(path)) == (d, t)
+    True
+    >>> os.remove(path)
     >>> data = _testingData[1]
     >>> w = walker.StringWalker(data)
     >>> logger = utilities.makeDoctestLogger("test")
@@ -118,6 +104,17 @@ def fromwalker(w, **kwArgs):
     test.DICT - DEBUG - Walker has 8 remaining bytes.
     test.DICT - ERROR - Reserved value 22 in DICT operand
     ({0: [500]}, [0])
+    
+    Real numbers are read the same way float() reads them:
+    
+    >>> w = walker.StringWalker(_testingData[2])
+    >>> fromwalker(w)
+    ({(12, 7): [0.001, 0, 0, 0.001, 0, 0]}, [(12, 7)])
+    >>> w = walker.StringWalker(_testingData[3])
+    >>> fromwalker(w, doValidation=True, logger=logger)
+    test.DICT - DEBUG - Walker has 7 remaining bytes.
+    test.DICT - ERROR - DICT data too short for operand.
+    ({(12, 8): [-1e-05]}, [(12, 8)])
     """
     
     doValidation = kwArgs.get('doValidation', False)
@@ -131,142 +128,48 @@ def fromwalker(w, **kwArgs):
           (w.length(),),
           "Walker has %d remaining bytes."))
     
+    entries, error = utilitiesbackend.utDecodeDict(w.rest())
     d = {}
     keyorder = []
-
-    while w.stillGoing():
-        operands = []
+    
+    for key, operands in entries:
+        if doValidation:
+            for i in range(len(operands) - 48):
+                logger.error((
+                  'V0844',
+                  (),
+                  "Number of DICT operands exceeds limit of 48."))
         
-        while w.stillGoing():
-            b0 = w.unpack("B")
-            remLen = w.remainingLength()
+        keyorder.append(key)
+        d[key] = operands
+    
+    if error is not None:
+        kind, value, operands = error
+        
+        if doValidation:
+            for i in range(len(operands) - 48):
+                logger.error((
+                  'V0844',
+                  (),
+                  "Number of DICT operands exceeds limit of 48."))
             
-            if b0 < 22:
-                break # operator
-
-            elif b0 in _reservedOperands:
-                if doValidation:
-                    logger.error((
-                      "V0847",
-                      (b0,),
-                      "Reserved value %d in DICT operand"))
-                return d,keyorder
-
-            elif 32 <= b0 <= 246: # one-byte number
-                operands.append(b0 - 139)
-
-            elif b0 == 30: # floating-point
-                sv = []
-                
-                while True:
-                    if w.atEnd():
-                        if doValidation:
-                            logger.error((
-                              "V0848",
-                              (),
-                              "DICT data too short for operand."))
-                        return d,keyorder
-
-                    b = w.unpack("B")
-                    n = b >> 4
-                    
-                    if n == 15:
-                        break
-                    elif n == 13:
-                        if doValidation:
-                            logger.error((
-                              "V0847",
-                              (n,),
-                              "Reserved value %d in DICT operand"))
-                        return d,keyorder
-                    else:
-                        sv.append(_fpnybbles[n])
-                        
-                    n = b & 15
-                    
-                    if n == 15:
-                        break
-                    elif n == 13:
-                        if doValidation:
-                            logger.error((
-                              "V0847",
-                              (n,),
-                              "Reserved value %d in DICT operand"))
-                        return d,keyorder
-                    else:
-                        sv.append(_fpnybbles[n])
-
-                operands.append(float(''.join(sv)))
+            if kind == 1:
+                logger.error((
+                  "V0847",
+                  (value,),
+                  "Reserved value %d in DICT operand"))
             
-            elif 247 <= b0 <= 254: # two-byte number
-                if remLen < 1:
-                    if doValidation:
-                        logger.error((
-                          "V0848",
-                          (),
-                          "DICT data too short for operand."))
-                    return d,keyorder
-                
-                b1 = w.unpack("B")
-                
-                if b0 < 251:
-                    operands.append((b0 - 247) * 256 + b1 + 108)
-                else:
-                    operands.append((251 - b0) * 256 - b1 - 108)
-                    
-            elif b0 == 28: # three-byte number
-                if remLen < 2:
-                    if doValidation:
-                        logger.error((
-                          "V0848",
-                          (),
-                          "DICT data too short for operand."))
-                    return d,keyorder
-                
-                operands.append(w.unpack("h"))
-                
-            else: # four-byte number
-                if remLen < 4:
-                    if doValidation:
-                        logger.error((
-                          "V0848",
-                          (),
-                          "DICT data too short for operand."))
-                    return d,keyorder
-
-                operands.append(w.unpack("l"))
-
-            if len(operands) > 48:
-                if doValidation:
-                    logger.error((
-                      'V0844',
-                      (),
-                      "Number of DICT operands exceeds limit of 48."))
-                
-        else:
-            if doValidation:
+            elif kind == 2:
+                logger.error((
+                  "V0848",
+                  (),
+                  "DICT data too short for operand."))
+            
+            else:
                 logger.error((
                   "V0849",
                   (),
                   "DICT operands not followed by operator."))
-            return d,keyorder
-            
-        if b0 == 12: # extension operator
-            if w.atEnd():
-                if doValidation:
-                    logger.error((
-                      "V0848",
-                      (),
-                      "DICT data too short for operand."))
-                return d,keyorder
-                
-            key = (12, w.unpack("B"))
-        
-        else:
-            key = b0
-            
-        keyorder.append(key)
-        d[key] = operands
 
     return d, keyorder
     
@@ -301,6 +204,18 @@ def buildBinary(d, w, **kwArgs):
     >>> wr.stakeCurrentWithValue(namedStakes['charset'])
     >>> print(utilities.hexdumpString(wr.binaryString()), end='')
            0 |8B00 990F 2D2D 2D2D  2D2D 2D2D 2D2D      |....----------  |
+    
+    Real numbers use the shortest form that reads back the same:
+    
+    >>> d = {(12, 7): [0.001, 0, 0, 0.001, 0, 0], 5: [-0.5, 1e-05, 2.5e+20]}
+    >>> wr = writer.LinkedWriter()
+    >>> buildBinary(d, wr)
+    >>> s = wr.binaryString()
+    >>> print(utilities.hexdumpString(s), end='')
+           0 |1EEA 5F1E 1C5F 1E2A  5B20 FF05 1EA0 01FF |.._.._.*[ ......|
+          10 |8B8B 1EA0 01FF 8B8B  0C07                |..........      |
+    >>> fromwalker(walker.StringWalker(s))[0] == d
+    True
     """
 
     stakeValues = kwArgs.get('stakeValues', None)
@@ -398,42 +313,7 @@ def buildBinary(d, w, **kwArgs):
               stakeValues[staketotag])
 
         else:
-            for operand in d[op]:
-                if isinstance(operand, float):
-                    s = str(operand).lstrip('0') # strip leading zero(es)
-                    nybs = [1, 14]
-                    i = 0
-                    
-                    while i < len(s):
-                        c = s[i]
-                        
-                        if '0' <= c <= '9':
-                            nybs.append(int(c))
-                        
-                        elif c == '.':
-                            nybs.append(10)
-                        
-                        elif c == '-':
-                            nybs.append(14)
-                        
-                        elif c == 'E':
-                            if (i < (len(s) - 1)) and (s[i+1] == '-'):
-                                nybs.append(12)
-                                i += 1
-                            
-                            else:
-                                nybs.append(11)
-
-                        i += 1
-                    
-                    if len(nybs) % 2: nybs.append(15)
-                    else: nybs.extend([15, 15])
-                    for i in range(0, len(nybs), 2):
-                        n = nybs[i] * 16 + nybs[i+1]
-                        w.add("B", n)
-                
-                else: # integer
-                    _writeCffInteger(operand, w)
+            w.addString(utilitiesbackend.utEncodeDictOperands(d[op]))
 
         if isinstance(op, tuple):
             w.add("BB", *op)
@@ -450,12 +330,16 @@ if 0:
     def __________________(): pass
 
 if __debug__:
+    import os
+    import tempfile
     from fontio3 import utilities
-    from fontio3.utilities import walker, writer
+    from fontio3.utilities import filewalkerbit, walker, writer
     
     _testingData = (
         utilities.fromhex("8B 00 F7 C0 02 8C 0C 00"),
-        utilities.fromhex("F8 88 00 8B 16 8B 0C 00")
+        utilities.fromhex("F8 88 00 8B 16 8B 0C 00"),
+        utilities.fromhex("1E A0 01 FF 8B 8B 1E A0 01 FF 8B 8B 0C 07"),
+        utilities.fromhex("1E E1 C5 FF 0C 08 0C")
         )
 
 def _test():
@@ -19,6 +19,7 @@ from fontio3.CFF.encodings_predefined import adobeStandardEncoding
 from fontio3.fontdata import simplemeta
 from fontio3.fontmath import pointwithonoff, contour_cubic
 from fontio3.utilities import walker
+from fontio3.utilitiesbackend import utDecodeCharstring
 
 # -----------------------------------------------------------------------------
 
@@ -123,6 +124,58 @@ def _appendPoint(obj, x, y, onCurve):
     obj['curX'] = x
     obj['curY'] = y
 
+def _decodeNative(obj, charstring, globalsubrs, private, reversecharsetmap):
+    """
+    Fills in obj's 'contours', 'advance', 'components' and 'accentoffset'
+    the way _buildGlyph does, but using the native charstring interpreter.
+    Returns False, leaving obj alone, if the charstring needs _buildGlyph
+    instead: that's the case for arithmetic and storage operators,
+    fractional operands, and data _buildGlyph raises an exception for.
+
+    >>> obj = dict(contours=None, advance=None, components=[], accentoffset=[])
+    >>> cs = utilities.fromhex("F6 8B 8B 15 EF 06 0E")
+    >>> _decodeNative(obj, cs, [], {'nominalWidthX': 100}, {})
+    True
+    >>> obj['advance'], [tuple(p) for p in obj['contours'][0]]
+    (207, [(0, 0), (100, 0)])
+    >>> cs = utilities.fromhex("8C 8C 0C 0A 8B 15 0E")
+    >>> _decodeNative(obj, cs, [], {}, {})
+    False
+    """
+
+    r = utDecodeCharstring(
+      charstring,
+      getattr(private, 'localsubrs', None),
+      globalsubrs)
+
+    if r is None:
+        return False
+
+    points, flags, ends, width, seac = r
+
+    if width is not None:
+        obj['advance'] = width + private.get('nominalWidthX', 0)
+
+    if seac is not None:
+        obj['components'] = _seacComponents(seac[2:], reversecharsetmap)
+        obj['accentoffset'] = list(seac[:2])
+
+    elif ends:
+        obj['contours'] = cffcontours.CFFContours()
+        start = 0
+
+        for end in ends:
+            obj['contours'].append(contour_cubic.Contour_cubic([
+              pointwithonoff.PointWithOnOff(
+                (points[2 * i], points[2 * i + 1]),
+                onCurve=bool(flags[i]))
+              for i in range(start, end + 1)]))
+
+            start = end + 1
+
+    return True
+
+
 def _buildGlyph(obj, w, globalsubrs, private, reversecharsetmap, **kwArgs):
     """
     Appends obj with parsed Type2 CharString data from StringWalker w +
@@ -899,20 +952,10 @@ def _buildGlyph(obj, w, globalsubrs, private, reversecharsetmap, **kwArgs):
                           (),
                           "Glyph uses deprecated 'seac' operator"))
 
-                    components = []
-
-                    for o in operands[2:]:
-                        sid = adobeStandardEncoding.get(o, None)
-
-                        if sid:
-                            sstr = stdStrings[sid]
-
-                            if sstr:
-                                gid = reversecharsetmap.get(sstr)
-                                components.append(gid)
-
                     obj['contours'] = None
-                    obj['components'] = components
+                    obj['components'] = _seacComponents(
+                      operands[2:],
+                      reversecharsetmap)
                     obj['accentoffset'] = operands[:2]
 
                 # check for un-added single-point contour.
@@ -1380,6 +1423,27 @@ def _recalc(obj, **kwArgs):
     return newObj != obj, newObj
 
 
+def _seacComponents(codes, reversecharsetmap):
+    """
+    Returns the glyph indices for the 'bchar' and 'achar' operands of an
+    endchar used as seac. These are Standard Encoding codes, which are
+    translated to SIDs and then looked up in the reverse charset mapping.
+    """
+
+    components = []
+
+    for o in codes:
+        sid = adobeStandardEncoding.get(o, None)
+
+        if sid:
+            sstr = stdStrings[sid]
+
+            if sstr:
+                components.append(reversecharsetmap.get(sstr))
+
+    return components
+
+
 def _stob(s):
     """
     Express variable-length bytestring 's' as 1s and 0s, used for masks.
@@ -1586,7 +1650,8 @@ class CFFGlyph(object, metaclass=simplemeta.FontDataMetaclass):
         Constructs and returns a CFFGlyph by parsing and interpreting the
         specified charstring, privatedict (containing localsubrs), and
         globalsubrs, *ALL* of which are required in order to fully parse a
-        glyph into a usable form.
+        glyph into a usable form. The charstring is run by the native
+        interpreter when it can be, and by _buildGlyph otherwise.
 
         >>> cs = utilities.fromhex(
         ...   "8C 8B BD F7 ED 77 F7 A7 BD 01 8B BD F8 24 BD 03 "
@@ -1640,10 +1705,18 @@ class CFFGlyph(object, metaclass=simplemeta.FontDataMetaclass):
           components = [],
           accentoffset = [])
 
-        w = walker.StringWalker(charstring)
+        if not _decodeNative(
+          glyphobj, charstring, globalsubrs, privatedict, reversecharsetmap):
 
-        _buildGlyph(
-          glyphobj, w, globalsubrs, privatedict, reversecharsetmap, **kwArgs)
+            w = walker.StringWalker(charstring)
+
+            _buildGlyph(
+              glyphobj,
+              w,
+              globalsubrs,
+              privatedict,
+              reversecharsetmap,
+              **kwArgs)
 
         if glyphobj.get('contours', None) is not None:
             for cntr in glyphobj['contours']:
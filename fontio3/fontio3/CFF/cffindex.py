@@ -9,11 +9,13 @@ Generic support for INDEX structures in 'CFF ' tables.
 """
 
 # System imports
+import array
+import collections.abc
 import logging
 
 # Other imports
 from fontio3.CFF import cffdict
-from fontio3.utilitiesbackend import utPack
+from fontio3.utilitiesbackend import utIndexOffsets, utPack
 from fontio3.utilities import walker
 
 # -----------------------------------------------------------------------------
@@ -52,6 +54,113 @@ class _WriteIndexValue(object):
 
 # -----------------------------------------------------------------------------
 
+#
+# Classes
+#
+
+class LazyIndex(collections.abc.Sequence):
+    """
+    Objects representing the items of a CFF INDEX, which are only copied out
+    of the INDEX's data when they're accessed. The offsets are kept just as
+    they were in the binary data, in an array('I'), and the data is a single
+    bytes object.
+
+    >>> data = utilities.fromhex(_testingData[0])
+    >>> idx = fromwalker(walker.StringWalker(data))
+    >>> len(idx), idx[1], idx[-1]
+    (3, b'one', b'two')
+    >>> idx[1:]
+    [b'one', b'two']
+    >>> bytes(idx.view(0))
+    b'test'
+    >>> idx == [b'test', b'one', b'two']
+    True
+    >>> idx[3]
+    Traceback (most recent call last):
+    ...
+    IndexError: INDEX index out of range
+    """
+
+    __slots__ = ('offsets', 'data')
+
+    #
+    # Initialization method
+    #
+
+    def __init__(self, offsets, data):
+        """
+        Initializes the LazyIndex with the specified offsets (one more than
+        the number of items) and data.
+        """
+
+        self.offsets = offsets
+        self.data = data
+
+    #
+    # Special methods
+    #
+
+    def __eq__(self, other):
+        if isinstance(other, LazyIndex):
+            other = list(other)
+
+        return list(self) == other
+
+    __hash__ = None
+
+    def __getitem__(self, i):
+        if isinstance(i, slice):
+            return [self[j] for j in range(*i.indices(len(self)))]
+
+        start, stop = self._span(i)
+        return self.data[start:stop]
+
+    def __iter__(self):
+        offsets = self.offsets
+
+        if offsets:
+            data = self.data
+            base = offsets[0]
+
+            for i in range(len(offsets) - 1):
+                yield data[offsets[i] - base:offsets[i + 1] - base]
+
+    def __len__(self):
+        return max(0, len(self.offsets) - 1)
+
+    def __repr__(self):
+        return repr(list(self))
+
+    #
+    # Private methods
+    #
+
+    def _span(self, i):
+        n = len(self)
+
+        if i < 0:
+            i += n
+
+        if not (0 <= i < n):
+            raise IndexError("INDEX index out of range")
+
+        base = self.offsets[0]
+        return self.offsets[i] - base, self.offsets[i + 1] - base
+
+    #
+    # Public methods
+    #
+
+    def view(self, i):
+        """
+        Returns a memoryview of the specified item, without copying it.
+        """
+
+        start, stop = self._span(i)
+        return memoryview(self.data)[start:stop]
+
+# -----------------------------------------------------------------------------
+
 #
 # Public Functions
 #
@@ -61,7 +170,9 @@ if 0:
 
 def fromwalker(w, **kwArgs):
     """
-    This method reads a CFF INDEX structure from the supplied Walker.
+    This method reads a CFF INDEX structure from the supplied Walker. Unless
+    one of the following kwArgs is given, the result is a LazyIndex, whose
+    items are only copied out of the data as they're used.
 
     The following kwArgs are supported:
         'asDict'            Return the results as a Python dictionary instead
@@ -96,43 +207,28 @@ def fromwalker(w, **kwArgs):
     asDict = kwArgs.pop('asDict', False)
     itemmethod = kwArgs.pop('itemmethod', None)
 
-    if asDict:
-        idx = {}
-    else:
-        idx = []
-
     count = w.unpack("H")
 
     if count == 0:
-        return idx
-
-    if not asDict:
-        # this allows us to build idx using [] notation for either dict or list
-        idx = [None] * count
+        idx = LazyIndex(array.array('I'), b'')
 
-    offSize = w.unpack("B")
-
-    fmt = {1: "B", 2: "H", 3: "T", 4: "I"}[offSize]
-    offsets = w.group(fmt, count + 1)
+    else:
+        offSize = w.unpack("B")
 
-    # Why is this here instead of just allowing the inevitable failure later?
-    # Because unsorted offsets will result in a negative calculated 'length'
-    # which, when passed to the backend (C Extension) walker, will crash it.
-    # This moves the problem here instead which is somewhat more graceful.
-    
-    if sorted(offsets) != list(offsets):
-        raise ValueError("Offsets not sorted in INDEX!")
+        # Unsorted offsets would result in a negative calculated 'length'
+        # which, when passed to the backend (C Extension) walker, would crash
+        # it. utIndexOffsets checks for this as it decodes the offsets.
 
-    for i, offset in enumerate(offsets[:-1]):
-        length = offsets[i+1] - offset
+        offsets = utIndexOffsets(w.chunk(offSize * (count + 1)), offSize)
+        idx = LazyIndex(offsets, w.chunk(offsets[-1] - offsets[0]))
 
-        chunk = w.chunk(length)
+    if itemmethod:
+        idx = [
+          itemmethod(walker.StringWalker(chunk), **kwArgs)
+          for chunk in idx]
 
-        if itemmethod:
-            itemW = walker.StringWalker(chunk)
-            idx[i] = itemmethod(itemW, **kwArgs)
-        else:
-            idx[i] = chunk
+    if asDict:
+        return dict(enumerate(idx))
 
     return idx
 
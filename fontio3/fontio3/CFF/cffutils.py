@@ -217,14 +217,14 @@ def pack_t2_number(n, w, **kwArgs):
         elif 108 <= n <= 1131:
             if dbg: print(("packing 2-byte int %d" % (n,)))
             ns = n - 108
-            b0 = (ns/256) + 247
+            b0 = (ns//256) + 247
             b1 = (ns%256)
             w.add("BB", b0, b1)
     
         elif -1131 <= n <= -108:
             if dbg: print(("packing negative 2-byte int %d" % (n,)))
             ns = -(n + 108)
-            b0 = (ns/256) + 251
+            b0 = (ns//256) + 251
             b1 = (ns%256)
             w.add("BB", b0, b1)  
 
@@ -7,6 +7,8 @@
 
 #include <Python.h>
 #include <math.h>
+#include <pthread.h>
+#include <unistd.h>
 #include "AssertMacros.h"
 
 /* ------------------------------------------------------------------------ */
@@ -16,6 +18,21 @@
 /* AE is "almost equal" */
 #define AE(v1,v2) (fabs(v2-v1) < 1.0e-5)
 
+/* Packed segments are 7 doubles each: isSpline, on1X, on1Y, offX, offY,
+   on2X, on2Y. The off-curve pair is ignored for lines. */
+#define PACKED_SEGMENT_DOUBLES 7
+
+/* Upper bound on the worker threads a batch call will start */
+#define MAX_BATCH_THREADS 64
+
+/* Composite nesting deeper than this is treated as circular. */
+
+#define MAX_COMPONENT_DEPTH 64
+
+/* The IUP optimizer never lets one stored delta reach back further than
+   this many points; it bounds the quadratic search on very long contours. */
+#define MAX_IUP_LOOKBACK 256
+
 /* ------------------------------------------------------------------------ */
 
 /*** TYPES ***/
@@ -37,144 +54,533 @@ struct FMSegment
 typedef struct FMSegment FMSegment;
 #endif
 
+/* An FMEdge is an FMSegment prepared for the scanline sweep. The y(t) and
+   x(t) polynomial coefficients are computed once, and the discriminant of
+   y(t) = row is stepped by 4a as the sweep moves up one row, so no per-row
+   coefficient work is needed while the edge is active. */
+
+struct FMEdge
+    {
+    const FMSegment *seg;
+    double          a;      /* y(t) = a*t*t + b*t + on1Y */
+    double          b;
+    double          ax;     /* x(t) = ax*t*t + bx*t + on1X */
+    double          bx;
+    double          det;    /* b*b - 4a(on1Y - y) for the current row */
+    double          slope;  /* dx/dy, for non-horizontal lines only */
+    };
+
+#ifndef __cplusplus
+typedef struct FMEdge FMEdge;
+#endif
+
+/* One glyph's worth of work for fmFindLRExtremaBatch */
+
+struct FMBatchJob
+    {
+    const double    *packed;
+    Py_ssize_t      segCount;
+    double          yMin;
+    Py_ssize_t      rowCount;
+    double          *rows;      /* rowCount lefts followed by rowCount rights */
+    int             failed;
+    };
+
+#ifndef __cplusplus
+typedef struct FMBatchJob FMBatchJob;
+#endif
+
+/* Shared state for the worker threads; jobs (each jobSize bytes) are handed
+   out by nextJob and passed one at a time to runJob. */
+
+struct FMBatch
+    {
+    void            *jobs;
+    size_t          jobSize;
+    Py_ssize_t      jobCount;
+    Py_ssize_t      nextJob;
+    void            (*runJob)(void *job);
+    pthread_mutex_t lock;
+    };
+
+#ifndef __cplusplus
+typedef struct FMBatch FMBatch;
+#endif
+
+/* A simple quadratic glyph unpacked from caller buffers into doubles. The
+   contourEnds are the usual TrueType inclusive last-point indices. */
+
+struct FMQuadGlyph
+    {
+    double      *xs;
+    double      *ys;
+    double      *onCurve;
+    double      *contourEnds;
+    Py_ssize_t  pointCount;
+    Py_ssize_t  contourCount;
+    };
+
+#ifndef __cplusplus
+typedef struct FMQuadGlyph FMQuadGlyph;
+#endif
+
+/* A growable set of flattened points, as produced by FlattenGlyph. The
+   contourEnds are inclusive last-point indices, as in the 'glyf' table. */
+
+struct FMPointBuffer
+    {
+    double          *xs;
+    double          *ys;
+    unsigned char   *onCurve;
+    int             *contourEnds;
+    Py_ssize_t      pointCount;
+    Py_ssize_t      pointCapacity;
+    Py_ssize_t      contourCount;
+    Py_ssize_t      contourCapacity;
+    };
+
+#ifndef __cplusplus
+typedef struct FMPointBuffer FMPointBuffer;
+#endif
+
+/* The glyph sources for one fmFlattenComposites call, and the chain of
+   glyph indices currently being expanded (used to catch cycles). */
+
+struct FMFlattenContext
+    {
+    PyObject    *simples;
+    PyObject    *composites;
+    long        stack[MAX_COMPONENT_DEPTH];
+    int         depth;
+    };
+
+#ifndef __cplusplus
+typedef struct FMFlattenContext FMFlattenContext;
+#endif
+
+/* The sparse deltas of one tuple variation for the IUP kernel. Each point
+   index in points has the corresponding entries in xDeltas and yDeltas, all
+   of which are multiplied by scalar before use. */
+
+struct FMIUPTuple
+    {
+    double      scalar;
+    double      *points;
+    double      *xDeltas;
+    double      *yDeltas;
+    Py_ssize_t  count;
+    };
+
+#ifndef __cplusplus
+typedef struct FMIUPTuple FMIUPTuple;
+#endif
+
+/* One glyph's worth of work for fmInterpolateUntouchedBatch. The sums are
+   filled in by the worker: pointCount + 4 x deltas followed by as many y
+   deltas. */
+
+struct FMIUPJob
+    {
+    FMQuadGlyph glyph;
+    FMIUPTuple  *tuples;
+    Py_ssize_t  tupleCount;
+    double      *sums;
+    int         failed;
+    };
+
+#ifndef __cplusplus
+typedef struct FMIUPJob FMIUPJob;
+#endif
+
 /* ------------------------------------------------------------------------ */
 
 /*** PROTOTYPES ***/
 
-static int FindSect(double y, FMSegment *walk, Py_ssize_t segCount, double *x1, double *x2);
+static int AppendSimple(FMPointBuffer *buf, PyObject *packed);
+static void *BatchWorker(void *arg);
+static PyObject *BoundsTuple(const double *bounds, int found);
+static int CompareEdges(const void *e1, const void *e2);
+static int CubicBounds(const double *segs, Py_ssize_t segCount, int tight, double *bounds);
+static PyObject *DeltaArrays(const double *sums, Py_ssize_t n);
+static double *DoublesFromBuffer(PyObject *obj, Py_ssize_t *count);
+static void EdgeSect(const FMEdge *edge, double y, double *xMin, double *xMax, int *found);
 static void FindYExtrema(FMSegment *walk, Py_ssize_t segCount, double *yMax, double *yMin);
+static int FlattenComponents(FMFlattenContext *ctx, PyObject *components, FMPointBuffer *buf);
+static int FlattenGlyph(FMFlattenContext *ctx, long glyphIndex, FMPointBuffer *buf);
+static void FreeIUPJob(FMIUPJob *job);
+static void FreeIUPTuple(FMIUPTuple *t);
+static void FreePointBuffer(FMPointBuffer *buf);
+static void FreeQuadGlyph(FMQuadGlyph *glyph);
+static int GrowPointBuffer(FMPointBuffer *buf, Py_ssize_t extraPoints, Py_ssize_t extraContours);
+static Py_ssize_t IUPForcedPoints(
+    const double *xs, const double *ys, const double *dx, const double *dy, Py_ssize_t m,
+    double tolerance, unsigned char *forced);
+static int IUPOptimizeContour(
+    const double *xs, const double *ys, const double *dx, const double *dy, Py_ssize_t m,
+    double tolerance, unsigned char *keep);
+static void IUPOptimizeSpans(
+    const double *xs, const double *ys, const double *dx, const double *dy, Py_ssize_t count,
+    const unsigned char *forced, Py_ssize_t lookback, double tolerance, Py_ssize_t *costs, Py_ssize_t *chain);
+static int IUPSpanFits(
+    const double *xs, const double *ys, const double *dx, const double *dy, Py_ssize_t count,
+    Py_ssize_t i, Py_ssize_t j, double tolerance);
+static void InterpolateGap(
+    const double *coords, double *deltas, Py_ssize_t start, Py_ssize_t end, Py_ssize_t t1, Py_ssize_t t2);
+static void InterpolateUntouched(
+    const FMQuadGlyph *glyph, const FMIUPTuple *t, unsigned char *touched, double *dx, double *dy,
+    double *sumX, double *sumY);
+static int LoadIUPTuple(double scalar, PyObject *points, PyObject *xDeltas, PyObject *yDeltas, FMIUPTuple *t);
+static int LoadQuadGlyph(
+    PyObject *xs, PyObject *ys, PyObject *onCurve, PyObject *contourEnds, FMQuadGlyph *glyph);
+static PyObject *MakeArray(const char *typeCode, const void *v, Py_ssize_t byteCount);
 static FMSegment *MakeCSegments(PyObject *segments, Py_ssize_t segCount);
+static PyObject *PointBufferTuple(FMPointBuffer *buf, int roundResult);
+static int QuadBounds(const FMQuadGlyph *glyph, int tight, double *bounds);
+static void QuadPieceBounds(
+    double x0, double y0, double x1, double y1, double x2, double y2, double *bounds, int *found);
+static Py_ssize_t RowCount(double yMin, double yMax);
+static int RunBatch(FMBatch *batch, Py_ssize_t threadCount);
+static void RunExtremaJob(void *arg);
+static void RunIUPJob(void *arg);
+static double *SumIUPTuples(const FMQuadGlyph *glyph, const FMIUPTuple *tuples, Py_ssize_t tupleCount);
+static int SweepRows(
+    const FMSegment *segs, Py_ssize_t segCount, double yStart, Py_ssize_t rowCount,
+    double *lefts, double *rights);
+static void UnionPoint(double *bounds, double x, double y, int *found);
+static void UnpackSegments(const double *packed, Py_ssize_t segCount, FMSegment *walk);
 
+static PyObject *fm_CubicBounds(PyObject *self, PyObject *args);
 static PyObject *fm_FindLRExtrema(PyObject *self, PyObject *args);
+static PyObject *fm_FindLRExtremaBatch(PyObject *self, PyObject *args);
+static PyObject *fm_FlattenComposites(PyObject *self, PyObject *args);
+static PyObject *fm_InterpolateUntouched(PyObject *self, PyObject *args);
+static PyObject *fm_InterpolateUntouchedBatch(PyObject *self, PyObject *args);
+static PyObject *fm_OptimizeIUP(PyObject *self, PyObject *args);
+static PyObject *fm_QuadBounds(PyObject *self, PyObject *args);
+static PyObject *fm_QuadBoundsBatch(PyObject *self, PyObject *args);
 
 /* ------------------------------------------------------------------------ */
 
 /*** STATIC GLOBALS ***/
 
 static PyMethodDef UtilitiesMethods[] = {
+    {"fmCubicBounds", fm_CubicBounds, METH_VARARGS, NULL},
     {"fmFindLRExtrema", fm_FindLRExtrema, METH_VARARGS, NULL},
+    {"fmFindLRExtremaBatch", fm_FindLRExtremaBatch, METH_VARARGS, NULL},
+    {"fmFlattenComposites", fm_FlattenComposites, METH_VARARGS, NULL},
+    {"fmInterpolateUntouched", fm_InterpolateUntouched, METH_VARARGS, NULL},
+    {"fmInterpolateUntouchedBatch", fm_InterpolateUntouchedBatch, METH_VARARGS, NULL},
+    {"fmOptimizeIUP", fm_OptimizeIUP, METH_VARARGS, NULL},
+    {"fmQuadBounds", fm_QuadBounds, METH_VARARGS, NULL},
+    {"fmQuadBoundsBatch", fm_QuadBoundsBatch, METH_VARARGS, NULL},
     {NULL, NULL, 0, NULL}};
 
 /* ------------------------------------------------------------------------ */
 
 /*** PRIVATE PROCEDURES ***/
 
-static int FindSect(double y, FMSegment *walk, Py_ssize_t segCount, double *x1, double *x2)
+/* AppendSimple adds the points and contours of one packed simple glyph to
+   buf. Returns 0 on success, or -1 with an exception set. */
+
+static int AppendSimple(FMPointBuffer *buf, PyObject *packed)
+    {
+    FMQuadGlyph glyph;
+    Py_ssize_t  i, start = buf->pointCount;
+    PyObject    *contourEnds, *onCurve, *xs, *ys;
+    
+    require_noerr(!PyArg_ParseTuple(packed, "OOOO", &xs, &ys, &onCurve, &contourEnds), Err_BadReturn);
+    require_noerr(LoadQuadGlyph(xs, ys, onCurve, contourEnds, &glyph), Err_BadReturn);
+    require_noerr(GrowPointBuffer(buf, glyph.pointCount, glyph.contourCount), Err_FreeGlyph);
+    
+    for (i = 0; i < glyph.pointCount; i += 1)
+        {
+        buf->xs[start + i] = glyph.xs[i];
+        buf->ys[start + i] = glyph.ys[i];
+        buf->onCurve[start + i] = (glyph.onCurve[i] != 0.0);
+        }
+    
+    for (i = 0; i < glyph.contourCount; i += 1)
+        buf->contourEnds[buf->contourCount++] = (int) (start + glyph.contourEnds[i]);
+    
+    buf->pointCount += glyph.pointCount;
+    FreeQuadGlyph(&glyph);
+    return 0;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeGlyph:      FreeQuadGlyph(&glyph);
+    Err_BadReturn:      return -1;
+    }  /* AppendSimple */
+
+static void *BatchWorker(void *arg)
+    {
+    FMBatch     *batch = (FMBatch *) arg;
+    Py_ssize_t  i;
+    
+    for (;;)
+        {
+        pthread_mutex_lock(&batch->lock);
+        i = batch->nextJob++;
+        pthread_mutex_unlock(&batch->lock);
+        
+        if (i >= batch->jobCount)
+            break;
+        
+        batch->runJob((char *) batch->jobs + i * batch->jobSize);
+        }
+    
+    return NULL;
+    }  /* BatchWorker */
+
+static PyObject *BoundsTuple(const double *bounds, int found)
+    {
+    if (!found)
+        {
+        Py_INCREF(Py_None);
+        return Py_None;
+        }
+    
+    return Py_BuildValue("(dddd)", bounds[0], bounds[1], bounds[2], bounds[3]);
+    }  /* BoundsTuple */
+
+static int CompareEdges(const void *e1, const void *e2)
+    {
+    double  y1 = ((const FMEdge *) e1)->seg->yMin;
+    double  y2 = ((const FMEdge *) e2)->seg->yMin;
+    
+    return (y1 > y2) - (y1 < y2);
+    }  /* CompareEdges */
+
+static int CubicBounds(const double *segs, Py_ssize_t segCount, int tight, double *bounds)
     {
-    double  xMin = 100000.0;
-    double  xMax = -100000.0;
-    int     found = 0;
+    int found = 0;
     
     while (segCount--)
         {
-        if (y <= walk->yMax && y >= walk->yMin)
+        int i;
+        
+        for (i = 0; i < 8; i += 2)
             {
-            if (walk->isSpline)
+            if (tight && (i == 2 || i == 4))
+                continue;
+            
+            UnionPoint(bounds, segs[i], segs[i + 1], &found);
+            }
+        
+        if (tight)
+            {  /* roots of the derivative, done one axis at a time */
+            int axis;
+            
+            for (axis = 0; axis < 2; axis += 1)
                 {
-                double  a = walk->on1Y + walk->on2Y - 2.0 * walk->offY;
-                double  b = 2.0 * (walk->offY - walk->on1Y);
-                double  c = walk->on1Y - y;
+                double  p0 = segs[axis], p1 = segs[axis + 2], p2 = segs[axis + 4], p3 = segs[axis + 6];
+                double  a = 3.0 * (-p0 + 3.0 * p1 - 3.0 * p2 + p3);
+                double  b = 6.0 * (p0 - 2.0 * p1 + p2);
+                double  c = 3.0 * (p1 - p0);
+                double  t[2];
+                int     rootCount = 0, r;
+                
+                if (AE(a, 0.0))
+                    {
+                    if (!AE(b, 0.0))
+                        t[rootCount++] = -c / b;
+                    }
                 
-                if (a)
-                    {  /* full quadratic equation */
+                else
+                    {
                     double  det = b * b - 4.0 * a * c;
                     
-                    if (AE(det, 0.0))
-                        det = 0.0;
-                    
                     if (det >= 0.0)
                         {
-                        float   t1, t2;
-                        
                         det = sqrt(det);
-                        t1 = (-b + det) / (2.0 * a);
-                        t2 = (-b - det) / (2.0 * a);
-                        
-                        if (AE(t1, 0.0))
-                            t1 = 0.0;
-                        else if (AE(t1, 1.0))
-                            t1 = 1.0;
-                        
-                        if (AE(t2, 0.0))
-                            t2 = 0.0;
-                        else if (AE(t2, 1.0))
-                            t2 = 1.0;
-                        
-                        if (t1 >= 0.0 && t1 <= 1.0)
-                            {
-                            double  x = (1.0 - t1) * walk->on1X + t1 * walk->on2X;
-                            
-                            xMin = fmin(x, xMin);
-                            xMax = fmax(x, xMax);
-                            found = 1;
-                            }
-                        
-                        if (t2 >= 0.0 && t2 <= 1.0)
-                            {
-                            double  x = (1.0 - t2) * walk->on1X + t2 * walk->on2X;
-                            
-                            xMin = fmin(x, xMin);
-                            xMax = fmax(x, xMax);
-                            found = 1;
-                            }
+                        t[rootCount++] = (-b + det) / (2.0 * a);
+                        t[rootCount++] = (-b - det) / (2.0 * a);
                         }
                     }
                 
-                else
-                    {  /* bt + c = 0 */
-                    if (b)
-                        {
-                        double  t = -c / b;
-                        double  x = (1.0 - t) * walk->on1X + t * walk->on2X;
-                        
-                        xMin = fmin(x, xMin);
-                        xMax = fmax(x, xMax);
-                        found = 1;
-                        }
+                for (r = 0; r < rootCount; r += 1)
+                    {
+                    double  tt = t[r], mt = 1.0 - t[r];
+                    double  w0 = mt * mt * mt, w1 = 3.0 * mt * mt * tt, w2 = 3.0 * mt * tt * tt, w3 = tt * tt * tt;
                     
-                    else if (AE(y, 0.0))
-                        {  /* lines coincide */
-                        xMin = fmin(xMin, fmin(walk->on1X, walk->on2X));
-                        xMax = fmax(xMax, fmax(walk->on1X, walk->on2X));
-                        found = 1;
-                        }
+                    if (tt <= 0.0 || tt >= 1.0)
+                        continue;
+                    
+                    UnionPoint(
+                      bounds,
+                      w0 * segs[0] + w1 * segs[2] + w2 * segs[4] + w3 * segs[6],
+                      w0 * segs[1] + w1 * segs[3] + w2 * segs[5] + w3 * segs[7],
+                      &found);
                     }
                 }
+            }
         
-            else
+        segs += 8;
+        }
+    
+    return found;
+    }  /* CubicBounds */
+
+/* DeltaArrays returns a pair of array('d') made from the n x deltas and the
+   n y deltas that follow them in sums. */
+
+static PyObject *DeltaArrays(const double *sums, Py_ssize_t n)
+    {
+    PyObject    *retVal, *xs, *ys;
+    
+    xs = MakeArray("d", sums, n * (Py_ssize_t) sizeof(double));
+    require(xs, Err_BadReturn);
+    ys = MakeArray("d", sums + n, n * (Py_ssize_t) sizeof(double));
+    require(ys, Err_FreeXs);
+    retVal = PyTuple_Pack(2, xs, ys);
+    
+    Py_DECREF(ys);
+    Py_DECREF(xs);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeXs:         Py_DECREF(xs);
+    Err_BadReturn:      return NULL;
+    }  /* DeltaArrays */
+
+/* DoublesFromBuffer copies any buffer of native numbers (an array.array of
+   any numeric type, or bytes) into a newly allocated array of doubles, which
+   the caller frees with PyMem_Free. Returns NULL with an exception set on
+   failure. */
+
+static double *DoublesFromBuffer(PyObject *obj, Py_ssize_t *count)
+    {
+    char        fmt;
+    double      *retVal;
+    Py_buffer   view;
+    Py_ssize_t  i;
+    
+    require_noerr(PyObject_GetBuffer(obj, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS), Err_BadReturn);
+    fmt = (view.format == NULL ? 'B' : view.format[0]);
+    
+    if (fmt == '@' || fmt == '=')
+        fmt = view.format[1];
+    
+    *count = (view.itemsize ? view.len / view.itemsize : 0);
+    retVal = PyMem_Malloc((*count + 1) * sizeof(double));
+    require_action(retVal != NULL, Err_FreeView, PyErr_NoMemory(););
+    
+    for (i = 0; i < *count; i += 1)
+        {
+        const char  *p = (const char *) view.buf + i * view.itemsize;
+        
+        switch (fmt)
+            {
+            case 'b':   retVal[i] = *(const signed char *) p;           break;
+            case 'B':   retVal[i] = *(const unsigned char *) p;         break;
+            case 'h':   retVal[i] = *(const short *) p;                 break;
+            case 'H':   retVal[i] = *(const unsigned short *) p;        break;
+            case 'i':   retVal[i] = *(const int *) p;                   break;
+            case 'I':   retVal[i] = *(const unsigned int *) p;          break;
+            case 'l':   retVal[i] = *(const long *) p;                  break;
+            case 'L':   retVal[i] = *(const unsigned long *) p;         break;
+            case 'q':   retVal[i] = *(const long long *) p;             break;
+            case 'Q':   retVal[i] = *(const unsigned long long *) p;    break;
+            case 'f':   retVal[i] = *(const float *) p;                 break;
+            case 'd':   retVal[i] = *(const double *) p;                break;
+            
+            default:
+                PyErr_Format(PyExc_ValueError, "Unsupported buffer format '%s'!", view.format);
+                goto Err_FreeRetVal;
+            }
+        }
+    
+    PyBuffer_Release(&view);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeRetVal:     PyMem_Free(retVal);
+    Err_FreeView:       PyBuffer_Release(&view);
+    Err_BadReturn:      return NULL;
+    }  /* DoublesFromBuffer */
+
+static void EdgeSect(const FMEdge *edge, double y, double *xMin, double *xMax, int *found)
+    {
+    const FMSegment *seg = edge->seg;
+    
+    if (seg->isSpline)
+        {
+        double  a = edge->a;
+        double  b = edge->b;
+        
+        if (a)
+            {  /* full quadratic equation */
+            double  det = edge->det;
+            
+            if (AE(det, 0.0))
+                det = 0.0;
+            
+            if (det >= 0.0)
                 {
-                found = 1;
-                
-                if (AE(walk->yMax, walk->yMin))
-                    {  /* horizontal line at y */
-                    xMin = fmin(xMin, fmin(walk->on1X, walk->on2X));
-                    xMax = fmax(xMax, fmax(walk->on1X, walk->on2X));
-                    }
+                double  t[2];
+                int     i;
                 
-                else if (AE(walk->on1X, walk->on2X))
-                    {  /* vertical line */
-                    xMin = fmin(xMin, walk->on1X);
-                    xMax = fmax(xMax, walk->on1X);
-                    }
+                det = sqrt(det);
+                t[0] = (-b + det) / (2.0 * a);
+                t[1] = (-b - det) / (2.0 * a);
                 
-                else
-                    {  /* non-horizontal line intersecting y */
-                    double  t = (y - walk->on1Y) / (walk->on2Y - walk->on1Y);
-                    double  x = (1.0 - t) * walk->on1X + t * walk->on2X;
+                for (i = 0; i < 2; i += 1)
+                    {
+                    double  tt = t[i];
+                    
+                    if (AE(tt, 0.0))
+                        tt = 0.0;
+                    else if (AE(tt, 1.0))
+                        tt = 1.0;
                     
-                    xMin = fmin(x, xMin);
-                    xMax = fmax(x, xMax);
+                    if (tt >= 0.0 && tt <= 1.0)
+                        {
+                        double  x = (edge->ax * tt + edge->bx) * tt + seg->on1X;
+                        
+                        *xMin = fmin(x, *xMin);
+                        *xMax = fmax(x, *xMax);
+                        *found = 1;
+                        }
                     }
                 }
             }
         
-        walk += 1;
+        else if (b)
+            {  /* bt + c = 0 */
+            double  t = (y - seg->on1Y) / b;
+            double  x = (edge->ax * t + edge->bx) * t + seg->on1X;
+            
+            *xMin = fmin(x, *xMin);
+            *xMax = fmax(x, *xMax);
+            *found = 1;
+            }
+        
+        else if (AE(y, seg->on1Y))
+            {  /* lines coincide */
+            *xMin = fmin(*xMin, fmin(seg->on1X, fmin(seg->offX, seg->on2X)));
+            *xMax = fmax(*xMax, fmax(seg->on1X, fmax(seg->offX, seg->on2X)));
+            *found = 1;
+            }
         }
     
-    *x1 = xMin;
-    *x2 = xMax;
-    return found;
-    }  /* FindSect */
+    else
+        {
+        *found = 1;
+        
+        if (AE(seg->yMax, seg->yMin))
+            {  /* horizontal line at y */
+            *xMin = fmin(*xMin, fmin(seg->on1X, seg->on2X));
+            *xMax = fmax(*xMax, fmax(seg->on1X, seg->on2X));
+            }
+        
+        else
+            {  /* non-horizontal line intersecting y; vertical lines have zero slope */
+            double  x = seg->on1X + (y - seg->on1Y) * edge->slope;
+            
+            *xMin = fmin(x, *xMin);
+            *xMax = fmax(x, *xMax);
+            }
+        }
+    }  /* EdgeSect */
 
 static void FindYExtrema(FMSegment *walk, Py_ssize_t segCount, double *yMax, double *yMin)
     {
@@ -195,142 +601,1242 @@ static void FindYExtrema(FMSegment *walk, Py_ssize_t segCount, double *yMax, dou
     *yMin = lo;
     }  /* FindYExtrema */
 
-static FMSegment *MakeCSegments(PyObject *segments, Py_ssize_t segCount)
+/* FlattenComponents appends the points of each component in turn, each one
+   first flattened in its own coordinate space and then mapped into the
+   composite's space, either by the component's matrix or by matching the
+   compound and component anchor points. Compound anchors count from the
+   composite's own first point, which is wherever buf ended on entry (a
+   nested composite's points follow those of its parent's earlier
+   components). Returns 0 on success, 1 if the components cannot be
+   flattened (a missing glyph, a cycle or a bad anchor point), or -1 with an
+   exception set. */
+
+static int FlattenComponents(FMFlattenContext *ctx, PyObject *components, FMPointBuffer *buf)
     {
-    FMSegment   *retVal, *walk;
-    Py_ssize_t  i;
-    PyObject    *n, *seg;
+    double      a, b, c, d, dx, dy, x, y;
+    int         err = 0, roundToGrid;
+    long        glyphIndex;
+    Py_ssize_t  base = buf->pointCount, componentAnchor, compoundAnchor, count, i, j, start;
+    PyObject    *seq;
     
-    retVal = walk = PyMem_Calloc(segCount, sizeof(FMSegment));
-    require_action(retVal != NULL, Err_BadReturn, PyErr_NoMemory(););
+    seq = PySequence_Fast(components, "Components must be a sequence");
+    require(seq, Err_BadReturn);
+    count = PySequence_Fast_GET_SIZE(seq);
     
-    for (i = 0; i < segCount; i += 1)
+    for (i = 0; (i < count) && !err; i += 1)
         {
-        double  d;
-        int     isSpline;
+        err = !PyArg_ParseTuple(
+          PySequence_Fast_GET_ITEM(seq, i),
+          "lddddddnnp",
+          &glyphIndex, &a, &b, &c, &d, &dx, &dy, &compoundAnchor, &componentAnchor, &roundToGrid);
         
-        seg = PySequence_GetItem(segments, i);
-        require(seg != NULL, Err_FreeRetval);
+        require_noerr(err, Err_FreeSeq);
+        start = buf->pointCount;
+        err = FlattenGlyph(ctx, glyphIndex, buf);
         
-        n = PySequence_GetItem(seg, 0);
-        require(n != NULL, Err_FreeSeg);
-        d = PyFloat_AsDouble(n);
-        require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
-        isSpline = d;
-        Py_DECREF(n);
+        if (err)
+            break;
         
-        if (isSpline)
+        for (j = start; j < buf->pointCount; j += 1)
             {
-            walk->isSpline = 1.0;
-            
-            n = PySequence_GetItem(seg, 1);
-            require(n != NULL, Err_FreeSeg);
-            d = PyFloat_AsDouble(n);
-            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
-            walk->on1X = d;
-            Py_DECREF(n);
-            
-            n = PySequence_GetItem(seg, 2);
-            require(n != NULL, Err_FreeSeg);
-            d = PyFloat_AsDouble(n);
-            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
-            walk->on1Y = d;
-            Py_DECREF(n);
-            
-            n = PySequence_GetItem(seg, 3);
-            require(n != NULL, Err_FreeSeg);
-            d = PyFloat_AsDouble(n);
-            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
-            walk->offX = d;
-            Py_DECREF(n);
-            
-            n = PySequence_GetItem(seg, 4);
-            require(n != NULL, Err_FreeSeg);
-            d = PyFloat_AsDouble(n);
-            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
-            walk->offY = d;
-            Py_DECREF(n);
-            
-            n = PySequence_GetItem(seg, 5);
-            require(n != NULL, Err_FreeSeg);
-            d = PyFloat_AsDouble(n);
-            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
-            walk->on2X = d;
-            Py_DECREF(n);
-            
-            n = PySequence_GetItem(seg, 6);
-            require(n != NULL, Err_FreeSeg);
-            d = PyFloat_AsDouble(n);
-            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
-            walk->on2Y = d;
-            Py_DECREF(n);
-            
-            walk->yMin = fmin(walk->on1Y, fmin(walk->offY, walk->on2Y));
-            walk->yMax = fmax(walk->on1Y, fmax(walk->offY, walk->on2Y));
+            x = buf->xs[j];
+            y = buf->ys[j];
+            buf->xs[j] = x * a + y * c;
+            buf->ys[j] = x * b + y * d;
             }
         
-        else
+        if (compoundAnchor >= 0)
             {
-            walk->isSpline = 0.0;
-            
-            n = PySequence_GetItem(seg, 1);
-            require(n != NULL, Err_FreeSeg);
-            d = PyFloat_AsDouble(n);
-            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
-            walk->on1X = d;
-            Py_DECREF(n);
-            
-            n = PySequence_GetItem(seg, 2);
-            require(n != NULL, Err_FreeSeg);
-            d = PyFloat_AsDouble(n);
-            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
-            walk->on1Y = d;
-            Py_DECREF(n);
+            if ((compoundAnchor >= start - base) || (componentAnchor < 0) || (componentAnchor >= buf->pointCount - start))
+                err = 1;
             
-            n = PySequence_GetItem(seg, 3);
-            require(n != NULL, Err_FreeSeg);
-            d = PyFloat_AsDouble(n);
-            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
+            else
+                {
+                dx = buf->xs[base + compoundAnchor] - buf->xs[start + componentAnchor];
+                dy = buf->ys[base + compoundAnchor] - buf->ys[start + componentAnchor];
+                }
+            }
+        
+        else if (roundToGrid)
+            {
+            dx = round(dx);
+            dy = round(dy);
+            }
+        
+        for (j = start; (j < buf->pointCount) && !err; j += 1)
+            {
+            buf->xs[j] += dx;
+            buf->ys[j] += dy;
+            }
+        }
+    
+    Py_DECREF(seq);
+    return err;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeSeq:        Py_DECREF(seq);
+    Err_BadReturn:      return -1;
+    }  /* FlattenComponents */
+
+/* FlattenGlyph appends the outline of the specified glyph, fully resolved
+   and in its own coordinate space, to buf. Return values are as for
+   FlattenComponents. */
+
+static int FlattenGlyph(FMFlattenContext *ctx, long glyphIndex, FMPointBuffer *buf)
+    {
+    int         err, i;
+    PyObject    *key, *value;
+    
+    for (i = 0; i < ctx->depth; i += 1)
+        {
+        if (ctx->stack[i] == glyphIndex)
+            return 1;
+        }
+    
+    if (ctx->depth == MAX_COMPONENT_DEPTH)
+        return 1;
+    
+    key = PyLong_FromLong(glyphIndex);
+    require(key, Err_BadReturn);
+    value = PyDict_GetItemWithError(ctx->simples, key);  /* borrowed */
+    
+    if (value != NULL)
+        err = AppendSimple(buf, value);
+    
+    else if (!PyErr_Occurred())
+        {
+        value = PyDict_GetItemWithError(ctx->composites, key);  /* borrowed */
+        
+        if (value != NULL)
+            {
+            ctx->stack[ctx->depth++] = glyphIndex;
+            err = FlattenComponents(ctx, value, buf);
+            ctx->depth -= 1;
+            }
+        
+        else
+            err = (PyErr_Occurred() ? -1 : 1);
+        }
+    
+    else
+        err = -1;
+    
+    Py_DECREF(key);
+    return err;
+    
+    /*** ERROR HANDLERS ***/
+    Err_BadReturn:      return -1;
+    }  /* FlattenGlyph */
+
+static void FreeIUPJob(FMIUPJob *job)
+    {
+    Py_ssize_t  i;
+    
+    if (job->tuples != NULL)
+        {
+        for (i = 0; i < job->tupleCount; i += 1)
+            FreeIUPTuple(job->tuples + i);
+        
+        PyMem_Free(job->tuples);
+        }
+    
+    FreeQuadGlyph(&job->glyph);
+    PyMem_RawFree(job->sums);
+    job->tuples = NULL;
+    job->sums = NULL;
+    }  /* FreeIUPJob */
+
+static void FreeIUPTuple(FMIUPTuple *t)
+    {
+    PyMem_Free(t->points);
+    PyMem_Free(t->xDeltas);
+    PyMem_Free(t->yDeltas);
+    t->points = t->xDeltas = t->yDeltas = NULL;
+    }  /* FreeIUPTuple */
+
+static void FreePointBuffer(FMPointBuffer *buf)
+    {
+    PyMem_Free(buf->xs);
+    PyMem_Free(buf->ys);
+    PyMem_Free(buf->onCurve);
+    PyMem_Free(buf->contourEnds);
+    memset(buf, 0, sizeof(FMPointBuffer));
+    }  /* FreePointBuffer */
+
+static void FreeQuadGlyph(FMQuadGlyph *glyph)
+    {
+    PyMem_Free(glyph->xs);
+    PyMem_Free(glyph->ys);
+    PyMem_Free(glyph->onCurve);
+    PyMem_Free(glyph->contourEnds);
+    glyph->xs = glyph->ys = glyph->onCurve = glyph->contourEnds = NULL;
+    }  /* FreeQuadGlyph */
+
+static int GrowPointBuffer(FMPointBuffer *buf, Py_ssize_t extraPoints, Py_ssize_t extraContours)
+    {
+    void        *p;
+    Py_ssize_t  newCapacity;
+    
+    if (buf->pointCount + extraPoints > buf->pointCapacity)
+        {
+        newCapacity = 2 * buf->pointCapacity + extraPoints + 64;
+        p = PyMem_Realloc(buf->xs, newCapacity * sizeof(double));
+        require(p != NULL, Err_NoMemory);
+        buf->xs = p;
+        p = PyMem_Realloc(buf->ys, newCapacity * sizeof(double));
+        require(p != NULL, Err_NoMemory);
+        buf->ys = p;
+        p = PyMem_Realloc(buf->onCurve, newCapacity);
+        require(p != NULL, Err_NoMemory);
+        buf->onCurve = p;
+        buf->pointCapacity = newCapacity;
+        }
+    
+    if (buf->contourCount + extraContours > buf->contourCapacity)
+        {
+        newCapacity = 2 * buf->contourCapacity + extraContours + 8;
+        p = PyMem_Realloc(buf->contourEnds, newCapacity * sizeof(int));
+        require(p != NULL, Err_NoMemory);
+        buf->contourEnds = p;
+        buf->contourCapacity = newCapacity;
+        }
+    
+    return 0;
+    
+    /*** ERROR HANDLERS ***/
+    Err_NoMemory:       PyErr_NoMemory();
+                        return -1;
+    }  /* GrowPointBuffer */
+
+/* IUPForcedPoints sets forced[i] for each of the m points of a contour whose
+   delta could never be inferred to within tolerance, whatever references
+   were kept, judging only from its two neighbours (see the fontTools
+   iup_contour_bound_forced_set). Returns the largest forced index, or -1 if
+   none are forced. */
+
+static Py_ssize_t IUPForcedPoints(
+    const double *xs, const double *ys, const double *dx, const double *dy, Py_ssize_t m,
+    double tolerance, unsigned char *forced)
+    {
+    double      c, c1, c2, d, d1, d2;
+    int         axis, force;
+    Py_ssize_t  i, last = -1, p, q;
+    
+    for (i = 0; i < m; i += 1)
+        {
+        forced[i] = 0;
+        p = (i ? i - 1 : m - 1);
+        q = (i == m - 1 ? 0 : i + 1);
+        
+        for (axis = 0; (axis < 2) && !forced[i]; axis += 1)
+            {
+            const double    *coords = (axis ? ys : xs), *deltas = (axis ? dy : dx);
+            
+            c = coords[i];
+            d = deltas[i];
+            
+            if (coords[p] <= coords[q])
+                c1 = coords[p], d1 = deltas[p], c2 = coords[q], d2 = deltas[q];
+            else
+                c1 = coords[q], d1 = deltas[q], c2 = coords[p], d2 = deltas[p];
+            
+            if (c1 == c2)
+                force = (fabs(d1 - d2) > tolerance) && (fabs(d) > tolerance);
+            else if ((c1 <= c) && (c <= c2))
+                force = (d < fmin(d1, d2) - tolerance) || (d > fmax(d1, d2) + tolerance);
+            else if (d1 == d2)
+                force = 0;
+            else if (c < c1)
+                force = (fabs(d) > tolerance) && (fabs(d - d1) > tolerance) && ((d - tolerance < d1) != (d1 < d2));
+            else
+                force = (fabs(d) > tolerance) && (fabs(d - d2) > tolerance) && ((d2 < d + tolerance) != (d1 < d2));
+            
+            if (force)
+                {
+                forced[i] = 1;
+                last = i;
+                }
+            }
+        }
+    
+    return last;
+    }  /* IUPForcedPoints */
+
+/* IUPOptimizeContour sets keep[i] for each of the m points of one contour
+   whose delta has to be stored explicitly so that IUP reproduces all the
+   others to within tolerance. A contour with no forced points is solved
+   doubled, so the best starting point can be chosen; otherwise it is
+   rotated so a forced point comes last. Since IUPSpanFits rounds what it
+   infers, a point is only forced if it misses by more than tolerance + 0.5.
+   Returns 0 on success, or -1 with an exception set. */
+
+static int IUPOptimizeContour(
+    const double *xs, const double *ys, const double *dx, const double *dy, Py_ssize_t m,
+    double tolerance, unsigned char *keep)
+    {
+    double          *wdx, *wdy, *work, *wx, *wy;
+    Py_ssize_t      best, *chain, *costs, i, k, last, start;
+    unsigned char   *forced, *trial;
+    
+    memset(keep, 0, m);
+    
+    for (i = 0; (i < m) && (hypot(dx[i], dy[i]) <= tolerance); i += 1)
+        ;
+    
+    if (i == m)
+        return 0;
+    
+    for (i = 1; (i < m) && (hypot(dx[i] - dx[0], dy[i] - dy[0]) <= tolerance); i += 1)
+        ;
+    
+    if (i == m)
+        {
+        keep[0] = 1;  /* one touched point moves the whole contour */
+        return 0;
+        }
+    
+    /* one block holds the doubled contour, the DP costs and chain, and the flags */
+    work = PyMem_Malloc(8 * m * sizeof(double) + 2 * (2 * m + 1) * sizeof(Py_ssize_t) + 2 * m);
+    require_action(work != NULL, Err_BadReturn, PyErr_NoMemory(););
+    wx = work;
+    wy = wx + 2 * m;
+    wdx = wy + 2 * m;
+    wdy = wdx + 2 * m;
+    costs = (Py_ssize_t *) (wdy + 2 * m);
+    chain = costs + 2 * m + 1;
+    forced = (unsigned char *) (chain + 2 * m + 1);
+    trial = forced + m;
+    last = IUPForcedPoints(xs, ys, dx, dy, m, tolerance + 0.5, forced);
+    
+    if (last >= 0)
+        {
+        k = m - 1 - last;
+        
+        for (i = 0; i < m; i += 1)
+            {
+            start = (i + k) % m;
+            wx[start] = xs[i];
+            wy[start] = ys[i];
+            wdx[start] = dx[i];
+            wdy[start] = dy[i];
+            trial[start] = forced[i];
+            }
+        
+        IUPOptimizeSpans(wx, wy, wdx, wdy, m, trial, m, tolerance, costs, chain);
+        
+        for (i = m - 1; i >= 0; i = chain[i + 1])
+            keep[(i + m - k) % m] = 1;
+        }
+    
+    else
+        {
+        for (i = 0; i < 2 * m; i += 1)
+            {
+            wx[i] = xs[i % m];
+            wy[i] = ys[i % m];
+            wdx[i] = dx[i % m];
+            wdy[i] = dy[i % m];
+            }
+        
+        IUPOptimizeSpans(wx, wy, wdx, wdy, 2 * m, NULL, m, tolerance, costs, chain);
+        memset(keep, 1, m);
+        best = m + 1;
+        
+        for (start = m - 1; start < 2 * m; start += 1)
+            {
+            memset(trial, 0, m);
+            
+            for (i = start; i > start - m; i = chain[i + 1])
+                trial[i % m] = 1;
+            
+            if ((i == start - m) && (costs[start + 1] - costs[i + 1] <= best))
+                {
+                best = costs[start + 1] - costs[i + 1];
+                memcpy(keep, trial, m);
+                }
+            }
+        }
+    
+    PyMem_Free(work);
+    return 0;
+    
+    /*** ERROR HANDLERS ***/
+    Err_BadReturn:      return -1;
+    }  /* IUPOptimizeContour */
+
+/* IUPOptimizeSpans is the dynamic program behind IUPOptimizeContour. For
+   each point i of the count points it finds the cheapest way to reach it
+   with i kept, recording the cost in costs[i + 1] and the previous kept
+   point in chain[i + 1] (entry 0 stands for "before the start", index -1).
+   A kept point may skip back over at most lookback points, and never past
+   a forced one (forced may be NULL). */
+
+static void IUPOptimizeSpans(
+    const double *xs, const double *ys, const double *dx, const double *dy, Py_ssize_t count,
+    const unsigned char *forced, Py_ssize_t lookback, double tolerance, Py_ssize_t *costs, Py_ssize_t *chain)
+    {
+    Py_ssize_t  best, i, j, low;
+    
+    costs[0] = 0;
+    chain[0] = -1;
+    
+    if (lookback > MAX_IUP_LOOKBACK)
+        lookback = MAX_IUP_LOOKBACK;
+    
+    for (i = 0; i < count; i += 1)
+        {
+        best = costs[i] + 1;
+        costs[i + 1] = best;
+        chain[i + 1] = i - 1;
+        
+        if (forced && (i > 0) && forced[i - 1])
+            continue;
+        
+        low = (i - lookback > -2 ? i - lookback : -2);
+        
+        for (j = i - 2; j > low; j -= 1)
+            {
+            if ((costs[j + 1] + 1 < best) && IUPSpanFits(xs, ys, dx, dy, count, j, i, tolerance))
+                {
+                best = costs[j + 1] + 1;
+                costs[i + 1] = best;
+                chain[i + 1] = j;
+                }
+            
+            if (forced && (j >= 0) && forced[j])
+                break;
+            }
+        }
+    }  /* IUPOptimizeSpans */
+
+/* IUPSpanFits returns nonzero if the deltas of the points strictly between
+   i and j can all be inferred from those of i and j to within tolerance (an
+   i of -1 stands for the last point). The inferred deltas are rounded to
+   integers before they are compared, just as they will be when stored, so
+   the tolerance holds for the rounded values too. Decoders differ on what to infer when
+   the two reference coordinates are equal on an axis but the deltas are
+   not, so such a span never fits. */
+
+static int IUPSpanFits(
+    const double *xs, const double *ys, const double *dx, const double *dy, Py_ssize_t count,
+    Py_ssize_t i, Py_ssize_t j, double tolerance)
+    {
+    double      c, c1, c2, d1, d2, inferred[2], temp;
+    int         axis;
+    Py_ssize_t  first = (i < 0 ? i + count : i), k;
+    
+    for (k = i + 1; k < j; k += 1)
+        {
+        for (axis = 0; axis < 2; axis += 1)
+            {
+            const double    *coords = (axis ? ys : xs), *deltas = (axis ? dy : dx);
+            
+            c = coords[k];
+            c1 = coords[first];
+            c2 = coords[j];
+            d1 = deltas[first];
+            d2 = deltas[j];
+            
+            if (c1 > c2)
+                {
+                temp = c1, c1 = c2, c2 = temp;
+                temp = d1, d1 = d2, d2 = temp;
+                }
+            
+            if (c1 == c2)
+                {
+                if (d1 != d2)
+                    return 0;
+                
+                inferred[axis] = d1;
+                }
+            
+            else if (c <= c1)
+                inferred[axis] = d1;
+            else if (c >= c2)
+                inferred[axis] = d2;
+            else
+                inferred[axis] = d1 + (c - c1) / (c2 - c1) * (d2 - d1);
+            }
+        
+        if (hypot(nearbyint(inferred[0]) - dx[k], nearbyint(inferred[1]) - dy[k]) > tolerance)
+            return 0;
+        }
+    
+    return 1;
+    }  /* IUPSpanFits */
+
+/* InterpolateGap fills in the deltas for the untouched points strictly
+   between the touched points t1 and t2 of the contour running from start to
+   end (inclusive), wrapping around the end of the contour as needed. Points
+   whose coordinate lies between those of t1 and t2 are interpolated (or get
+   the average of the two deltas, if t1 and t2 have the same coordinate); the
+   rest take the delta of whichever of the two is nearer. */
+
+static void InterpolateGap(
+    const double *coords, double *deltas, Py_ssize_t start, Py_ssize_t end, Py_ssize_t t1, Py_ssize_t t2)
+    {
+    double      c, c1 = coords[t1], c2 = coords[t2], d1 = deltas[t1], d2 = deltas[t2], temp;
+    Py_ssize_t  i;
+    
+    if (c1 > c2)
+        {
+        temp = c1, c1 = c2, c2 = temp;
+        temp = d1, d1 = d2, d2 = temp;
+        }
+    
+    for (i = (t1 == end ? start : t1 + 1); i != t2; i = (i == end ? start : i + 1))
+        {
+        c = coords[i];
+        
+        if ((c1 <= c) && (c <= c2))
+            deltas[i] = (c1 == c2 ? (d1 + d2) / 2 : d1 + (c - c1) / (c2 - c1) * (d2 - d1));
+        else if (fabs(c1 - c) < fabs(c2 - c))
+            deltas[i] = d1;
+        else
+            deltas[i] = d2;
+        }
+    }  /* InterpolateGap */
+
+/* InterpolateUntouched computes the full x and y deltas for one tuple into
+   dx and dy (pointCount + 4 entries each), inferring the deltas of untouched
+   points contour by contour, and adds them into sumX and sumY. Contours with
+   no touched points get no deltas; the phantom points only get explicit
+   ones. Point indices past the phantom points are ignored. touched is
+   scratch space for pointCount + 4 flags. */
+
+static void InterpolateUntouched(
+    const FMQuadGlyph *glyph, const FMIUPTuple *t, unsigned char *touched, double *dx, double *dy,
+    double *sumX, double *sumY)
+    {
+    Py_ssize_t  c, end, first, i, n = glyph->pointCount + 4, p, start, t1, t2;
+    
+    for (i = 0; i < n; i += 1)
+        {
+        touched[i] = 0;
+        dx[i] = dy[i] = 0.0;
+        }
+    
+    for (i = 0; i < t->count; i += 1)
+        {
+        p = (Py_ssize_t) t->points[i];
+        
+        if ((p < 0) || (p >= n))
+            continue;
+        
+        touched[p] = 1;
+        dx[p] = t->scalar * t->xDeltas[i];
+        dy[p] = t->scalar * t->yDeltas[i];
+        }
+    
+    for (c = 0, start = 0; c < glyph->contourCount; c += 1, start = end + 1)
+        {
+        end = (Py_ssize_t) glyph->contourEnds[c];
+        
+        for (first = start; (first <= end) && !touched[first]; first += 1)
+            ;
+        
+        if (first > end)
+            continue;
+        
+        t1 = first;
+        
+        do
+            {
+            for (t2 = (t1 == end ? start : t1 + 1); !touched[t2]; t2 = (t2 == end ? start : t2 + 1))
+                ;
+            
+            InterpolateGap(glyph->xs, dx, start, end, t1, t2);
+            InterpolateGap(glyph->ys, dy, start, end, t1, t2);
+            t1 = t2;
+            } while (t1 != first);
+        }
+    
+    for (i = 0; i < n; i += 1)
+        {
+        sumX[i] += dx[i];
+        sumY[i] += dy[i];
+        }
+    }  /* InterpolateUntouched */
+
+/* LoadIUPTuple fills in t from the three numeric buffers points, xDeltas and
+   yDeltas, which must all be the same length. Returns 0 on success, or
+   nonzero with an exception set. */
+
+static int LoadIUPTuple(double scalar, PyObject *points, PyObject *xDeltas, PyObject *yDeltas, FMIUPTuple *t)
+    {
+    Py_ssize_t  n;
+    
+    memset(t, 0, sizeof(FMIUPTuple));
+    t->scalar = scalar;
+    t->points = DoublesFromBuffer(points, &t->count);
+    require(t->points != NULL, Err_FreeTuple);
+    t->xDeltas = DoublesFromBuffer(xDeltas, &n);
+    require(t->xDeltas != NULL, Err_FreeTuple);
+    require(n == t->count, Err_BadLengths);
+    t->yDeltas = DoublesFromBuffer(yDeltas, &n);
+    require(t->yDeltas != NULL, Err_FreeTuple);
+    require(n == t->count, Err_BadLengths);
+    return 0;
+    
+    /*** ERROR HANDLERS ***/
+    Err_BadLengths:     PyErr_SetString(PyExc_ValueError, "Point and delta arrays have different lengths!");
+    Err_FreeTuple:      FreeIUPTuple(t);
+                        return 1;
+    }  /* LoadIUPTuple */
+
+static int LoadQuadGlyph(
+    PyObject *xs, PyObject *ys, PyObject *onCurve, PyObject *contourEnds, FMQuadGlyph *glyph)
+    {
+    Py_ssize_t  i, n;
+    
+    memset(glyph, 0, sizeof(FMQuadGlyph));
+    glyph->xs = DoublesFromBuffer(xs, &glyph->pointCount);
+    require(glyph->xs != NULL, Err_FreeGlyph);
+    glyph->ys = DoublesFromBuffer(ys, &n);
+    require(glyph->ys != NULL, Err_FreeGlyph);
+    require(n == glyph->pointCount, Err_BadLengths);
+    glyph->onCurve = DoublesFromBuffer(onCurve, &n);
+    require(glyph->onCurve != NULL, Err_FreeGlyph);
+    require(n == glyph->pointCount, Err_BadLengths);
+    glyph->contourEnds = DoublesFromBuffer(contourEnds, &glyph->contourCount);
+    require(glyph->contourEnds != NULL, Err_FreeGlyph);
+    
+    for (i = 0; i < glyph->contourCount; i += 1)
+        {
+        require(glyph->contourEnds[i] >= 0, Err_BadEnds);
+        require(glyph->contourEnds[i] < glyph->pointCount, Err_BadEnds);
+        require(!i || glyph->contourEnds[i] >= glyph->contourEnds[i - 1], Err_BadEnds);
+        }
+    
+    return 0;
+    
+    /*** ERROR HANDLERS ***/
+    Err_BadEnds:        PyErr_SetString(PyExc_ValueError, "Contour end indices are out of order or out of range!");
+                        goto Err_FreeGlyph;
+    Err_BadLengths:     PyErr_SetString(PyExc_ValueError, "Point arrays have different lengths!");
+    Err_FreeGlyph:      FreeQuadGlyph(glyph);
+                        return 1;
+    }  /* LoadQuadGlyph */
+
+/* MakeArray returns a new array.array of the given type code holding a copy
+   of byteCount bytes from v. */
+
+static PyObject *MakeArray(const char *typeCode, const void *v, Py_ssize_t byteCount)
+    {
+    PyObject    *arrayModule, *bytes, *retVal;
+    
+    arrayModule = PyImport_ImportModule("array");
+    require(arrayModule, Err_BadReturn);
+    bytes = PyBytes_FromStringAndSize((const char *) v, byteCount);
+    require(bytes, Err_FreeModule);
+    retVal = PyObject_CallMethod(arrayModule, "array", "sO", typeCode, bytes);
+    require(retVal, Err_FreeBytes);
+    
+    Py_DECREF(bytes);
+    Py_DECREF(arrayModule);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeBytes:      Py_DECREF(bytes);
+    Err_FreeModule:     Py_DECREF(arrayModule);
+    Err_BadReturn:      return NULL;
+    }  /* MakeArray */
+
+static FMSegment *MakeCSegments(PyObject *segments, Py_ssize_t segCount)
+    {
+    FMSegment   *retVal, *walk;
+    Py_ssize_t  i;
+    PyObject    *n, *seg;
+    
+    retVal = walk = PyMem_Calloc(segCount, sizeof(FMSegment));
+    require_action(retVal != NULL, Err_BadReturn, PyErr_NoMemory(););
+    
+    for (i = 0; i < segCount; i += 1)
+        {
+        double  d;
+        int     isSpline;
+        
+        seg = PySequence_GetItem(segments, i);
+        require(seg != NULL, Err_FreeRetval);
+        
+        n = PySequence_GetItem(seg, 0);
+        require(n != NULL, Err_FreeSeg);
+        d = PyFloat_AsDouble(n);
+        require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
+        isSpline = d;
+        Py_DECREF(n);
+        
+        if (isSpline)
+            {
+            walk->isSpline = 1.0;
+            
+            n = PySequence_GetItem(seg, 1);
+            require(n != NULL, Err_FreeSeg);
+            d = PyFloat_AsDouble(n);
+            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
+            walk->on1X = d;
+            Py_DECREF(n);
+            
+            n = PySequence_GetItem(seg, 2);
+            require(n != NULL, Err_FreeSeg);
+            d = PyFloat_AsDouble(n);
+            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
+            walk->on1Y = d;
+            Py_DECREF(n);
+            
+            n = PySequence_GetItem(seg, 3);
+            require(n != NULL, Err_FreeSeg);
+            d = PyFloat_AsDouble(n);
+            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
+            walk->offX = d;
+            Py_DECREF(n);
+            
+            n = PySequence_GetItem(seg, 4);
+            require(n != NULL, Err_FreeSeg);
+            d = PyFloat_AsDouble(n);
+            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
+            walk->offY = d;
+            Py_DECREF(n);
+            
+            n = PySequence_GetItem(seg, 5);
+            require(n != NULL, Err_FreeSeg);
+            d = PyFloat_AsDouble(n);
+            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
             walk->on2X = d;
             Py_DECREF(n);
             
-            n = PySequence_GetItem(seg, 4);
-            require(n != NULL, Err_FreeSeg);
-            d = PyFloat_AsDouble(n);
-            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
-            walk->on2Y = d;
-            Py_DECREF(n);
+            n = PySequence_GetItem(seg, 6);
+            require(n != NULL, Err_FreeSeg);
+            d = PyFloat_AsDouble(n);
+            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
+            walk->on2Y = d;
+            Py_DECREF(n);
+            
+            walk->yMin = fmin(walk->on1Y, fmin(walk->offY, walk->on2Y));
+            walk->yMax = fmax(walk->on1Y, fmax(walk->offY, walk->on2Y));
+            }
+        
+        else
+            {
+            walk->isSpline = 0.0;
+            
+            n = PySequence_GetItem(seg, 1);
+            require(n != NULL, Err_FreeSeg);
+            d = PyFloat_AsDouble(n);
+            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
+            walk->on1X = d;
+            Py_DECREF(n);
+            
+            n = PySequence_GetItem(seg, 2);
+            require(n != NULL, Err_FreeSeg);
+            d = PyFloat_AsDouble(n);
+            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
+            walk->on1Y = d;
+            Py_DECREF(n);
+            
+            n = PySequence_GetItem(seg, 3);
+            require(n != NULL, Err_FreeSeg);
+            d = PyFloat_AsDouble(n);
+            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
+            walk->on2X = d;
+            Py_DECREF(n);
+            
+            n = PySequence_GetItem(seg, 4);
+            require(n != NULL, Err_FreeSeg);
+            d = PyFloat_AsDouble(n);
+            require(d != -1.0 || PyErr_Occurred() == NULL, Err_FreeN);
+            walk->on2Y = d;
+            Py_DECREF(n);
+            
+            walk->yMin = fmin(walk->on1Y, walk->on2Y);
+            walk->yMax = fmax(walk->on1Y, walk->on2Y);
+            }
+        
+        Py_DECREF(seg);
+        walk += 1;
+        }
+    
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeN:          Py_DECREF(n);
+    Err_FreeSeg:        Py_DECREF(seg);
+    Err_FreeRetval:     PyMem_Free(retVal);
+    Err_BadReturn:      return NULL;
+    }  /* MakeCSegments */
+
+/* PointBufferTuple returns (xs, ys, onCurve, contourEnds) for buf, in the
+   same form as TTContours.packedArrays produces. If roundResult is set the
+   coordinates are rounded half away from zero, as TTPoint does. */
+
+static PyObject *PointBufferTuple(FMPointBuffer *buf, int roundResult)
+    {
+    Py_ssize_t  i;
+    PyObject    *contourEnds, *onCurve, *retVal, *xs, *ys;
+    
+    if (roundResult)
+        {
+        for (i = 0; i < buf->pointCount; i += 1)
+            {
+            buf->xs[i] = round(buf->xs[i]);
+            buf->ys[i] = round(buf->ys[i]);
+            }
+        }
+    
+    xs = MakeArray("d", buf->xs, buf->pointCount * (Py_ssize_t) sizeof(double));
+    require(xs, Err_BadReturn);
+    ys = MakeArray("d", buf->ys, buf->pointCount * (Py_ssize_t) sizeof(double));
+    require(ys, Err_FreeXs);
+    onCurve = PyBytes_FromStringAndSize((const char *) buf->onCurve, buf->pointCount);
+    require(onCurve, Err_FreeYs);
+    contourEnds = MakeArray("i", buf->contourEnds, buf->contourCount * (Py_ssize_t) sizeof(int));
+    require(contourEnds, Err_FreeOnCurve);
+    retVal = PyTuple_Pack(4, xs, ys, onCurve, contourEnds);
+    
+    Py_DECREF(contourEnds);
+    Py_DECREF(onCurve);
+    Py_DECREF(ys);
+    Py_DECREF(xs);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeOnCurve:    Py_DECREF(onCurve);
+    Err_FreeYs:         Py_DECREF(ys);
+    Err_FreeXs:         Py_DECREF(xs);
+    Err_BadReturn:      return NULL;
+    }  /* PointBufferTuple */
+
+/* QuadBounds accumulates the glyph's bounds into bounds (xMin, yMin, xMax,
+   yMax). Without tight, these are the extrema of all the points, as
+   TTBounds.fromcontours computes them; with tight, only on-curve points and
+   the actual extrema of each quadratic piece are used. */
+
+static int QuadBounds(const FMQuadGlyph *glyph, int tight, double *bounds)
+    {
+    Py_ssize_t  c, first = 0, i, k, n;
+    int         found = 0;
+    
+    if (!tight)
+        {
+        for (i = 0; i < glyph->pointCount; i += 1)
+            UnionPoint(bounds, glyph->xs[i], glyph->ys[i], &found);
+        
+        return found;
+        }
+    
+    for (c = 0; c < glyph->contourCount; c += 1, first += n)
+        {
+        double      prevOnX, prevOnY, prevOffX = 0.0, prevOffY = 0.0;
+        int         havePrevOff = 0;
+        Py_ssize_t  last, start;
+        
+        n = (Py_ssize_t) glyph->contourEnds[c] + 1 - first;
+        
+        if (n < 1)
+            {
+            n = 0;
+            continue;
+            }
+        
+        for (start = 0; start < n && !glyph->onCurve[first + start]; start += 1)
+            ;
+        
+        if (start == n)
+            {  /* all off-curve: begin at the implied point before point 0 */
+            start = 0;
+            prevOnX = (glyph->xs[first + n - 1] + glyph->xs[first]) / 2.0;
+            prevOnY = (glyph->ys[first + n - 1] + glyph->ys[first]) / 2.0;
+            k = 0;
+            last = n - 1;
+            }
+        
+        else
+            {
+            prevOnX = glyph->xs[first + start];
+            prevOnY = glyph->ys[first + start];
+            k = 1;
+            last = n;
+            }
+        
+        UnionPoint(bounds, prevOnX, prevOnY, &found);
+        
+        for ( ; k <= last; k += 1)
+            {
+            Py_ssize_t  j = first + (start + k) % n;
+            double      x = glyph->xs[j], y = glyph->ys[j];
+            
+            if (!glyph->onCurve[j])
+                {
+                if (havePrevOff)
+                    {
+                    double  mx = (prevOffX + x) / 2.0, my = (prevOffY + y) / 2.0;
+                    
+                    QuadPieceBounds(prevOnX, prevOnY, prevOffX, prevOffY, mx, my, bounds, &found);
+                    prevOnX = mx;
+                    prevOnY = my;
+                    }
+                
+                prevOffX = x;
+                prevOffY = y;
+                havePrevOff = 1;
+                }
+            
+            else
+                {
+                if (havePrevOff)
+                    QuadPieceBounds(prevOnX, prevOnY, prevOffX, prevOffY, x, y, bounds, &found);
+                else
+                    UnionPoint(bounds, x, y, &found);
+                
+                prevOnX = x;
+                prevOnY = y;
+                havePrevOff = 0;
+                }
+            }
+        
+        if (havePrevOff)
+            {  /* all off-curve contour: close back to the starting implied point */
+            double  mx = (prevOffX + glyph->xs[first]) / 2.0, my = (prevOffY + glyph->ys[first]) / 2.0;
+            
+            QuadPieceBounds(prevOnX, prevOnY, prevOffX, prevOffY, mx, my, bounds, &found);
+            }
+        }
+    
+    return found;
+    }  /* QuadBounds */
+
+static void QuadPieceBounds(
+    double x0, double y0, double x1, double y1, double x2, double y2, double *bounds, int *found)
+    {
+    double  dx = x0 - 2.0 * x1 + x2;
+    double  dy = y0 - 2.0 * y1 + y2;
+    double  t;
+    
+    UnionPoint(bounds, x0, y0, found);
+    UnionPoint(bounds, x2, y2, found);
+    
+    if (!AE(dx, 0.0))
+        {
+        t = (x0 - x1) / dx;
+        
+        if (t > 0.0 && t < 1.0)
+            UnionPoint(
+              bounds,
+              (1.0 - t) * (1.0 - t) * x0 + 2.0 * t * (1.0 - t) * x1 + t * t * x2,
+              (1.0 - t) * (1.0 - t) * y0 + 2.0 * t * (1.0 - t) * y1 + t * t * y2,
+              found);
+        }
+    
+    if (!AE(dy, 0.0))
+        {
+        t = (y0 - y1) / dy;
+        
+        if (t > 0.0 && t < 1.0)
+            UnionPoint(
+              bounds,
+              (1.0 - t) * (1.0 - t) * x0 + 2.0 * t * (1.0 - t) * x1 + t * t * x2,
+              (1.0 - t) * (1.0 - t) * y0 + 2.0 * t * (1.0 - t) * y1 + t * t * y2,
+              found);
+        }
+    }  /* QuadPieceBounds */
+
+static Py_ssize_t RowCount(double yMin, double yMax)
+    {
+    if (yMax < yMin)
+        return 0;
+    
+    return (Py_ssize_t) floor(yMax - yMin) + 1;
+    }  /* RowCount */
+
+/* RunBatch hands the jobs in batch out to threadCount native threads (0 means
+   one per online CPU), the calling thread among them, and waits for them all
+   to finish. The GIL is released meanwhile, so batch->runJob must not touch
+   any Python objects. Returns nonzero with an exception set if the threads
+   could not be coordinated. */
+
+static int RunBatch(FMBatch *batch, Py_ssize_t threadCount)
+    {
+    Py_ssize_t  i;
+    pthread_t   threads[MAX_BATCH_THREADS];
+    int         startedCount = 0;
+    
+    if (threadCount <= 0)
+        threadCount = (Py_ssize_t) sysconf(_SC_NPROCESSORS_ONLN);
+    if (threadCount > MAX_BATCH_THREADS)
+        threadCount = MAX_BATCH_THREADS;
+    if (threadCount > batch->jobCount)
+        threadCount = batch->jobCount;
+    
+    batch->nextJob = 0;
+    require_action(!pthread_mutex_init(&batch->lock, NULL), Err_BadReturn, PyErr_SetString(PyExc_RuntimeError, "Unable to create batch lock!"););
+    
+    Py_BEGIN_ALLOW_THREADS
+    
+    for (i = 1; i < threadCount; i += 1)
+        {
+        if (pthread_create(threads + startedCount, NULL, BatchWorker, batch))
+            break;
+        
+        startedCount += 1;
+        }
+    
+    BatchWorker(batch);  /* the calling thread takes part too */
+    
+    for (i = 0; i < startedCount; i += 1)
+        pthread_join(threads[i], NULL);
+    
+    Py_END_ALLOW_THREADS
+    
+    pthread_mutex_destroy(&batch->lock);
+    return 0;
+    
+    /*** ERROR HANDLERS ***/
+    Err_BadReturn:      return -1;
+    }  /* RunBatch */
+
+/* RunExtremaJob runs one fmFindLRExtremaBatch job. It is called on a worker
+   thread without the GIL, so it only uses the raw allocator. */
+
+static void RunExtremaJob(void *arg)
+    {
+    double      yMax;
+    FMBatchJob  *job = (FMBatchJob *) arg;
+    FMSegment   *segs;
+    
+    segs = PyMem_RawMalloc((job->segCount ? job->segCount : 1) * sizeof(FMSegment));
+    require(segs != NULL, Err_Failed);
+    UnpackSegments(job->packed, job->segCount, segs);
+    FindYExtrema(segs, job->segCount, &yMax, &job->yMin);
+    job->rowCount = RowCount(job->yMin, yMax);
+    job->rows = PyMem_RawMalloc((2 * job->rowCount + 1) * sizeof(double));
+    require(job->rows != NULL, Err_FreeSegs);
+    require(!SweepRows(segs, job->segCount, job->yMin, job->rowCount, job->rows, job->rows + job->rowCount), Err_FreeRows);
+    
+    PyMem_RawFree(segs);
+    return;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeRows:       PyMem_RawFree(job->rows);
+                        job->rows = NULL;
+    Err_FreeSegs:       PyMem_RawFree(segs);
+    Err_Failed:         job->failed = 1;
+    }  /* RunExtremaJob */
+
+/* RunIUPJob sums the tuple deltas for one fmInterpolateUntouchedBatch job.
+   Like RunExtremaJob, it runs without the GIL. */
+
+static void RunIUPJob(void *arg)
+    {
+    FMIUPJob    *job = (FMIUPJob *) arg;
+    
+    job->sums = SumIUPTuples(&job->glyph, job->tuples, job->tupleCount);
+    job->failed = (job->sums == NULL);
+    }  /* RunIUPJob */
+
+/* SumIUPTuples runs every tuple in tuples through the IUP kernel for glyph
+   and returns a block whose first 2 * (pointCount + 4) doubles hold the
+   summed x deltas followed by the summed y deltas; the caller frees it with
+   PyMem_RawFree. This touches no Python objects, so it may be called with
+   the GIL released. Returns NULL if memory runs out. */
+
+static double *SumIUPTuples(const FMQuadGlyph *glyph, const FMIUPTuple *tuples, Py_ssize_t tupleCount)
+    {
+    double          *work;
+    unsigned char   *touched;
+    Py_ssize_t      i, n = glyph->pointCount + 4;
+    
+    /* one block holds the x and y sums, the per-tuple deltas and the mask */
+    work = PyMem_RawMalloc(4 * n * sizeof(double) + n);
+    
+    if (work == NULL)
+        return NULL;
+    
+    touched = (unsigned char *) (work + 4 * n);
+    
+    for (i = 0; i < 2 * n; i += 1)
+        work[i] = 0.0;
+    
+    for (i = 0; i < tupleCount; i += 1)
+        InterpolateUntouched(glyph, tuples + i, touched, work + 2 * n, work + 3 * n, work, work + n);
+    
+    return work;
+    }  /* SumIUPTuples */
+
+/* SweepRows fills lefts and rights for the rows yStart, yStart + 1, ... using
+   an active edge table: edges are sorted by yMin, join the table when the
+   sweep reaches them and leave it once the sweep passes their yMax. Rows with
+   no intersection get NaN in both columns. This touches no Python objects and
+   so may be called with the GIL released. Returns nonzero on allocation
+   failure. */
+
+static int SweepRows(
+    const FMSegment *segs, Py_ssize_t segCount, double yStart, Py_ssize_t rowCount,
+    double *lefts, double *rights)
+    {
+    FMEdge      *edges, **active;
+    Py_ssize_t  activeCount = 0, i, nextEdge = 0, row;
+    
+    edges = PyMem_RawMalloc((segCount ? segCount : 1) * sizeof(FMEdge));
+    require(edges != NULL, Err_BadReturn);
+    active = PyMem_RawMalloc((segCount ? segCount : 1) * sizeof(FMEdge *));
+    require(active != NULL, Err_FreeEdges);
+    
+    for (i = 0; i < segCount; i += 1)
+        {
+        const FMSegment *seg = segs + i;
+        FMEdge          *edge = edges + i;
+        
+        edge->seg = seg;
+        edge->a = seg->on1Y + seg->on2Y - 2.0 * seg->offY;
+        edge->b = 2.0 * (seg->offY - seg->on1Y);
+        edge->ax = seg->on1X + seg->on2X - 2.0 * seg->offX;
+        edge->bx = 2.0 * (seg->offX - seg->on1X);
+        edge->det = 0.0;
+        edge->slope = 0.0;
+        
+        if (!seg->isSpline)
+            {
+            edge->bx = seg->on2X - seg->on1X;
+            
+            if (!AE(seg->yMax, seg->yMin) && !AE(seg->on1X, seg->on2X))
+                edge->slope = (seg->on2X - seg->on1X) / (seg->on2Y - seg->on1Y);
+            }
+        }
+    
+    qsort(edges, segCount, sizeof(FMEdge), CompareEdges);
+    
+    for (row = 0; row < rowCount; row += 1)
+        {
+        double      y = yStart + (double) row;
+        double      xMin = 100000.0;
+        double      xMax = -100000.0;
+        int         found = 0;
+        Py_ssize_t  kept = 0;
+        
+        while (nextEdge < segCount && edges[nextEdge].seg->yMin <= y)
+            {
+            FMEdge  *edge = edges + nextEdge++;
+            
+            edge->det = edge->b * edge->b - 4.0 * edge->a * (edge->seg->on1Y - y);
+            active[activeCount++] = edge;
+            }
+        
+        for (i = 0; i < activeCount; i += 1)
+            {
+            FMEdge  *edge = active[i];
             
+            if (edge->seg->yMax < y)
+                continue;
+            
+            EdgeSect(edge, y, &xMin, &xMax, &found);
+            edge->det += 4.0 * edge->a;
+            active[kept++] = edge;
+            }
+        
+        activeCount = kept;
+        lefts[row] = (found ? xMin : NAN);
+        rights[row] = (found ? xMax : NAN);
+        }
+    
+    PyMem_RawFree(active);
+    PyMem_RawFree(edges);
+    return 0;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeEdges:      PyMem_RawFree(edges);
+    Err_BadReturn:      return 1;
+    }  /* SweepRows */
+
+static void UnionPoint(double *bounds, double x, double y, int *found)
+    {
+    if (!*found)
+        {
+        bounds[0] = bounds[2] = x;
+        bounds[1] = bounds[3] = y;
+        *found = 1;
+        return;
+        }
+    
+    bounds[0] = fmin(bounds[0], x);
+    bounds[1] = fmin(bounds[1], y);
+    bounds[2] = fmax(bounds[2], x);
+    bounds[3] = fmax(bounds[3], y);
+    }  /* UnionPoint */
+
+static void UnpackSegments(const double *packed, Py_ssize_t segCount, FMSegment *walk)
+    {
+    while (segCount--)
+        {
+        walk->isSpline = (packed[0] ? 1.0 : 0.0);
+        walk->on1X = packed[1];
+        walk->on1Y = packed[2];
+        walk->offX = packed[3];
+        walk->offY = packed[4];
+        walk->on2X = packed[5];
+        walk->on2Y = packed[6];
+        
+        if (walk->isSpline)
+            {
+            walk->yMin = fmin(walk->on1Y, fmin(walk->offY, walk->on2Y));
+            walk->yMax = fmax(walk->on1Y, fmax(walk->offY, walk->on2Y));
+            }
+        
+        else
+            {
+            walk->offX = walk->offY = 0.0;
             walk->yMin = fmin(walk->on1Y, walk->on2Y);
             walk->yMax = fmax(walk->on1Y, walk->on2Y);
             }
         
-        Py_DECREF(seg);
+        packed += PACKED_SEGMENT_DOUBLES;
         walk += 1;
         }
+    }  /* UnpackSegments */
+
+/* ------------------------------------------------------------------------ */
+
+/*** INTERFACE PROCEDURES ***/
+
+/* fmCubicBounds(segments[, tight]) returns (xMin, yMin, xMax, yMax) for a
+   buffer of cubic segments packed as 8 doubles (x0, y0, x1, y1, x2, y2, x3,
+   y3), or None if there are no segments. */
+
+static PyObject *fm_CubicBounds(PyObject *self, PyObject *args)
+    {
+    double      bounds[4], *segs;
+    int         found, tight = 0;
+    Py_ssize_t  count;
+    PyObject    *retVal, *segments;
     
+    require_noerr(
+      !PyArg_ParseTuple(args, "O|p", &segments, &tight),
+      Err_BadReturn);
+    
+    segs = DoublesFromBuffer(segments, &count);
+    require(segs != NULL, Err_BadReturn);
+    require_action(!(count % 8), Err_FreeSegs, PyErr_SetString(PyExc_ValueError, "Cubic segment buffer length is not a multiple of 8!"););
+    found = CubicBounds(segs, count / 8, tight, bounds);
+    retVal = BoundsTuple(bounds, found);
+    
+    PyMem_Free(segs);
     return retVal;
     
     /*** ERROR HANDLERS ***/
-    Err_FreeN:          Py_DECREF(n);
-    Err_FreeSeg:        Py_DECREF(seg);
-    Err_FreeRetval:     PyMem_Free(retVal);
+    Err_FreeSegs:       PyMem_Free(segs);
     Err_BadReturn:      return NULL;
-    }  /* MakeCSegments */
-
-/* ------------------------------------------------------------------------ */
-
-/*** INTERFACE PROCEDURES ***/
+    }   /* fm_CubicBounds */
 
 static PyObject *fm_FindLRExtrema(PyObject *self, PyObject *args)
     {
-    double      y, yMax, yMin;
+    double      *lefts, *rights, yMax, yMin;
     FMSegment   *cSegments;
-    Py_ssize_t  segCount;
-    PyObject    *key, *ptX1, *ptX2, *retVal, *segments, *value;
+    int         asArrays = 0;
+    Py_ssize_t  row, rowCount, segCount;
+    PyObject    *key, *leftArray, *retVal, *rightArray, *segments, *value;
     
     require_noerr(
-      !PyArg_ParseTuple(args, "O", &segments),
+      !PyArg_ParseTuple(args, "O|p", &segments, &asArrays),
       Err_BadReturn);
     
     Py_INCREF(segments);  /* turn borrowed ref into regular one */
@@ -339,49 +1845,494 @@ static PyObject *fm_FindLRExtrema(PyObject *self, PyObject *args)
     cSegments = MakeCSegments(segments, segCount);
     require(cSegments != NULL, Err_FreeInputs);
     FindYExtrema(cSegments, segCount, &yMax, &yMin);
-    retVal = PyDict_New();
-    require(retVal != NULL, Err_FreeSegs);
+    rowCount = RowCount(yMin, yMax);
+    lefts = PyMem_Calloc(2 * rowCount + 1, sizeof(double));
+    require_action(lefts != NULL, Err_FreeSegs, PyErr_NoMemory(););
+    rights = lefts + rowCount;
+    require_action(!SweepRows(cSegments, segCount, yMin, rowCount, lefts, rights), Err_FreeRows, PyErr_NoMemory(););
     
-    for (y = yMin; y <= yMax; y += 1.0)
+    if (asArrays)
+        {  /* (yMin, lefts, rights), with NaN for rows having no intersection */
+        leftArray = MakeArray("d", lefts, rowCount * (Py_ssize_t) sizeof(double));
+        require(leftArray, Err_FreeRows);
+        rightArray = MakeArray("d", rights, rowCount * (Py_ssize_t) sizeof(double));
+        require_action(rightArray, Err_FreeRows, Py_DECREF(leftArray););
+        retVal = Py_BuildValue("(dNN)", yMin, leftArray, rightArray);
+        require(retVal, Err_FreeRows);
+        }
+    
+    else
         {
-        double  x1, x2;
-        int     found;
+        retVal = PyDict_New();
+        require(retVal != NULL, Err_FreeRows);
         
-        found = FindSect(y, cSegments, segCount, &x1, &x2);
-        
-        if (found)
-            {  /* add entry to dict */
-            key = PyLong_FromSsize_t((Py_ssize_t) y);
+        for (row = 0; row < rowCount; row += 1)
+            {
+            if (isnan(lefts[row]))
+                continue;
+            
+            /* add entry to dict */
+            key = PyLong_FromSsize_t((Py_ssize_t) (yMin + (double) row));
             require(key, Err_FreeRetVal);
-            ptX1 = PyFloat_FromDouble(x1);
-            require(ptX1, Err_FreeKey);
-            ptX2 = PyFloat_FromDouble(x2);
-            require(ptX2, Err_FreeX1);
-            value = Py_BuildValue("(OO)", ptX1, ptX2);
-            require(value, Err_FreeX2);
+            value = Py_BuildValue("(dd)", lefts[row], rights[row]);
+            require(value, Err_FreeKey);
             require_noerr(PyDict_SetItem(retVal, key, value), Err_FreeValue);
             Py_DECREF(value);
-            Py_DECREF(ptX2);
-            Py_DECREF(ptX1);
             Py_DECREF(key);
             }
         }
     
+    PyMem_Free(lefts);
     PyMem_Free(cSegments);
     Py_DECREF(segments);
     return retVal;
     
     /*** ERROR HANDLERS ***/
     Err_FreeValue:      Py_DECREF(value);
-    Err_FreeX2:         Py_DECREF(ptX2);
-    Err_FreeX1:         Py_DECREF(ptX1);
     Err_FreeKey:        Py_DECREF(key);
     Err_FreeRetVal:     Py_DECREF(retVal);
+    Err_FreeRows:       PyMem_Free(lefts);
     Err_FreeSegs:       PyMem_Free(cSegments);
     Err_FreeInputs:     Py_DECREF(segments);
     Err_BadReturn:      return NULL;
     }   /* fm_FindLRExtrema */
 
+/* fmFindLRExtremaBatch(listOfSegmentBuffers, nthreads) runs the sweep for
+   many glyphs at once. Each buffer holds a glyph's segments packed as
+   described at PACKED_SEGMENT_DOUBLES (an array('d') works). The buffers are
+   swept on nthreads native threads (0 means one per online CPU) with the GIL
+   released, and the result is a list of (yMin, lefts, rights) tuples in the
+   same form fmFindLRExtrema returns when asArrays is True. */
+
+static PyObject *fm_FindLRExtremaBatch(PyObject *self, PyObject *args)
+    {
+    FMBatch     batch;
+    FMBatchJob  *job, *jobs;
+    Py_buffer   *views;
+    Py_ssize_t  i, glyphCount, threadCount, viewCount = 0;
+    int         anyFailed = 0;
+    PyObject    *buffers, *glyphResult, *item, *leftArray, *retVal, *rightArray, *seq;
+    
+    require_noerr(
+      !PyArg_ParseTuple(args, "On", &buffers, &threadCount),
+      Err_BadReturn);
+    
+    seq = PySequence_Fast(buffers, "fmFindLRExtremaBatch requires a sequence of buffers");
+    require(seq, Err_BadReturn);
+    glyphCount = PySequence_Fast_GET_SIZE(seq);
+    views = PyMem_Calloc(glyphCount + 1, sizeof(Py_buffer));
+    require_action(views != NULL, Err_FreeSeq, PyErr_NoMemory(););
+    jobs = PyMem_Calloc(glyphCount + 1, sizeof(FMBatchJob));
+    require_action(jobs != NULL, Err_FreeViews, PyErr_NoMemory(););
+    batch.jobs = jobs;
+    batch.jobSize = sizeof(FMBatchJob);
+    batch.jobCount = glyphCount;
+    batch.runJob = RunExtremaJob;
+    
+    for (viewCount = 0; viewCount < glyphCount; viewCount += 1)
+        {
+        item = PySequence_Fast_GET_ITEM(seq, viewCount);
+        require_noerr(PyObject_GetBuffer(item, views + viewCount, PyBUF_SIMPLE), Err_FreeJobs);
+        job = jobs + viewCount;
+        
+        if (views[viewCount].len % (PACKED_SEGMENT_DOUBLES * sizeof(double)))
+            {
+            viewCount += 1;
+            PyErr_SetString(PyExc_ValueError, "Packed segment buffer length is not a multiple of 7 doubles!");
+            goto Err_FreeJobs;
+            }
+        
+        job->packed = (const double *) views[viewCount].buf;
+        job->segCount = views[viewCount].len / (PACKED_SEGMENT_DOUBLES * sizeof(double));
+        }
+    
+    require_noerr(RunBatch(&batch, threadCount), Err_FreeJobs);
+    
+    for (i = 0; i < glyphCount; i += 1)
+        anyFailed |= jobs[i].failed;
+    
+    require_action(!anyFailed, Err_FreeRows, PyErr_NoMemory(););
+    retVal = PyList_New(glyphCount);
+    require(retVal, Err_FreeRows);
+    
+    for (i = 0; i < glyphCount; i += 1)
+        {
+        job = jobs + i;
+        leftArray = MakeArray("d", job->rows, job->rowCount * (Py_ssize_t) sizeof(double));
+        require(leftArray, Err_FreeRetVal);
+        rightArray = MakeArray("d", job->rows + job->rowCount, job->rowCount * (Py_ssize_t) sizeof(double));
+        require_action(rightArray, Err_FreeRetVal, Py_DECREF(leftArray););
+        glyphResult = Py_BuildValue("(dNN)", job->yMin, leftArray, rightArray);
+        require(glyphResult, Err_FreeRetVal);
+        PyList_SET_ITEM(retVal, i, glyphResult);  /* steals the reference */
+        }
+    
+    for (i = 0; i < glyphCount; i += 1)
+        PyMem_RawFree(jobs[i].rows);
+    
+    for (i = 0; i < viewCount; i += 1)
+        PyBuffer_Release(views + i);
+    
+    PyMem_Free(jobs);
+    PyMem_Free(views);
+    Py_DECREF(seq);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeRetVal:     Py_DECREF(retVal);
+    Err_FreeRows:       for (i = 0; i < glyphCount; i += 1)
+                            PyMem_RawFree(jobs[i].rows);
+    Err_FreeJobs:       for (i = 0; i < viewCount; i += 1)
+                            PyBuffer_Release(views + i);
+                        PyMem_Free(jobs);
+    Err_FreeViews:      PyMem_Free(views);
+    Err_FreeSeq:        Py_DECREF(seq);
+    Err_BadReturn:      return NULL;
+    }   /* fm_FindLRExtremaBatch */
+
+/* fmFlattenComposites(simples, composites, roots[, roundResult]) flattens
+   composite glyphs into simple outlines. The simples dict maps glyph index to
+   a packed (xs, ys, onCurve, contourEnds) tuple as for fmQuadBounds; the
+   composites dict maps glyph index to a sequence of component tuples
+
+       (glyphIndex, a, b, c, d, dx, dy, compoundAnchor, componentAnchor,
+        roundToGrid)
+
+   where (a, b, c, d) is the 2x2 part and (dx, dy) the offset part of the
+   component's matrix (x' = a*x + c*y + dx, y' = b*x + d*y + dy), and the
+   anchors are point indices, or -1 if the component is placed by offset.
+   Each entry in roots is such a component sequence; the return value is a
+   list of packed tuples, one per root, with None where the root could not be
+   flattened. */
+
+static PyObject *fm_FlattenComposites(PyObject *self, PyObject *args)
+    {
+    int                 err, roundResult = 1;
+    FMFlattenContext    ctx;
+    FMPointBuffer       buf;
+    Py_ssize_t          i, rootCount;
+    PyObject            *retVal, *roots, *seq, *value;
+    
+    memset(&ctx, 0, sizeof(FMFlattenContext));
+    memset(&buf, 0, sizeof(FMPointBuffer));
+    
+    require_noerr(
+      !PyArg_ParseTuple(args, "O!O!O|p", &PyDict_Type, &ctx.simples, &PyDict_Type, &ctx.composites, &roots, &roundResult),
+      Err_BadReturn);
+    
+    seq = PySequence_Fast(roots, "fmFlattenComposites requires a sequence of roots");
+    require(seq, Err_BadReturn);
+    rootCount = PySequence_Fast_GET_SIZE(seq);
+    retVal = PyList_New(rootCount);
+    require(retVal, Err_FreeSeq);
+    
+    for (i = 0; i < rootCount; i += 1)
+        {
+        buf.pointCount = buf.contourCount = 0;
+        err = FlattenComponents(&ctx, PySequence_Fast_GET_ITEM(seq, i), &buf);
+        require(err >= 0, Err_FreeRetVal);
+        
+        if (err)
+            {
+            Py_INCREF(Py_None);
+            value = Py_None;
+            }
+        
+        else
+            {
+            value = PointBufferTuple(&buf, roundResult);
+            require(value, Err_FreeRetVal);
+            }
+        
+        PyList_SET_ITEM(retVal, i, value);  /* steals the reference */
+        }
+    
+    FreePointBuffer(&buf);
+    Py_DECREF(seq);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeRetVal:     Py_DECREF(retVal);
+    Err_FreeSeq:        Py_DECREF(seq);
+                        FreePointBuffer(&buf);
+    Err_BadReturn:      return NULL;
+    }   /* fm_FlattenComposites */
+
+/* fmInterpolateUntouched(xs, ys, onCurve, contourEnds, points, xDeltas,
+   yDeltas) takes a simple glyph as packed arrays (see fmQuadBounds) and the
+   sparse deltas of one tuple variation, and returns a pair of array('d')
+   with the deltas for every point plus the 4 phantom points, those for the
+   untouched points being inferred as the 'gvar' IUP rules specify. */
+
+static PyObject *fm_InterpolateUntouched(PyObject *self, PyObject *args)
+    {
+    double      *sums;
+    FMIUPTuple  t;
+    FMQuadGlyph glyph;
+    PyObject    *contourEnds, *onCurve, *points, *retVal, *xDeltas, *xs, *yDeltas, *ys;
+    
+    require_noerr(
+      !PyArg_ParseTuple(args, "OOOOOOO", &xs, &ys, &onCurve, &contourEnds, &points, &xDeltas, &yDeltas),
+      Err_BadReturn);
+    
+    require_noerr(LoadIUPTuple(1.0, points, xDeltas, yDeltas, &t), Err_BadReturn);
+    require_noerr(LoadQuadGlyph(xs, ys, onCurve, contourEnds, &glyph), Err_FreeTuple);
+    
+    Py_BEGIN_ALLOW_THREADS
+    sums = SumIUPTuples(&glyph, &t, 1);
+    Py_END_ALLOW_THREADS
+    
+    require_action(sums != NULL, Err_FreeGlyph, PyErr_NoMemory(););
+    retVal = DeltaArrays(sums, glyph.pointCount + 4);
+    
+    PyMem_RawFree(sums);
+    FreeQuadGlyph(&glyph);
+    FreeIUPTuple(&t);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeGlyph:      FreeQuadGlyph(&glyph);
+    Err_FreeTuple:      FreeIUPTuple(&t);
+    Err_BadReturn:      return NULL;
+    }   /* fm_InterpolateUntouched */
+
+/* fmInterpolateUntouchedBatch(glyphs[, nthreads]) takes a sequence of
+   (packed, tuples) pairs, where packed is an (xs, ys, onCurve, contourEnds)
+   tuple and tuples is a sequence of (scalar, points, xDeltas, yDeltas)
+   tuples, and returns a list with the summed, scaled deltas for each glyph
+   as fmInterpolateUntouched returns them. This lets one call do all the
+   tuples of all the glyphs being instanced. The glyphs are shared out among
+   nthreads native threads (default 1; 0 means one per online CPU) with the
+   GIL released. */
+
+static PyObject *fm_InterpolateUntouchedBatch(PyObject *self, PyObject *args)
+    {
+    double      scalar;
+    FMBatch     batch;
+    FMIUPJob    *job, *jobs;
+    Py_ssize_t  glyphCount, i, j, threadCount = 1;
+    int         anyFailed = 0;
+    PyObject    *contourEnds, *glyphs, *onCurve, *packed, *points, *retVal, *seq, *tupleSeq, *tuplesObj;
+    PyObject    *value, *xDeltas, *xs, *yDeltas, *ys;
+    
+    require_noerr(
+      !PyArg_ParseTuple(args, "O|n", &glyphs, &threadCount),
+      Err_BadReturn);
+    
+    seq = PySequence_Fast(glyphs, "fmInterpolateUntouchedBatch requires a sequence of glyphs");
+    require(seq, Err_BadReturn);
+    glyphCount = PySequence_Fast_GET_SIZE(seq);
+    jobs = PyMem_Calloc(glyphCount + 1, sizeof(FMIUPJob));
+    require_action(jobs != NULL, Err_FreeSeq, PyErr_NoMemory(););
+    
+    for (i = 0; i < glyphCount; i += 1)
+        {
+        job = jobs + i;
+        require_noerr(!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(seq, i), "OO", &packed, &tuplesObj), Err_FreeJobs);
+        require_noerr(!PyArg_ParseTuple(packed, "OOOO", &xs, &ys, &onCurve, &contourEnds), Err_FreeJobs);
+        tupleSeq = PySequence_Fast(tuplesObj, "fmInterpolateUntouchedBatch requires a sequence of tuples");
+        require(tupleSeq, Err_FreeJobs);
+        job->tuples = PyMem_Calloc(PySequence_Fast_GET_SIZE(tupleSeq) + 1, sizeof(FMIUPTuple));
+        require_action(job->tuples != NULL, Err_FreeTupleSeq, PyErr_NoMemory(););
+        
+        for (j = 0; j < PySequence_Fast_GET_SIZE(tupleSeq); j += 1)
+            {
+            require_noerr(
+              !PyArg_ParseTuple(PySequence_Fast_GET_ITEM(tupleSeq, j), "dOOO", &scalar, &points, &xDeltas, &yDeltas),
+              Err_FreeTupleSeq);
+            
+            require_noerr(LoadIUPTuple(scalar, points, xDeltas, yDeltas, job->tuples + j), Err_FreeTupleSeq);
+            job->tupleCount += 1;
+            }
+        
+        Py_DECREF(tupleSeq);
+        require_noerr(LoadQuadGlyph(xs, ys, onCurve, contourEnds, &job->glyph), Err_FreeJobs);
+        }
+    
+    batch.jobs = jobs;
+    batch.jobSize = sizeof(FMIUPJob);
+    batch.jobCount = glyphCount;
+    batch.runJob = RunIUPJob;
+    require_noerr(RunBatch(&batch, threadCount), Err_FreeJobs);
+    
+    for (i = 0; i < glyphCount; i += 1)
+        anyFailed |= jobs[i].failed;
+    
+    require_action(!anyFailed, Err_FreeJobs, PyErr_NoMemory(););
+    retVal = PyList_New(glyphCount);
+    require(retVal, Err_FreeJobs);
+    
+    for (i = 0; i < glyphCount; i += 1)
+        {
+        value = DeltaArrays(jobs[i].sums, jobs[i].glyph.pointCount + 4);
+        require(value, Err_FreeRetVal);
+        PyList_SET_ITEM(retVal, i, value);  /* steals the reference */
+        }
+    
+    for (i = 0; i < glyphCount; i += 1)
+        FreeIUPJob(jobs + i);
+    
+    PyMem_Free(jobs);
+    Py_DECREF(seq);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeTupleSeq:   Py_DECREF(tupleSeq);
+                        goto Err_FreeJobs;
+    Err_FreeRetVal:     Py_DECREF(retVal);
+    Err_FreeJobs:       for (i = 0; i < glyphCount; i += 1)  /* unloaded jobs are still zeroed */
+                            FreeIUPJob(jobs + i);
+                        
+                        PyMem_Free(jobs);
+    Err_FreeSeq:        Py_DECREF(seq);
+    Err_BadReturn:      return NULL;
+    }   /* fm_InterpolateUntouchedBatch */
+
+/* fmOptimizeIUP(xs, ys, onCurve, contourEnds, xDeltas, yDeltas[, tolerance])
+   takes a simple glyph as packed arrays (see fmQuadBounds) and the full x
+   and y deltas of one tuple variation (any phantom point deltas past the
+   glyph's own points are ignored), and returns an array('l') of the points
+   whose deltas have to be stored so that IUP infers all the others, once
+   rounded to integers, to within tolerance (default 0.5) units. Contours whose deltas are all that
+   close to zero contribute no points at all. */
+
+static PyObject *fm_OptimizeIUP(PyObject *self, PyObject *args)
+    {
+    double          tolerance = 0.5, *xDeltas, *yDeltas;
+    FMQuadGlyph     glyph;
+    long            *kept;
+    Py_ssize_t      c, end, i, keptCount = 0, start, xCount, yCount;
+    PyObject        *contourEnds, *onCurve, *retVal, *xDeltaObj, *xs, *yDeltaObj, *ys;
+    unsigned char   *keep;
+    
+    require_noerr(
+      !PyArg_ParseTuple(args, "OOOOOO|d", &xs, &ys, &onCurve, &contourEnds, &xDeltaObj, &yDeltaObj, &tolerance),
+      Err_BadReturn);
+    
+    require_noerr(LoadQuadGlyph(xs, ys, onCurve, contourEnds, &glyph), Err_BadReturn);
+    xDeltas = DoublesFromBuffer(xDeltaObj, &xCount);
+    require(xDeltas != NULL, Err_FreeGlyph);
+    yDeltas = DoublesFromBuffer(yDeltaObj, &yCount);
+    require(yDeltas != NULL, Err_FreeXDeltas);
+    
+    require_action(
+      (xCount >= glyph.pointCount) && (yCount >= glyph.pointCount),
+      Err_FreeYDeltas,
+      PyErr_SetString(PyExc_ValueError, "Delta arrays are shorter than the glyph!"););
+    
+    kept = PyMem_Malloc((glyph.pointCount + 1) * (sizeof(long) + 1));
+    require_action(kept != NULL, Err_FreeYDeltas, PyErr_NoMemory(););
+    keep = (unsigned char *) (kept + glyph.pointCount + 1);
+    
+    for (c = 0, start = 0; c < glyph.contourCount; c += 1, start = end + 1)
+        {
+        end = (Py_ssize_t) glyph.contourEnds[c];
+        
+        if (end < start)
+            continue;
+        
+        require_noerr(
+          IUPOptimizeContour(
+            glyph.xs + start, glyph.ys + start, xDeltas + start, yDeltas + start, end - start + 1,
+            tolerance, keep + start),
+          Err_FreeKept);
+        
+        for (i = start; i <= end; i += 1)
+            {
+            if (keep[i])
+                kept[keptCount++] = (long) i;
+            }
+        }
+    
+    retVal = MakeArray("l", kept, keptCount * (Py_ssize_t) sizeof(long));
+    
+    PyMem_Free(kept);
+    PyMem_Free(yDeltas);
+    PyMem_Free(xDeltas);
+    FreeQuadGlyph(&glyph);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeKept:       PyMem_Free(kept);
+    Err_FreeYDeltas:    PyMem_Free(yDeltas);
+    Err_FreeXDeltas:    PyMem_Free(xDeltas);
+    Err_FreeGlyph:      FreeQuadGlyph(&glyph);
+    Err_BadReturn:      return NULL;
+    }   /* fm_OptimizeIUP */
+
+/* fmQuadBounds(xs, ys, onCurve, contourEnds[, tight]) returns (xMin, yMin,
+   xMax, yMax) for one simple glyph given as packed arrays (any numeric
+   array.array or bytes), or None if the glyph has no points. */
+
+static PyObject *fm_QuadBounds(PyObject *self, PyObject *args)
+    {
+    double      bounds[4];
+    int         found, tight = 0;
+    FMQuadGlyph glyph;
+    PyObject    *contourEnds, *onCurve, *retVal, *xs, *ys;
+    
+    require_noerr(
+      !PyArg_ParseTuple(args, "OOOO|p", &xs, &ys, &onCurve, &contourEnds, &tight),
+      Err_BadReturn);
+    
+    require_noerr(LoadQuadGlyph(xs, ys, onCurve, contourEnds, &glyph), Err_BadReturn);
+    found = QuadBounds(&glyph, tight, bounds);
+    retVal = BoundsTuple(bounds, found);
+    
+    FreeQuadGlyph(&glyph);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_BadReturn:      return NULL;
+    }   /* fm_QuadBounds */
+
+/* fmQuadBoundsBatch(glyphs[, tight]) takes a sequence of (xs, ys, onCurve,
+   contourEnds) tuples, as for fmQuadBounds, and returns a list with the
+   bounds (or None) for each. */
+
+static PyObject *fm_QuadBoundsBatch(PyObject *self, PyObject *args)
+    {
+    double      bounds[4];
+    int         found, tight = 0;
+    FMQuadGlyph glyph;
+    Py_ssize_t  glyphCount, i;
+    PyObject    *contourEnds, *glyphs, *item, *onCurve, *retVal, *seq, *value, *xs, *ys;
+    
+    require_noerr(
+      !PyArg_ParseTuple(args, "O|p", &glyphs, &tight),
+      Err_BadReturn);
+    
+    seq = PySequence_Fast(glyphs, "fmQuadBoundsBatch requires a sequence of glyphs");
+    require(seq, Err_BadReturn);
+    glyphCount = PySequence_Fast_GET_SIZE(seq);
+    retVal = PyList_New(glyphCount);
+    require(retVal, Err_FreeSeq);
+    
+    for (i = 0; i < glyphCount; i += 1)
+        {
+        item = PySequence_Fast_GET_ITEM(seq, i);
+        require_noerr(!PyArg_ParseTuple(item, "OOOO", &xs, &ys, &onCurve, &contourEnds), Err_FreeRetVal);
+        require_noerr(LoadQuadGlyph(xs, ys, onCurve, contourEnds, &glyph), Err_FreeRetVal);
+        
+        Py_BEGIN_ALLOW_THREADS
+        found = QuadBounds(&glyph, tight, bounds);
+        Py_END_ALLOW_THREADS
+        
+        FreeQuadGlyph(&glyph);
+        value = BoundsTuple(bounds, found);
+        require(value, Err_FreeRetVal);
+        PyList_SET_ITEM(retVal, i, value);  /* steals the reference */
+        }
+    
+    Py_DECREF(seq);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeRetVal:     Py_DECREF(retVal);
+    Err_FreeSeq:        Py_DECREF(seq);
+    Err_BadReturn:      return NULL;
+    }   /* fm_QuadBoundsBatch */
+
 /* ------------------------------------------------------------------------ */
 
 /*** MODULE CREATION ***/
@@ -0,0 +1,484 @@
+/*
+ * intersectionlib.c -- Implementation of fast quadratic outline intersection tests.
+ *
+ * Copyright (c) 2017 Monotype Imaging Inc. All Rights Reserved.
+ *
+ */
+
+#include <Python.h>
+#include <math.h>
+#include "AssertMacros.h"
+
+/* ------------------------------------------------------------------------ */
+
+/*** MACROS ***/
+
+/* AE is "almost equal" */
+#define AE(v1,v2) (fabs(v2-v1) < 1.0e-5)
+
+/* Subdivision stops once both pieces fit in a box this size (font units) */
+#define LEAF_SIZE 1.0e-3
+
+/* Hard limit on subdivision depth, as a guard against coincident curves */
+#define MAX_DEPTH 48
+
+/* ------------------------------------------------------------------------ */
+
+/*** TYPES ***/
+
+/* An ILPiece is one quadratic piece of a contour. Straight lines are stored
+   with their midpoint as the control point, and flagged so that line/line
+   pairs can be solved exactly. */
+
+struct ILPiece
+    {
+    double      x0, y0, x1, y1, x2, y2;
+    double      xMin, yMin, xMax, yMax;
+    Py_ssize_t  contourIndex;
+    int         isLine;
+    };
+
+#ifndef __cplusplus
+typedef struct ILPiece ILPiece;
+#endif
+
+/* ------------------------------------------------------------------------ */
+
+/*** PROTOTYPES ***/
+
+static void AddPiece(
+    ILPiece *piece, Py_ssize_t contourIndex, const double *p0, const double *p1,
+    const double *p2, int isLine);
+static int ComparePieces(const void *p1, const void *p2);
+static int CurvesCross(
+    const double *q1, double t0, double t1, const double *q2, double u0, double u1, int depth);
+static int LinesCross(const ILPiece *a, const ILPiece *b);
+static Py_ssize_t MakePieces(PyObject *contours, ILPiece **piecesPtr, Py_ssize_t *contourCount);
+static int PiecesCross(const ILPiece *a, const ILPiece *b);
+static void Subdivide(const double *q, double *left, double *right);
+
+static PyObject *il_VerifyQuadOutline(PyObject *self, PyObject *args);
+
+/* ------------------------------------------------------------------------ */
+
+/*** STATIC GLOBALS ***/
+
+static PyMethodDef IntersectionLibMethods[] = {
+    {"VerifyQuadOutline", il_VerifyQuadOutline, METH_VARARGS, NULL},
+    {NULL, NULL, 0, NULL}};
+
+/* ------------------------------------------------------------------------ */
+
+/*** PRIVATE PROCEDURES ***/
+
+static void AddPiece(
+    ILPiece *piece, Py_ssize_t contourIndex, const double *p0, const double *p1,
+    const double *p2, int isLine)
+    {
+    piece->x0 = p0[0];
+    piece->y0 = p0[1];
+    piece->x2 = p2[0];
+    piece->y2 = p2[1];
+    
+    if (isLine)
+        {
+        piece->x1 = (p0[0] + p2[0]) / 2.0;
+        piece->y1 = (p0[1] + p2[1]) / 2.0;
+        }
+    
+    else
+        {
+        piece->x1 = p1[0];
+        piece->y1 = p1[1];
+        }
+    
+    piece->xMin = fmin(piece->x0, fmin(piece->x1, piece->x2));
+    piece->yMin = fmin(piece->y0, fmin(piece->y1, piece->y2));
+    piece->xMax = fmax(piece->x0, fmax(piece->x1, piece->x2));
+    piece->yMax = fmax(piece->y0, fmax(piece->y1, piece->y2));
+    piece->contourIndex = contourIndex;
+    piece->isLine = isLine;
+    }  /* AddPiece */
+
+static int ComparePieces(const void *p1, const void *p2)
+    {
+    double  x1 = ((const ILPiece *) p1)->xMin;
+    double  x2 = ((const ILPiece *) p2)->xMin;
+    
+    return (x1 > x2) - (x1 < x2);
+    }  /* ComparePieces */
+
+/* CurvesCross is the narrow phase for curved pieces. The pieces (given as
+   x0, y0, x1, y1, x2, y2 control points covering parameters [t0, t1] and
+   [u0, u1] of the originals) are subdivided while their control boxes still
+   overlap. A leaf counts as a crossing unless it sits at an end of both
+   original pieces, which is just two pieces touching at a shared point. */
+
+static int CurvesCross(
+    const double *q1, double t0, double t1, const double *q2, double u0, double u1, int depth)
+    {
+    double  left[6], right[6];
+    double  w1, h1, w2, h2;
+    double  xMin1 = fmin(q1[0], fmin(q1[2], q1[4]));
+    double  xMax1 = fmax(q1[0], fmax(q1[2], q1[4]));
+    double  yMin1 = fmin(q1[1], fmin(q1[3], q1[5]));
+    double  yMax1 = fmax(q1[1], fmax(q1[3], q1[5]));
+    double  xMin2 = fmin(q2[0], fmin(q2[2], q2[4]));
+    double  xMax2 = fmax(q2[0], fmax(q2[2], q2[4]));
+    double  yMin2 = fmin(q2[1], fmin(q2[3], q2[5]));
+    double  yMax2 = fmax(q2[1], fmax(q2[3], q2[5]));
+    
+    if (xMax1 < xMin2 || xMax2 < xMin1 || yMax1 < yMin2 || yMax2 < yMin1)
+        return 0;
+    
+    w1 = xMax1 - xMin1;
+    h1 = yMax1 - yMin1;
+    w2 = xMax2 - xMin2;
+    h2 = yMax2 - yMin2;
+    
+    if (depth >= MAX_DEPTH || (fmax(w1, h1) < LEAF_SIZE && fmax(w2, h2) < LEAF_SIZE))
+        return !((t0 == 0.0 || t1 == 1.0) && (u0 == 0.0 || u1 == 1.0));
+    
+    if (fmax(w1, h1) >= fmax(w2, h2))
+        {
+        double  tMid = (t0 + t1) / 2.0;
+        
+        Subdivide(q1, left, right);
+        
+        return (
+          CurvesCross(left, t0, tMid, q2, u0, u1, depth + 1) ||
+          CurvesCross(right, tMid, t1, q2, u0, u1, depth + 1));
+        }
+    
+    else
+        {
+        double  uMid = (u0 + u1) / 2.0;
+        
+        Subdivide(q2, left, right);
+        
+        return (
+          CurvesCross(q1, t0, t1, left, u0, uMid, depth + 1) ||
+          CurvesCross(q1, t0, t1, right, uMid, u1, depth + 1));
+        }
+    }  /* CurvesCross */
+
+static int LinesCross(const ILPiece *a, const ILPiece *b)
+    {
+    double  rx = a->x2 - a->x0;
+    double  ry = a->y2 - a->y0;
+    double  sx = b->x2 - b->x0;
+    double  sy = b->y2 - b->y0;
+    double  qx = b->x0 - a->x0;
+    double  qy = b->y0 - a->y0;
+    double  d = rx * sy - ry * sx;
+    
+    if (AE(d, 0.0))
+        {  /* parallel; only collinear overlaps of nonzero length count */
+        double  rr = rx * rx + ry * ry;
+        double  lo, hi, t0, t1;
+        
+        if (!AE(qx * ry - qy * rx, 0.0) || AE(rr, 0.0))
+            return 0;
+        
+        t0 = (qx * rx + qy * ry) / rr;
+        t1 = ((b->x2 - a->x0) * rx + (b->y2 - a->y0) * ry) / rr;
+        lo = fmax(0.0, fmin(t0, t1));
+        hi = fmin(1.0, fmax(t0, t1));
+        return (hi - lo) * sqrt(rr) > LEAF_SIZE;
+        }
+    
+    else
+        {
+        double  t = (qx * sy - qy * sx) / d;
+        double  u = (qx * ry - qy * rx) / d;
+        
+        if (AE(t, 0.0))
+            t = 0.0;
+        else if (AE(t, 1.0))
+            t = 1.0;
+        
+        if (AE(u, 0.0))
+            u = 0.0;
+        else if (AE(u, 1.0))
+            u = 1.0;
+        
+        if (t < 0.0 || t > 1.0 || u < 0.0 || u > 1.0)
+            return 0;
+        
+        return !((t == 0.0 || t == 1.0) && (u == 0.0 || u == 1.0));
+        }
+    }  /* LinesCross */
+
+/* MakePieces converts a sequence of contours, each a sequence of
+   (x, y, isOffCurve) triples, into quadratic pieces using the usual TrueType
+   rules: consecutive off-curve points imply an on-curve midpoint, and a
+   contour with no on-curve points starts at such a midpoint. Returns the
+   piece count, or -1 with an exception set. */
+
+static Py_ssize_t MakePieces(PyObject *contours, ILPiece **piecesPtr, Py_ssize_t *contourCount)
+    {
+    double      *pts = NULL;
+    ILPiece     *pieces = NULL;
+    Py_ssize_t  c, i, n, pieceCount = 0, pieceCapacity = 0, pointCapacity = 0;
+    PyObject    *contour = NULL, *pt;
+    
+    *contourCount = PySequence_Length(contours);
+    require(*contourCount != -1, Err_BadReturn);
+    
+    for (c = 0; c < *contourCount; c += 1)
+        {
+        double      prevOn[2], *prevOff = NULL;
+        Py_ssize_t  k, start;
+        
+        contour = PySequence_GetItem(contours, c);
+        require(contour != NULL, Err_FreeAll);
+        n = PySequence_Length(contour);
+        require(n != -1, Err_FreeContour);
+        
+        if (n > pointCapacity)
+            {
+            double  *newPts = PyMem_Realloc(pts, 3 * n * sizeof(double));
+            
+            require_action(newPts != NULL, Err_FreeContour, PyErr_NoMemory(););
+            pts = newPts;
+            pointCapacity = n;
+            }
+        
+        for (i = 0; i < n; i += 1)
+            {
+            pt = PySequence_GetItem(contour, i);
+            require(pt != NULL, Err_FreeContour);
+            require_action(
+              PyArg_ParseTuple(pt, "ddd", pts + 3 * i, pts + 3 * i + 1, pts + 3 * i + 2),
+              Err_FreeContour,
+              Py_DECREF(pt););
+            Py_DECREF(pt);
+            }
+        
+        Py_CLEAR(contour);
+        
+        if (n < 2)
+            continue;
+        
+        if (pieceCount + n > pieceCapacity)
+            {
+            ILPiece *newPieces;
+            
+            pieceCapacity = 2 * (pieceCount + n);
+            newPieces = PyMem_Realloc(pieces, pieceCapacity * sizeof(ILPiece));
+            require_action(newPieces != NULL, Err_FreeAll, PyErr_NoMemory(););
+            pieces = newPieces;
+            }
+        
+        for (start = 0; start < n && pts[3 * start + 2]; start += 1)
+            ;
+        
+        if (start == n)
+            {  /* all off-curve: start at the implied point between 0 and 1 */
+            for (i = 0; i < n; i += 1)
+                {
+                double  *a = pts + 3 * i;
+                double  *b = pts + 3 * ((i + 1) % n);
+                double  *d = pts + 3 * ((i + 2) % n);
+                double  m1[2], m2[2];
+                
+                m1[0] = (a[0] + b[0]) / 2.0;
+                m1[1] = (a[1] + b[1]) / 2.0;
+                m2[0] = (b[0] + d[0]) / 2.0;
+                m2[1] = (b[1] + d[1]) / 2.0;
+                AddPiece(pieces + pieceCount++, c, m1, b, m2, 0);
+                }
+            
+            continue;
+            }
+        
+        prevOn[0] = pts[3 * start];
+        prevOn[1] = pts[3 * start + 1];
+        
+        for (k = 1; k <= n; k += 1)
+            {
+            double  *p = pts + 3 * ((start + k) % n);
+            
+            if (p[2])
+                {  /* off-curve */
+                if (prevOff != NULL)
+                    {
+                    double  m[2];
+                    
+                    m[0] = (prevOff[0] + p[0]) / 2.0;
+                    m[1] = (prevOff[1] + p[1]) / 2.0;
+                    AddPiece(pieces + pieceCount++, c, prevOn, prevOff, m, 0);
+                    prevOn[0] = m[0];
+                    prevOn[1] = m[1];
+                    }
+                
+                prevOff = p;
+                }
+            
+            else
+                {
+                if (prevOff != NULL)
+                    AddPiece(pieces + pieceCount++, c, prevOn, prevOff, p, 0);
+                else
+                    AddPiece(pieces + pieceCount++, c, prevOn, NULL, p, 1);
+                
+                prevOn[0] = p[0];
+                prevOn[1] = p[1];
+                prevOff = NULL;
+                }
+            }
+        }
+    
+    PyMem_Free(pts);
+    *piecesPtr = pieces;
+    return pieceCount;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeContour:    Py_XDECREF(contour);
+    Err_FreeAll:        PyMem_Free(pieces);
+                        PyMem_Free(pts);
+    Err_BadReturn:      return -1;
+    }  /* MakePieces */
+
+static int PiecesCross(const ILPiece *a, const ILPiece *b)
+    {
+    double  q1[6], q2[6];
+    
+    if (a->yMax < b->yMin || b->yMax < a->yMin)
+        return 0;
+    
+    if (a->isLine && b->isLine)
+        return LinesCross(a, b);
+    
+    q1[0] = a->x0; q1[1] = a->y0; q1[2] = a->x1; q1[3] = a->y1; q1[4] = a->x2; q1[5] = a->y2;
+    q2[0] = b->x0; q2[1] = b->y0; q2[2] = b->x1; q2[3] = b->y1; q2[4] = b->x2; q2[5] = b->y2;
+    return CurvesCross(q1, 0.0, 1.0, q2, 0.0, 1.0, 0);
+    }  /* PiecesCross */
+
+static void Subdivide(const double *q, double *left, double *right)
+    {
+    double  ax = (q[0] + q[2]) / 2.0, ay = (q[1] + q[3]) / 2.0;
+    double  bx = (q[2] + q[4]) / 2.0, by = (q[3] + q[5]) / 2.0;
+    double  mx = (ax + bx) / 2.0, my = (ay + by) / 2.0;
+    
+    left[0] = q[0]; left[1] = q[1]; left[2] = ax; left[3] = ay; left[4] = mx; left[5] = my;
+    right[0] = mx; right[1] = my; right[2] = bx; right[3] = by; right[4] = q[4]; right[5] = q[5];
+    }  /* Subdivide */
+
+/* ------------------------------------------------------------------------ */
+
+/*** INTERFACE PROCEDURES ***/
+
+/* VerifyQuadOutline(contours[, includeSelf]) returns (hasIntersections,
+   pairs), where pairs is a sorted list of (i, j) contour index pairs whose
+   edges cross. Self-intersecting contours appear as (i, i) only when
+   includeSelf is True. Pieces are sorted by their left edge and swept, so
+   only pieces whose control boxes overlap are handed to the narrow phase.
+   
+   Two pieces cross if they meet anywhere other than an end of one at an end
+   of the other; an end resting on the inside of another piece counts, as
+   does a collinear overlap of nonzero length. This is what
+   TTContour.intersects() does, except for collinear lines meeting only end
+   to end, which are never a crossing here but which that method reports for
+   some directions of the two lines. */
+
+static PyObject *il_VerifyQuadOutline(PyObject *self, PyObject *args)
+    {
+    char        *found;
+    ILPiece     *pieces = NULL, **active;
+    int         includeSelf = 0;
+    Py_ssize_t  activeCount = 0, contourCount, i, j, pieceCount;
+    PyObject    *contours, *pair, *pairs, *retVal;
+    
+    require_noerr(
+      !PyArg_ParseTuple(args, "O|p", &contours, &includeSelf),
+      Err_BadReturn);
+    
+    pieceCount = MakePieces(contours, &pieces, &contourCount);
+    require(pieceCount != -1, Err_BadReturn);
+    found = PyMem_Calloc(contourCount * contourCount + 1, 1);
+    require_action(found != NULL, Err_FreePieces, PyErr_NoMemory(););
+    active = PyMem_Calloc(pieceCount + 1, sizeof(ILPiece *));
+    require_action(active != NULL, Err_FreeFound, PyErr_NoMemory(););
+    
+    if (pieceCount)
+        qsort(pieces, pieceCount, sizeof(ILPiece), ComparePieces);
+    
+    for (i = 0; i < pieceCount; i += 1)
+        {
+        ILPiece     *piece = pieces + i;
+        Py_ssize_t  kept = 0;
+        
+        for (j = 0; j < activeCount; j += 1)
+            {
+            ILPiece     *other = active[j];
+            Py_ssize_t  c1, c2;
+            
+            if (other->xMax < piece->xMin)
+                continue;
+            
+            active[kept++] = other;
+            c1 = (other->contourIndex < piece->contourIndex ? other->contourIndex : piece->contourIndex);
+            c2 = (other->contourIndex < piece->contourIndex ? piece->contourIndex : other->contourIndex);
+            
+            if ((c1 == c2 && !includeSelf) || found[c1 * contourCount + c2])
+                continue;
+            
+            if (PiecesCross(other, piece))
+                found[c1 * contourCount + c2] = 1;
+            }
+        
+        activeCount = kept;
+        active[activeCount++] = piece;
+        }
+    
+    pairs = PyList_New(0);
+    require(pairs, Err_FreeActive);
+    
+    for (i = 0; i < contourCount; i += 1)
+        {
+        for (j = i; j < contourCount; j += 1)
+            {
+            if (!found[i * contourCount + j])
+                continue;
+            
+            pair = Py_BuildValue("(nn)", i, j);
+            require(pair, Err_FreePairs);
+            require_noerr_action(PyList_Append(pairs, pair), Err_FreePairs, Py_DECREF(pair););
+            Py_DECREF(pair);
+            }
+        }
+    
+    retVal = Py_BuildValue("(ON)", (PyList_GET_SIZE(pairs) ? Py_True : Py_False), pairs);
+    require(retVal, Err_FreeActive);
+    
+    PyMem_Free(active);
+    PyMem_Free(found);
+    PyMem_Free(pieces);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreePairs:      Py_DECREF(pairs);
+    Err_FreeActive:     PyMem_Free(active);
+    Err_FreeFound:      PyMem_Free(found);
+    Err_FreePieces:     PyMem_Free(pieces);
+    Err_BadReturn:      return NULL;
+    }  /* il_VerifyQuadOutline */
+
+/* ------------------------------------------------------------------------ */
+
+/*** MODULE CREATION ***/
+
+static struct PyModuleDef intersectionlibmodule =
+    {
+    PyModuleDef_HEAD_INIT,
+    "intersectionlibbackend",
+    NULL,   /* module doc string */
+    -1,
+    IntersectionLibMethods
+    };
+
+PyMODINIT_FUNC PyInit_intersectionlibbackend(void)
+    {
+    return PyModule_Create(&intersectionlibmodule);
+    }  /* PyInit_intersectionlibbackend */
@@ -6,19 +6,199 @@
  */
 
 #include <Python.h>
+#include <limits.h>
+#include <time.h>
 #include "AssertMacros.h"
 
 /* --------------------------------------------------------------------------------------------- */
 
+/*** MACROS ***/
+
+/* Flag bits in a TrueType simple glyph. */
+#define GLYF_ON_CURVE 0x01
+#define GLYF_X_SHORT 0x02
+#define GLYF_Y_SHORT 0x04
+#define GLYF_REPEAT 0x08
+#define GLYF_X_SAME_OR_POSITIVE 0x10
+#define GLYF_Y_SAME_OR_POSITIVE 0x20
+#define GLYF_OVERLAP_SIMPLE 0x40
+
+/* Each axis of each point has at most three encodings (same, short, long). */
+#define ENCODING_COUNT 9
+#define MAX_RUN 256
+
+/* Packed 'gvar' deltas use a byte when the value fits in a signed byte. */
+#define FITS_IN_BYTE(v) (((v) >= -128) && ((v) <= 127))
+
+/* Limits for the Type 2 charstring interpreter, from the Type 2 spec. */
+#define T2_MAX_NESTING 10
+#define T2_MAX_STACK 48
+
+/* Results of running a charstring. T2_DECLINE means the Python interpreter
+   in cffglyph.py should be used instead; T2_ERROR means a Python exception
+   has been set. */
+#define T2_OK 0
+#define T2_DECLINE 1
+#define T2_ERROR 2
+
+/* Limits for the subroutinizer. Subr numbers have to fit the largest bias;
+   each subr costs its return operator and (at most) a 3-byte INDEX offset,
+   and a call is guessed to cost 3 bytes until the subrs have numbers. */
+#define SUBR_MAX_COUNT 65535
+#define SUBR_OVERHEAD 4
+#define SUBR_CALL_GUESS 3
+
+/* --------------------------------------------------------------------------------------------- */
+
+/*** TYPES ***/
+
+struct EncodingState
+    {
+    long            cost;
+    long            runLength;
+    unsigned char   prevState;
+    unsigned char   filler[3];
+    };
+
+#ifndef __cplusplus
+typedef struct EncodingState EncodingState;
+#endif
+
+struct T2State
+    {
+    long            stack[T2_MAX_STACK];
+    long            seac[4];
+    long            *points;        /* x, y pairs */
+    long            *starts;        /* index of each contour's first point */
+    unsigned char   *flags;         /* 1 for on-curve points */
+    PyObject        *localSubrs;    /* NULL if there aren't any */
+    PyObject        *globalSubrs;
+    Py_ssize_t      pointCount;
+    Py_ssize_t      pointCapacity;
+    long            contourCount;
+    long            contourCapacity;
+    long            curX;
+    long            curY;
+    long            stemCount;
+    long            width;
+    int             stackCount;
+    int             haveWidth;
+    int             haveSeac;
+    
+    /* When flattening, the charstring is copied out with its subroutine
+       calls inlined, one token (operand, or operator with its mask bytes)
+       at a time, along with the stack depth before each token. */
+    
+    unsigned char   *flat;
+    unsigned char   *depths;
+    Py_ssize_t      *tokens;        /* start of each token in flat */
+    Py_ssize_t      flatCount;
+    Py_ssize_t      flatCapacity;
+    Py_ssize_t      tokenCount;
+    Py_ssize_t      tokenCapacity;
+    int             flatten;
+    };
+
+#ifndef __cplusplus
+typedef struct T2State T2State;
+#endif
+
+struct SubrCandidate
+    {
+    long            savings;        /* estimated bytes saved */
+    long            size;           /* bytes in one occurrence */
+    Py_ssize_t      parseStart;     /* body's parse in SubrState.parse */
+    Py_ssize_t      parseStop;
+    int             start;          /* position of one occurrence */
+    int             length;         /* in tokens */
+    int             first;          /* suffix array interval of the occurrences */
+    int             last;
+    int             leadLength;     /* operands before the first operator */
+    int             maxStartDepth;  /* deepest stack at any occurrence */
+    int             index;          /* subr number, or -1 if not used */
+    int             callCost;
+    int             nesting;
+    int             usage;
+    };
+
+#ifndef __cplusplus
+typedef struct SubrCandidate SubrCandidate;
+#endif
+
+struct SubrState
+    {
+    SubrCandidate   *candidates;
+    long            *cost;          /* cheapest encoding from each position */
+    long            *sizeBefore;    /* bytes before each position */
+    int             *choice;        /* candidate called at each position, or -1 */
+    int             *heads;         /* first occurrence at each position, or -1 */
+    int             *nextOccurrence;
+    int             *occurrenceCandidate;
+    int             *order;         /* candidates from shortest to longest */
+    int             *tokenAt;       /* token at each position, or -1 between charstrings */
+    int             *parse;         /* position of a token, or -(candidate + 1) */
+    Py_ssize_t      *parseStarts;   /* each charstring's parse in parse */
+    Py_ssize_t      *positions;     /* each charstring's first position */
+    Py_ssize_t      parseCount;
+    Py_ssize_t      parseCapacity;
+    T2State         *t2;
+    int             candidateCount;
+    int             charstringCount;
+    int             subrCount;
+    };
+
+#ifndef __cplusplus
+typedef struct SubrState SubrState;
+#endif
+
+/* --------------------------------------------------------------------------------------------- */
+
 /*** PROTOTYPES ***/
 
 static unsigned long CalcSizeFromFormat(const char *format, unsigned long *itemCount);
+static int CoordinateOptions(long delta, unsigned char shortBit, unsigned char sameBit, unsigned char *flags, int *sizes);
+static long GetCoordinate(const Py_buffer *buffer, Py_ssize_t index);
 static unsigned long GetNextRepeat(char **format);
+static long *LongsFromSequence(PyObject *obj, Py_ssize_t *count);
+static PyObject *MakeArray(const char *typeCode, const void *v, Py_ssize_t byteCount);
+static int PutCoordinate(unsigned char **walk, long delta, unsigned char flag, unsigned char shortBit, unsigned char sameBit);
+static Py_ssize_t PutDictReal(unsigned char *walk, double v);
+static int SubrAppendParse(SubrState *t, int start, int stop);
+static long SubrBias(int count);
+static int SubrCompareCandidates(const void *a, const void *b);
+static int SubrCompareKeys(const void *a, const void *b);
+static PyObject *SubrEmit(SubrState *t, Py_ssize_t parseStart, Py_ssize_t parseStop, int isSubr);
+static int SubrFindCandidates(SubrState *t, const int *seq, int n, clock_t deadline);
+static void SubrFreeState(SubrState *t);
+static int SubrNumber(SubrState *t, int final);
+static int SubrNumberSize(long v);
+static int SubrNumberTokens(SubrState *t, int *seq);
+static void SubrParse(SubrState *t, int start, int stop, int self);
+static int SubrPass(SubrState *t);
+static int SubrSuffixArray(const int *seq, int n, int *sa, clock_t deadline);
+static int T2AddToken(T2State *s, const unsigned char *start, Py_ssize_t len, int depth);
+static int T2AppendPoint(T2State *s, long x, long y, int onCurve);
+static int T2CallSubr(T2State *s, PyObject *subrs, int depth, int mustExist);
+static int T2Curve(T2State *s, long dxa, long dya, long dxb, long dyb, long dxc, long dyc);
+static void T2FreeState(T2State *s);
+static int T2MoveTo(T2State *s, long dx, long dy);
+static int T2NewContour(T2State *s);
+static int T2Run(T2State *s, const unsigned char *walk, Py_ssize_t len, int depth);
+static int T2StartPath(T2State *s);
+static void T2TakeWidth(T2State *s, int *n);
 
 static PyObject *ut_Checksum(PyObject *self, PyObject *args);
+static PyObject *ut_DecodeCharstring(PyObject *self, PyObject *args);
+static PyObject *ut_DecodeDict(PyObject *self, PyObject *args);
+static PyObject *ut_EncodeDictOperands(PyObject *self, PyObject *args);
+static PyObject *ut_EncodeSimpleGlyph(PyObject *self, PyObject *args);
 static PyObject *ut_Explode(PyObject *self, PyObject *args);
 static PyObject *ut_Implode(PyObject *self, PyObject *args);
+static PyObject *ut_IndexOffsets(PyObject *self, PyObject *args);
 static PyObject *ut_Pack(PyObject *self, PyObject *args);
+static PyObject *ut_PackDeltas(PyObject *self, PyObject *args);
+static PyObject *ut_PackPoints(PyObject *self, PyObject *args);
+static PyObject *ut_Subroutinize(PyObject *self, PyObject *args);
 
 /* --------------------------------------------------------------------------------------------- */
 
@@ -26,9 +206,17 @@ static PyObject *ut_Pack(PyObject *self, PyObject *args);
 
 static PyMethodDef UtilitiesMethods[] = {
     {"utChecksum", ut_Checksum, METH_VARARGS, NULL},
+    {"utDecodeCharstring", ut_DecodeCharstring, METH_VARARGS, NULL},
+    {"utDecodeDict", ut_DecodeDict, METH_VARARGS, NULL},
+    {"utEncodeDictOperands", ut_EncodeDictOperands, METH_VARARGS, NULL},
+    {"utEncodeSimpleGlyph", ut_EncodeSimpleGlyph, METH_VARARGS, NULL},
     {"utExplode", ut_Explode, METH_VARARGS, NULL},
     {"utImplode", ut_Implode, METH_VARARGS, NULL},
+    {"utIndexOffsets", ut_IndexOffsets, METH_VARARGS, NULL},
     {"utPack", ut_Pack, METH_VARARGS, NULL},
+    {"utPackDeltas", ut_PackDeltas, METH_VARARGS, NULL},
+    {"utPackPoints", ut_PackPoints, METH_VARARGS, NULL},
+    {"utSubroutinize", ut_Subroutinize, METH_VARARGS, NULL},
     {NULL, NULL, 0, NULL}};
 
 /* --------------------------------------------------------------------------------------------- */
@@ -127,6 +315,45 @@ static unsigned long CalcSizeFromFormat(const char *format, unsigned long *itemC
 
 /* --------------------------------------------------------------------------------------------- */
 
+static int CoordinateOptions(long delta, unsigned char shortBit, unsigned char sameBit, unsigned char *flags, int *sizes)
+    {
+    int     count = 0;
+    
+    /* The options are listed cheapest first, so ties go to the usual encoding. */
+    if (!delta)
+        {
+        flags[count] = sameBit;
+        sizes[count++] = 0;
+        }
+    
+    if ((delta > -256) && (delta < 256))
+        {
+        flags[count] = (unsigned char) (shortBit | ((delta >= 0) ? sameBit : 0));
+        sizes[count++] = 1;
+        }
+    
+    flags[count] = 0;
+    sizes[count++] = 2;
+    return count;
+    }  /* CoordinateOptions */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static long GetCoordinate(const Py_buffer *buffer, Py_ssize_t index)
+    {
+    const char  *p = (const char *) buffer->buf + index * buffer->itemsize;
+    
+    if (buffer->itemsize == 2)
+        return *(const short *) p;
+    
+    if (buffer->itemsize == 4)
+        return *(const int *) p;
+    
+    return *(const long long *) p;
+    }  /* GetCoordinate */
+
+/* --------------------------------------------------------------------------------------------- */
+
 static unsigned long GetNextRepeat(char **format)
     {
     int             done = 0;
@@ -208,70 +435,2092 @@ static unsigned long GetNextRepeat(char **format)
             }
         }
     
-    return repeat;
-    }  /* GetNextRepeat */
+    return repeat;
+    }  /* GetNextRepeat */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static long *LongsFromSequence(PyObject *obj, Py_ssize_t *count)
+    {
+    long        *retVal;
+    PyObject    *seq;
+    Py_ssize_t  i;
+    
+    seq = PySequence_Fast(obj, "Expected a sequence of integers!");
+    require(seq, BadReturn);
+    *count = PySequence_Fast_GET_SIZE(seq);
+    retVal = PyMem_Malloc((*count + 1) * sizeof(long));
+    require_action(retVal, FreeSeq, PyErr_NoMemory(););
+    
+    for (i = 0; i < *count; i += 1)
+        {
+        retVal[i] = PyLong_AsLong(PySequence_Fast_GET_ITEM(seq, i));
+        require(!((retVal[i] == -1) && PyErr_Occurred()), FreeRetVal);
+        }
+    
+    Py_DECREF(seq);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    FreeRetVal: PyMem_Free(retVal);
+    FreeSeq:    Py_DECREF(seq);
+    BadReturn:  return NULL;
+    }  /* LongsFromSequence */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static PyObject *MakeArray(const char *typeCode, const void *v, Py_ssize_t byteCount)
+    {
+    /* Returns a new array.array of the given type code holding a copy of
+       byteCount bytes from v. */
+    
+    PyObject    *arrayModule, *bytes, *retVal;
+    
+    arrayModule = PyImport_ImportModule("array");
+    require(arrayModule, BadReturn);
+    bytes = PyBytes_FromStringAndSize((const char *) v, byteCount);
+    require(bytes, FreeModule);
+    retVal = PyObject_CallMethod(arrayModule, "array", "sO", typeCode, bytes);
+    require(retVal, FreeBytes);
+    
+    Py_DECREF(bytes);
+    Py_DECREF(arrayModule);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    FreeBytes:  Py_DECREF(bytes);
+    FreeModule: Py_DECREF(arrayModule);
+    BadReturn:  return NULL;
+    }  /* MakeArray */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int PutCoordinate(unsigned char **walk, long delta, unsigned char flag, unsigned char shortBit, unsigned char sameBit)
+    {
+    if (flag & shortBit)
+        *(*walk)++ = (unsigned char) labs(delta);
+    
+    else if (!(flag & sameBit))
+        {
+        require_action(
+          (delta >= -32768) && (delta <= 32767),
+          BadReturn,
+          PyErr_SetString(PyExc_ValueError, "Coordinate delta does not fit in 16 bits!"););
+        
+        *(*walk)++ = (unsigned char) ((delta >> 8) & 0xFF);
+        *(*walk)++ = (unsigned char) (delta & 0xFF);
+        }
+    
+    return 0;
+    
+    /*** ERROR HANDLERS ***/
+    BadReturn:  return -1;
+    }  /* PutCoordinate */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static Py_ssize_t PutDictReal(unsigned char *walk, double v)
+    {
+    /* Writes v as a DICT real number (at most 14 bytes), using the shortest
+       repr that reads back as v, without leading zeros in the mantissa or a
+       trailing ".0", and with the exponent's sign and leading zeros dealt
+       with. Returns the number of bytes written, or -1 with an exception
+       set if v isn't finite. */
+    
+    char            *p, *s;
+    int             count = 0, i;
+    unsigned char   nybbles[32];
+    
+    require_action(
+      Py_IS_FINITE(v),
+      BadReturn,
+      PyErr_SetString(PyExc_ValueError, "DICT real numbers must be finite!"););
+    
+    s = PyOS_double_to_string(v, 'r', 0, 0, NULL);
+    require(s, BadReturn);
+    p = s;
+    
+    if (*p == '-')
+        {
+        nybbles[count++] = 0xE;
+        p += 1;
+        }
+    
+    /* Drop the ".0" repr adds to integral values, then a leading zero. */
+    
+    for (i = 0; p[i] && (p[i] != 'e'); i += 1)
+        ;
+    
+    if ((i >= 2) && (p[i - 2] == '.') && (p[i - 1] == '0'))
+        memmove(p + i - 2, p + i, strlen(p + i) + 1);
+    
+    if ((p[0] == '0') && p[1] && (p[1] != 'e'))
+        p += 1;
+    
+    for ( ; *p && (*p != 'e'); p += 1)
+        nybbles[count++] = ((*p == '.') ? 0xA : (unsigned char) (*p - '0'));
+    
+    if (*p == 'e')
+        {
+        p += 1;
+        nybbles[count++] = ((*p == '-') ? 0xC : 0xB);
+        p += ((*p == '-') || (*p == '+'));
+        
+        while ((*p == '0') && p[1])
+            p += 1;
+        
+        for ( ; *p; p += 1)
+            nybbles[count++] = (unsigned char) (*p - '0');
+        }
+    
+    PyMem_Free(s);
+    
+    /* The end is marked with 0xF, and a second one fills out the byte. */
+    
+    nybbles[count++] = 0xF;
+    
+    if (count & 1)
+        nybbles[count++] = 0xF;
+    
+    *walk++ = 30;
+    
+    for (i = 0; i < count; i += 2)
+        *walk++ = (unsigned char) ((nybbles[i] << 4) | nybbles[i + 1]);
+    
+    return 1 + count / 2;
+    
+    /*** ERROR HANDLERS ***/
+    BadReturn:  return -1;
+    }  /* PutDictReal */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int SubrAppendParse(SubrState *t, int start, int stop)
+    {
+    /* Adds the encoding SubrParse chose for the positions from start up to
+       stop to t->parse: a position for each token copied as it is, and
+       -(candidate + 1) for each call. */
+    
+    int         err, p, *newParse;
+    Py_ssize_t  newCapacity;
+    
+    if (t->parseCount + (stop - start) > t->parseCapacity)
+        {
+        newCapacity = 2 * t->parseCapacity + (stop - start) + 1024;
+        newParse = PyMem_Realloc(t->parse, newCapacity * sizeof(int));
+        require_action(newParse, Exit, err = T2_ERROR; PyErr_NoMemory(););
+        t->parse = newParse;
+        t->parseCapacity = newCapacity;
+        }
+    
+    for (p = start; p < stop; )
+        {
+        if (t->choice[p] < 0)
+            t->parse[t->parseCount++] = p++;
+        
+        else
+            {
+            t->parse[t->parseCount++] = -(t->choice[p] + 1);
+            p += t->candidates[t->choice[p]].length;
+            }
+        }
+    
+    return T2_OK;
+    
+    /*** ERROR HANDLERS ***/
+    Exit:   return err;
+    }  /* SubrAppendParse */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static long SubrBias(int count)
+    {
+    return ((count < 1240) ? 107 : ((count < 33900) ? 1131 : 32768));
+    }  /* SubrBias */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int SubrCompareCandidates(const void *a, const void *b)
+    {
+    /* Sorts candidates by decreasing savings, then by position. */
+    
+    const SubrCandidate *ca = (const SubrCandidate *) a, *cb = (const SubrCandidate *) b;
+    
+    if (ca->savings != cb->savings)
+        return ((ca->savings > cb->savings) ? -1 : 1);
+    
+    return ((ca->start < cb->start) ? -1 : (ca->start > cb->start));
+    }  /* SubrCompareCandidates */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int SubrCompareKeys(const void *a, const void *b)
+    {
+    /* Sorts keys in decreasing order. */
+    
+    long long   ka = *(const long long *) a, kb = *(const long long *) b;
+    
+    return ((ka > kb) ? -1 : (ka < kb));
+    }  /* SubrCompareKeys */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static PyObject *SubrEmit(SubrState *t, Py_ssize_t parseStart, Py_ssize_t parseStop, int isSubr)
+    {
+    /* Returns a new bytes object with the charstring (or, if isSubr is set,
+       the subroutine, ending with return) for a range of t->parse. */
+    
+    int             c, item, token;
+    long            bias = SubrBias(t->subrCount), v;
+    Py_ssize_t      i, size = isSubr;
+    PyObject        *retVal;
+    unsigned char   *walk;
+    T2State         *s = t->t2;
+    
+    for (i = parseStart; i < parseStop; i += 1)
+        {
+        item = t->parse[i];
+        
+        if (item >= 0)
+            size += t->sizeBefore[item + 1] - t->sizeBefore[item];
+        else
+            size += SubrNumberSize(t->candidates[-item - 1].index - bias) + 1;
+        }
+    
+    retVal = PyBytes_FromStringAndSize(NULL, size);
+    require(retVal, BadReturn);
+    walk = (unsigned char *) PyBytes_AS_STRING(retVal);
+    
+    for (i = parseStart; i < parseStop; i += 1)
+        {
+        item = t->parse[i];
+        
+        if (item >= 0)
+            {
+            token = t->tokenAt[item];
+            memcpy(walk, s->flat + s->tokens[token], s->tokens[token + 1] - s->tokens[token]);
+            walk += s->tokens[token + 1] - s->tokens[token];
+            continue;
+            }
+        
+        c = -item - 1;
+        v = t->candidates[c].index - bias;
+        
+        if ((v >= -107) && (v <= 107))
+            *walk++ = (unsigned char) (v + 139);
+        
+        else if ((v >= 108) && (v <= 1131))
+            {
+            *walk++ = (unsigned char) (((v - 108) >> 8) + 247);
+            *walk++ = (unsigned char) ((v - 108) & 0xFF);
+            }
+        
+        else if ((v >= -1131) && (v <= -108))
+            {
+            *walk++ = (unsigned char) (((-v - 108) >> 8) + 251);
+            *walk++ = (unsigned char) ((-v - 108) & 0xFF);
+            }
+        
+        else
+            {
+            *walk++ = 28;
+            *walk++ = (unsigned char) ((v >> 8) & 0xFF);
+            *walk++ = (unsigned char) (v & 0xFF);
+            }
+        
+        *walk++ = 29;  /* callgsubr */
+        }
+    
+    if (isSubr)
+        *walk++ = 11;  /* return */
+    
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    BadReturn:  return NULL;
+    }  /* SubrEmit */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int SubrFindCandidates(SubrState *t, const int *seq, int n, clock_t deadline)
+    {
+    /* Finds the runs of tokens worth making into subrs. Every repeated run
+       is an interval of the suffix array sharing a common prefix (found from
+       the LCP array with a stack); each is kept as a candidate if its guessed
+       savings are positive, and the best SUBR_MAX_COUNT of those are given
+       occurrence lists and numbered in order of savings. */
+    
+    int             c, capacity = 0, count, err, e, first, h, i, j, length, occurrenceCount;
+    int             top, *endsBefore = NULL, *lcp = NULL, *sa = NULL, *stackFirst = NULL, *stackLcp = NULL;
+    long            savings, size;
+    long long       *keys;
+    SubrCandidate   *candidate, *newCandidates;
+    T2State         *s = t->t2;
+    
+    sa = PyMem_New(int, n);
+    endsBefore = PyMem_New(int, n + 1);
+    lcp = PyMem_New(int, n + 1);
+    require_action(sa && endsBefore && lcp, Exit, err = T2_ERROR; PyErr_NoMemory(););
+    err = SubrSuffixArray(seq, n, sa, deadline);
+    require_noerr(err, Exit);
+    
+    /* Kasai's algorithm, using endsBefore for the inverse suffix array
+       until it's needed for itself. */
+    
+    for (i = 0; i < n; i += 1)
+        endsBefore[sa[i]] = i;
+    
+    lcp[0] = 0;
+    
+    for (i = 0, h = 0; i < n; i += 1)
+        {
+        if (!endsBefore[i])
+            {
+            h = 0;
+            continue;
+            }
+        
+        j = sa[endsBefore[i] - 1];
+        
+        while ((i + h < n) && (j + h < n) && (seq[i + h] == seq[j + h]))
+            h += 1;
+        
+        lcp[endsBefore[i]] = h;
+        h -= (h > 0);
+        }
+    
+    /* Runs can't include endchar, since a subr has to end with return. */
+    
+    endsBefore[0] = 0;
+    
+    for (i = 0; i < n; i += 1)
+        endsBefore[i + 1] = endsBefore[i] + ((t->tokenAt[i] >= 0) && (s->flat[s->tokens[t->tokenAt[i]]] == 14));
+    
+    stackFirst = PyMem_New(int, n + 1);
+    stackLcp = PyMem_New(int, n + 1);
+    require_action(stackFirst && stackLcp, Exit, err = T2_ERROR; PyErr_NoMemory(););
+    top = 0;
+    stackFirst[0] = stackLcp[0] = 0;
+    
+    for (i = 1; i <= n; i += 1)
+        {
+        h = ((i < n) ? lcp[i] : 0);
+        first = i - 1;
+        
+        while (h < stackLcp[top])
+            {
+            first = stackFirst[top];
+            length = stackLcp[top--];
+            j = sa[first];
+            
+            if (endsBefore[j + length] != endsBefore[j])
+                continue;
+            
+            size = t->sizeBefore[j + length] - t->sizeBefore[j];
+            savings = (long) (i - first) * (size - SUBR_CALL_GUESS) - (size + SUBR_OVERHEAD);
+            
+            if (savings <= 0)
+                continue;
+            
+            if (t->candidateCount == capacity)
+                {
+                capacity = 2 * capacity + 1024;
+                newCandidates = PyMem_Realloc(t->candidates, capacity * sizeof(SubrCandidate));
+                require_action(newCandidates, Exit, err = T2_ERROR; PyErr_NoMemory(););
+                t->candidates = newCandidates;
+                }
+            
+            candidate = t->candidates + t->candidateCount++;
+            memset(candidate, 0, sizeof(SubrCandidate));
+            candidate->savings = savings;
+            candidate->size = size;
+            candidate->start = j;
+            candidate->length = length;
+            candidate->first = first;
+            candidate->last = i - 1;
+            }
+        
+        if (h > stackLcp[top])
+            {
+            stackFirst[++top] = first;
+            stackLcp[top] = h;
+            }
+        }
+    
+    require_action(clock() < deadline, Exit, err = T2_DECLINE;);
+    qsort(t->candidates, t->candidateCount, sizeof(SubrCandidate), SubrCompareCandidates);
+    
+    /* Keep the best candidates, as long as their occurrence lists stay a
+       reasonable size. */
+    
+    for (c = 0, occurrenceCount = 0; c < t->candidateCount; c += 1)
+        {
+        count = t->candidates[c].last - t->candidates[c].first + 1;
+        
+        if ((c == SUBR_MAX_COUNT) || (occurrenceCount + count > 4 * n))
+            break;
+        
+        occurrenceCount += count;
+        }
+    
+    t->candidateCount = t->subrCount = c;
+    t->heads = PyMem_New(int, n);
+    t->nextOccurrence = PyMem_New(int, occurrenceCount + 1);
+    t->occurrenceCandidate = PyMem_New(int, occurrenceCount + 1);
+    t->order = PyMem_New(int, t->candidateCount + 1);
+    keys = PyMem_New(long long, t->candidateCount + 1);
+    require_action(t->heads && t->nextOccurrence && t->occurrenceCandidate && t->order && keys, FreeKeys, err = T2_ERROR; PyErr_NoMemory(););
+    
+    for (i = 0; i < n; i += 1)
+        t->heads[i] = -1;
+    
+    for (c = 0, e = 0; c < t->candidateCount; c += 1)
+        {
+        candidate = t->candidates + c;
+        candidate->index = c;
+        
+        for (j = candidate->first; j <= candidate->last; j += 1)
+            {
+            i = s->depths[t->tokenAt[sa[j]]];
+            candidate->maxStartDepth = ((i > candidate->maxStartDepth) ? i : candidate->maxStartDepth);
+            t->nextOccurrence[e] = t->heads[sa[j]];
+            t->occurrenceCandidate[e] = c;
+            t->heads[sa[j]] = e++;
+            }
+        
+        for (i = candidate->start; i < candidate->start + candidate->length; i += 1)
+            {
+            h = s->flat[s->tokens[t->tokenAt[i]]];
+            
+            if ((h < 32) && (h != 28))
+                break;
+            }
+        
+        candidate->leadLength = i - candidate->start;
+        keys[c] = ((long long) candidate->length << 32) | (0xFFFFFFFFLL - c);
+        }
+    
+    /* Bodies are parsed from the shortest up, so the subrs they call have
+       already been parsed. */
+    
+    qsort(keys, t->candidateCount, sizeof(long long), SubrCompareKeys);
+    
+    for (c = 0; c < t->candidateCount; c += 1)
+        t->order[t->candidateCount - 1 - c] = (int) (0xFFFFFFFFLL - (keys[c] & 0xFFFFFFFFLL));
+    
+    err = T2_OK;
+    
+    /*** ERROR HANDLERS ***/
+    FreeKeys:   PyMem_Free(keys);
+    Exit:       PyMem_Free(sa);
+                PyMem_Free(endsBefore);
+                PyMem_Free(lcp);
+                PyMem_Free(stackFirst);
+                PyMem_Free(stackLcp);
+                return err;
+    }  /* SubrFindCandidates */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void SubrFreeState(SubrState *t)
+    {
+    PyMem_Free(t->candidates);
+    PyMem_Free(t->cost);
+    PyMem_Free(t->sizeBefore);
+    PyMem_Free(t->choice);
+    PyMem_Free(t->heads);
+    PyMem_Free(t->nextOccurrence);
+    PyMem_Free(t->occurrenceCandidate);
+    PyMem_Free(t->order);
+    PyMem_Free(t->tokenAt);
+    PyMem_Free(t->parse);
+    PyMem_Free(t->parseStarts);
+    PyMem_Free(t->positions);
+    }  /* SubrFreeState */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int SubrNumber(SubrState *t, int final)
+    {
+    /* Renumbers the subrs worth keeping after a pass, most used first, so
+       the most common calls get the shortest numbers. Until the final pass
+       a subr has to save more than it costs; after it, a subr only has to be
+       used, since the parses are final. */
+    
+    int             c, count = 0, keep;
+    long long       *keys;
+    SubrCandidate   *candidate;
+    
+    keys = PyMem_New(long long, t->candidateCount + 1);
+    require_action(keys, BadReturn, PyErr_NoMemory(););
+    
+    for (c = 0; c < t->candidateCount; c += 1)
+        {
+        candidate = t->candidates + c;
+        
+        if (candidate->index < 0)
+            continue;
+        
+        if (final)
+            keep = (candidate->usage > 0);
+        else
+            keep = ((long) candidate->usage * (candidate->size - candidate->callCost) > candidate->size + SUBR_OVERHEAD);
+        
+        if (keep)
+            keys[count++] = ((long long) candidate->usage << 32) | (0xFFFFFFFFLL - c);
+        
+        candidate->index = -1;
+        }
+    
+    qsort(keys, count, sizeof(long long), SubrCompareKeys);
+    
+    for (c = 0; c < count; c += 1)
+        t->candidates[0xFFFFFFFFLL - (keys[c] & 0xFFFFFFFFLL)].index = c;
+    
+    t->subrCount = count;
+    PyMem_Free(keys);
+    return T2_OK;
+    
+    /*** ERROR HANDLERS ***/
+    BadReturn:  return T2_ERROR;
+    }  /* SubrNumber */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int SubrNumberSize(long v)
+    {
+    /* Returns the size of the charstring operand for v. */
+    
+    if ((v >= -107) && (v <= 107))
+        return 1;
+    
+    return (((v >= -1131) && (v <= 1131)) ? 2 : 3);
+    }  /* SubrNumberSize */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int SubrNumberTokens(SubrState *t, int *seq)
+    {
+    /* Gives each distinct token an id, and the end of each charstring an id
+       of its own (so no run crosses from one to the next), filling in seq,
+       t->tokenAt and t->sizeBefore. Returns the number of ids, or -1 if
+       memory runs out. */
+    
+    int             g, id = 0, *ids, p, token, *table;
+    unsigned long   hash;
+    Py_ssize_t      i, len, mask, tableSize = 1;
+    T2State         *s = t->t2;
+    
+    while (tableSize < 2 * s->tokenCount)
+        tableSize <<= 1;
+    
+    mask = tableSize - 1;
+    table = PyMem_New(int, tableSize);
+    require_action(table, BadReturn, PyErr_NoMemory(););
+    ids = PyMem_New(int, s->tokenCount);
+    require_action(ids, FreeTable, PyErr_NoMemory(););
+    
+    for (i = 0; i < tableSize; i += 1)
+        table[i] = -1;
+    
+    for (token = 0; token < s->tokenCount; token += 1)
+        {
+        len = s->tokens[token + 1] - s->tokens[token];
+        
+        for (i = 0, hash = 2166136261UL; i < len; i += 1)
+            hash = (hash ^ s->flat[s->tokens[token] + i]) * 16777619UL;
+        
+        for (i = hash & mask; table[i] >= 0; i = (i + 1) & mask)
+            {
+            p = table[i];
+            
+            if ((s->tokens[p + 1] - s->tokens[p] == len) && !memcmp(s->flat + s->tokens[p], s->flat + s->tokens[token], len))
+                break;
+            }
+        
+        if (table[i] < 0)
+            {
+            table[i] = token;
+            ids[token] = id++;
+            }
+        
+        else
+            ids[token] = ids[table[i]];
+        }
+    
+    t->sizeBefore[0] = 0;
+    
+    for (g = 0; g < t->charstringCount; g += 1)
+        {
+        for (p = (int) t->positions[g]; p < t->positions[g + 1] - 1; p += 1)
+            {
+            token = p - g;
+            seq[p] = ids[token];
+            t->tokenAt[p] = token;
+            t->sizeBefore[p + 1] = t->sizeBefore[p] + (long) (s->tokens[token + 1] - s->tokens[token]);
+            }
+        
+        seq[p] = id + g;
+        t->tokenAt[p] = -1;
+        t->sizeBefore[p + 1] = t->sizeBefore[p];
+        }
+    
+    PyMem_Free(ids);
+    PyMem_Free(table);
+    return id + t->charstringCount;
+    
+    /*** ERROR HANDLERS ***/
+    FreeTable:  PyMem_Free(table);
+    BadReturn:  return -1;
+    }  /* SubrNumberTokens */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void SubrParse(SubrState *t, int start, int stop, int self)
+    {
+    /* Finds the cheapest encoding of the positions from start up to stop
+       with the numbered subrs, leaving the choice at each position in
+       t->choice. If self isn't -1 this is that candidate's body, which may
+       only call shorter subrs that leave room for its own nesting. */
+    
+    int             depth, e, p;
+    long            cost;
+    SubrCandidate   *candidate, *body = ((self >= 0) ? t->candidates + self : NULL);
+    
+    t->cost[stop] = 0;
+    
+    for (p = stop - 1; p >= start; p -= 1)
+        {
+        t->choice[p] = -1;
+        t->cost[p] = t->cost[p + 1] + (t->sizeBefore[p + 1] - t->sizeBefore[p]);
+        
+        /* A call pushes the subr number, so the stack needs room for it. A
+           body's leading operands go on top of whatever the stack held at
+           its deepest occurrence. */
+        
+        if (body && (p - start <= body->leadLength))
+            depth = body->maxStartDepth + (p - start);
+        else
+            depth = t->t2->depths[t->tokenAt[p]];
+        
+        if (depth >= T2_MAX_STACK)
+            continue;
+        
+        for (e = t->heads[p]; e >= 0; e = t->nextOccurrence[e])
+            {
+            candidate = t->candidates + t->occurrenceCandidate[e];
+            
+            if ((candidate->index < 0) || (p + candidate->length > stop))
+                continue;
+            
+            if (body && ((candidate->length >= body->length) || (candidate->nesting >= T2_MAX_NESTING)))
+                continue;
+            
+            cost = candidate->callCost + t->cost[p + candidate->length];
+            
+            if (cost < t->cost[p])
+                {
+                t->cost[p] = cost;
+                t->choice[p] = t->occurrenceCandidate[e];
+                }
+            }
+        }
+    }  /* SubrParse */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int SubrPass(SubrState *t)
+    {
+    /* Parses every numbered subr's body and every charstring with the
+       current numbers, then counts how often each subr is called from the
+       charstrings and from the bodies of subrs that are themselves called. */
+    
+    int             c, err, g, i;
+    long            bias = SubrBias(t->subrCount);
+    Py_ssize_t      k;
+    SubrCandidate   *callee, *candidate;
+    
+    for (c = 0; c < t->candidateCount; c += 1)
+        {
+        candidate = t->candidates + c;
+        candidate->usage = 0;
+        
+        if (candidate->index >= 0)
+            candidate->callCost = SubrNumberSize(candidate->index - bias) + 1;
+        }
+    
+    t->parseCount = 0;
+    
+    for (i = 0; i < t->candidateCount; i += 1)
+        {
+        candidate = t->candidates + t->order[i];
+        
+        if (candidate->index < 0)
+            continue;
+        
+        SubrParse(t, candidate->start, candidate->start + candidate->length, t->order[i]);
+        candidate->parseStart = t->parseCount;
+        err = SubrAppendParse(t, candidate->start, candidate->start + candidate->length);
+        require_noerr(err, Exit);
+        candidate->parseStop = t->parseCount;
+        candidate->nesting = 1;
+        
+        for (k = candidate->parseStart; k < candidate->parseStop; k += 1)
+            {
+            if (t->parse[k] < 0)
+                {
+                callee = t->candidates + (-t->parse[k] - 1);
+                candidate->nesting = ((callee->nesting >= candidate->nesting) ? callee->nesting + 1 : candidate->nesting);
+                }
+            }
+        }
+    
+    for (g = 0; g < t->charstringCount; g += 1)
+        {
+        SubrParse(t, (int) t->positions[g], (int) t->positions[g + 1] - 1, -1);
+        t->parseStarts[g] = t->parseCount;
+        err = SubrAppendParse(t, (int) t->positions[g], (int) t->positions[g + 1] - 1);
+        require_noerr(err, Exit);
+        }
+    
+    t->parseStarts[g] = t->parseCount;
+    
+    for (k = t->parseStarts[0]; k < t->parseCount; k += 1)
+        {
+        if (t->parse[k] < 0)
+            t->candidates[-t->parse[k] - 1].usage += 1;
+        }
+    
+    /* Longer bodies only call shorter ones, so going from the longest down
+       finishes each subr's count before its own calls are counted. */
+    
+    for (i = t->candidateCount - 1; i >= 0; i -= 1)
+        {
+        candidate = t->candidates + t->order[i];
+        
+        if ((candidate->index < 0) || !candidate->usage)
+            continue;
+        
+        for (k = candidate->parseStart; k < candidate->parseStop; k += 1)
+            {
+            if (t->parse[k] < 0)
+                t->candidates[-t->parse[k] - 1].usage += 1;
+            }
+        }
+    
+    return T2_OK;
+    
+    /*** ERROR HANDLERS ***/
+    Exit:   return err;
+    }  /* SubrPass */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int SubrSuffixArray(const int *seq, int n, int *sa, clock_t deadline)
+    {
+    /* Sorts the suffixes of seq (whose values are all less than n) into sa
+       by prefix doubling, with a counting sort on each round. Returns
+       T2_DECLINE if the deadline passes first. */
+    
+    int     a, b, err, i, k, maxRank = n - 1, r, *counts, *rank, *swap, *tmp;
+    
+    counts = PyMem_New(int, n + 1);
+    rank = PyMem_New(int, n);
+    tmp = PyMem_New(int, n);
+    require_action(counts && rank && tmp, Exit, err = T2_ERROR; PyErr_NoMemory(););
+    memset(counts, 0, (n + 1) * sizeof(int));
+    
+    for (i = 0; i < n; i += 1)
+        {
+        rank[i] = seq[i];
+        counts[seq[i] + 1] += 1;
+        }
+    
+    for (i = 0; i < n; i += 1)
+        counts[i + 1] += counts[i];
+    
+    for (i = 0; i < n; i += 1)
+        sa[counts[seq[i]]++] = i;
+    
+    for (k = 1; k < n; k <<= 1)
+        {
+        require_action(clock() < deadline, Exit, err = T2_DECLINE;);
+        
+        /* Order by the rank k further on (suffixes too short to have one
+           come first), then stable sort by the rank here. */
+        
+        for (i = n - k, r = 0; i < n; i += 1)
+            tmp[r++] = i;
+        
+        for (i = 0; i < n; i += 1)
+            {
+            if (sa[i] >= k)
+                tmp[r++] = sa[i] - k;
+            }
+        
+        memset(counts, 0, (maxRank + 2) * sizeof(int));
+        
+        for (i = 0; i < n; i += 1)
+            counts[rank[i] + 1] += 1;
+        
+        for (i = 0; i <= maxRank; i += 1)
+            counts[i + 1] += counts[i];
+        
+        for (i = 0; i < n; i += 1)
+            sa[counts[rank[tmp[i]]]++] = tmp[i];
+        
+        tmp[sa[0]] = r = 0;
+        
+        for (i = 1; i < n; i += 1)
+            {
+            a = sa[i - 1];
+            b = sa[i];
+            
+            if ((rank[a] != rank[b]) || (((a + k < n) ? rank[a + k] : -1) != ((b + k < n) ? rank[b + k] : -1)))
+                r += 1;
+            
+            tmp[b] = r;
+            }
+        
+        swap = rank;
+        rank = tmp;
+        tmp = swap;
+        maxRank = r;
+        
+        if (maxRank == n - 1)
+            break;
+        }
+    
+    err = T2_OK;
+    
+    /*** ERROR HANDLERS ***/
+    Exit:   PyMem_Free(counts);
+            PyMem_Free(rank);
+            PyMem_Free(tmp);
+            return err;
+    }  /* SubrSuffixArray */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int T2AddToken(T2State *s, const unsigned char *start, Py_ssize_t len, int depth)
+    {
+    /* Copies one token to the flattened output. There's always room for one
+       more token start, so the end of the last token can be recorded. */
+    
+    int             err;
+    unsigned char   *newDepths, *newFlat;
+    Py_ssize_t      *newTokens;
+    
+    if (s->tokenCount + 1 >= s->tokenCapacity)
+        {
+        s->tokenCapacity = 2 * s->tokenCapacity + 256;
+        newTokens = PyMem_Realloc(s->tokens, s->tokenCapacity * sizeof(Py_ssize_t));
+        require_action(newTokens, Exit, err = T2_ERROR; PyErr_NoMemory(););
+        s->tokens = newTokens;
+        newDepths = PyMem_Realloc(s->depths, s->tokenCapacity);
+        require_action(newDepths, Exit, err = T2_ERROR; PyErr_NoMemory(););
+        s->depths = newDepths;
+        }
+    
+    if (s->flatCount + len > s->flatCapacity)
+        {
+        s->flatCapacity = 2 * s->flatCapacity + len + 1024;
+        newFlat = PyMem_Realloc(s->flat, s->flatCapacity);
+        require_action(newFlat, Exit, err = T2_ERROR; PyErr_NoMemory(););
+        s->flat = newFlat;
+        }
+    
+    memcpy(s->flat + s->flatCount, start, len);
+    s->tokens[s->tokenCount] = s->flatCount;
+    s->depths[s->tokenCount++] = (unsigned char) depth;
+    s->flatCount += len;
+    return T2_OK;
+    
+    /*** ERROR HANDLERS ***/
+    Exit:   return err;
+    }  /* T2AddToken */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int T2AppendPoint(T2State *s, long x, long y, int onCurve)
+    {
+    /* Adds a point to the current contour (starting one if there are none
+       yet) and makes it the current point, as _appendPoint does in
+       cffglyph.py. After a seac, _buildGlyph drops its contours but not its
+       contour count, so anything drawn later is left to it. */
+    
+    int             err;
+    long            *newPoints;
+    unsigned char   *newFlags;
+    Py_ssize_t      newCapacity;
+    
+    if (s->flatten)
+        return T2_OK;
+    
+    require_action(!s->haveSeac, Exit, err = T2_DECLINE;);
+    
+    if (!s->contourCount)
+        {
+        err = T2NewContour(s);
+        require_noerr(err, Exit);
+        }
+    
+    if (s->pointCount == s->pointCapacity)
+        {
+        newCapacity = 2 * s->pointCapacity + 64;
+        newPoints = PyMem_Realloc(s->points, 2 * newCapacity * sizeof(long));
+        require_action(newPoints, Exit, err = T2_ERROR; PyErr_NoMemory(););
+        s->points = newPoints;
+        newFlags = PyMem_Realloc(s->flags, newCapacity);
+        require_action(newFlags, Exit, err = T2_ERROR; PyErr_NoMemory(););
+        s->flags = newFlags;
+        s->pointCapacity = newCapacity;
+        }
+    
+    s->points[2 * s->pointCount] = x;
+    s->points[2 * s->pointCount + 1] = y;
+    s->flags[s->pointCount++] = (unsigned char) onCurve;
+    s->curX = x;
+    s->curY = y;
+    return T2_OK;
+    
+    /*** ERROR HANDLERS ***/
+    Exit:   return err;
+    }  /* T2AppendPoint */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int T2CallSubr(T2State *s, PyObject *subrs, int depth, int mustExist)
+    {
+    /* Pops a biased subroutine number and runs that subroutine. A number
+       outside the subrs is skipped, unless mustExist is set (which is how
+       callgsubr behaves in cffglyph.py, where it raises an exception). */
+    
+    int         err;
+    long        index;
+    Py_buffer   buffer;
+    Py_ssize_t  count;
+    PyObject    *subr;
+    
+    require_action(s->stackCount && (depth < T2_MAX_NESTING), Exit, err = T2_DECLINE;);
+    count = PySequence_Size(subrs);
+    require_action(count >= 0, Exit, err = T2_ERROR;);
+    index = s->stack[--s->stackCount] + ((count < 1240) ? 107 : ((count < 33900) ? 1131 : 32768));
+    
+    if ((index < 0) || (index >= count))
+        return (mustExist ? T2_DECLINE : T2_OK);
+    
+    subr = PySequence_GetItem(subrs, index);
+    require_action(subr, Exit, err = T2_ERROR;);
+    err = PyObject_GetBuffer(subr, &buffer, PyBUF_SIMPLE);
+    require_action(!err, FreeSubr, err = T2_ERROR;);
+    
+    err = T2Run(s, (const unsigned char *) buffer.buf, buffer.len, depth + 1);
+    
+    PyBuffer_Release(&buffer);
+    Py_DECREF(subr);
+    return err;
+    
+    /*** ERROR HANDLERS ***/
+    FreeSubr:   Py_DECREF(subr);
+    Exit:       return err;
+    }  /* T2CallSubr */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int T2Curve(T2State *s, long dxa, long dya, long dxb, long dyb, long dxc, long dyc)
+    {
+    /* Adds a curve as two off-curve points and an on-curve point, each
+       relative to the one before. */
+    
+    int err;
+    
+    err = T2AppendPoint(s, s->curX + dxa, s->curY + dya, 0);
+    require_noerr(err, Exit);
+    err = T2AppendPoint(s, s->curX + dxb, s->curY + dyb, 0);
+    require_noerr(err, Exit);
+    err = T2AppendPoint(s, s->curX + dxc, s->curY + dyc, 1);
+    
+    /*** ERROR HANDLERS ***/
+    Exit:   return err;
+    }  /* T2Curve */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int T2MoveTo(T2State *s, long dx, long dy)
+    {
+    /* Starts a new contour at the current point moved by (dx, dy). A
+       previous contour with just one point gets that point again, as in
+       cffglyph.py. */
+    
+    int err;
+    
+    if (s->contourCount && (s->pointCount - s->starts[s->contourCount - 1] == 1))
+        {
+        err = T2AppendPoint(s, s->curX, s->curY, 1);
+        require_noerr(err, Exit);
+        }
+    
+    err = T2NewContour(s);
+    require_noerr(err, Exit);
+    err = T2AppendPoint(s, s->curX + dx, s->curY + dy, 1);
+    
+    /*** ERROR HANDLERS ***/
+    Exit:   return err;
+    }  /* T2MoveTo */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int T2NewContour(T2State *s)
+    {
+    int     err;
+    long    *newStarts;
+    
+    if (s->contourCount == s->contourCapacity)
+        {
+        s->contourCapacity = 2 * s->contourCapacity + 8;
+        newStarts = PyMem_Realloc(s->starts, s->contourCapacity * sizeof(long));
+        require_action(newStarts, Exit, err = T2_ERROR; PyErr_NoMemory(););
+        s->starts = newStarts;
+        }
+    
+    s->starts[s->contourCount++] = (long) s->pointCount;
+    return T2_OK;
+    
+    /*** ERROR HANDLERS ***/
+    Exit:   return err;
+    }  /* T2NewContour */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void T2FreeState(T2State *s)
+    {
+    PyMem_Free(s->points);
+    PyMem_Free(s->flags);
+    PyMem_Free(s->starts);
+    PyMem_Free(s->flat);
+    PyMem_Free(s->depths);
+    PyMem_Free(s->tokens);
+    }  /* T2FreeState */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int T2Run(T2State *s, const unsigned char *walk, Py_ssize_t len, int depth)
+    {
+    /* Runs one charstring (or subroutine) against the state in s, following
+       _buildGlyph in cffglyph.py. Returns T2_DECLINE for anything _buildGlyph
+       would have to deal with itself: arithmetic and storage operators,
+       fractional operands, and data it would raise an exception for. When
+       flattening, fractional operands are copied as they are, since only
+       their count matters there. */
+    
+    const unsigned char *end = walk + len, *start;
+    int                 err = T2_OK, i, k, n, opDepth, sawOperand = 0, toggle;
+    long                *a = s->stack, d, v, xStart, yStart;
+    unsigned char       b0, b1;
+    
+    while (walk < end)
+        {
+        start = walk;
+        b0 = *walk++;
+        
+        /* Operands */
+        
+        if ((b0 >= 32) || (b0 == 28))
+            {
+            require(s->stackCount < T2_MAX_STACK, Decline);
+            
+            if (b0 == 28)
+                {
+                require(end - walk >= 2, Decline);
+                v = (short) ((walk[0] << 8) | walk[1]);
+                walk += 2;
+                }
+            
+            else if (b0 <= 246)
+                v = (long) b0 - 139;
+            
+            else if (b0 == 255)
+                {
+                /* 16.16 fixed; _buildGlyph keeps these as floats */
+                
+                require(s->flatten && (end - walk >= 4), Decline);
+                v = (short) ((walk[0] << 8) | walk[1]);
+                walk += 4;
+                }
+            
+            else
+                {
+                require(walk < end, Decline);
+                b1 = *walk++;
+                v = ((b0 < 251) ? ((b0 - 247) * 256 + b1 + 108) : ((251 - b0) * 256 - b1 - 108));
+                }
+            
+            if (s->flatten)
+                {
+                err = T2AddToken(s, start, walk - start, s->stackCount);
+                require_noerr(err, Exit);
+                }
+            
+            a[s->stackCount++] = v;
+            sawOperand = 1;
+            continue;
+            }
+        
+        n = opDepth = s->stackCount;
+        sawOperand = 0;
+        
+        /* A flattened subroutine call loses the operand with its number,
+           which has to be the last token copied. */
+        
+        if (s->flatten && ((b0 == 10) || (b0 == 29)))
+            {
+            require(s->tokenCount, Decline);
+            b1 = s->flat[s->tokens[s->tokenCount - 1]];
+            require((b1 >= 32) || (b1 == 28), Decline);
+            s->flatCount = s->tokens[--s->tokenCount];
+            }
+        
+        switch (b0)
+            {
+            /* Hint operators */
+            
+            case 1:     /* hstem */
+            case 3:     /* vstem */
+            case 18:    /* hstemhm */
+            case 23:    /* vstemhm */
+            case 19:    /* hintmask */
+            case 20:    /* cntrmask */
+                if ((n & 1) && !s->haveWidth)
+                    T2TakeWidth(s, &n);
+                
+                s->stemCount += n / 2;
+                
+                if ((b0 == 19) || (b0 == 20))
+                    {
+                    /* The mask follows the operator, one bit per stem. */
+                    
+                    require(end - walk >= (s->stemCount + 7) / 8, Decline);
+                    walk += (s->stemCount + 7) / 8;
+                    }
+                
+                break;
+            
+            /* Path operators */
+            
+            case 21:    /* rmoveto */
+                require(n >= 2, Decline);
+                
+                if (n > 2)
+                    T2TakeWidth(s, &n);
+                
+                err = T2MoveTo(s, a[0], a[1]);
+                break;
+            
+            case 22:    /* hmoveto */
+            case 4:     /* vmoveto */
+                require(n >= 1, Decline);
+                
+                if (n > 1)
+                    T2TakeWidth(s, &n);
+                
+                err = ((b0 == 22) ? T2MoveTo(s, a[0], 0) : T2MoveTo(s, 0, a[0]));
+                break;
+            
+            case 5:     /* rlineto */
+                require(!(n & 1), Decline);
+                err = T2StartPath(s);
+                
+                for (i = 0; !err && (i < n); i += 2)
+                    err = T2AppendPoint(s, s->curX + a[i], s->curY + a[i + 1], 1);
+                
+                break;
+            
+            case 6:     /* hlineto */
+            case 7:     /* vlineto */
+                err = T2StartPath(s);
+                
+                /* Lines alternate direction, starting horizontally for
+                   hlineto and vertically for vlineto. */
+                
+                for (i = 0; !err && (i < n); i += 1)
+                    {
+                    if (((i & 1) == 0) == (b0 == 6))
+                        err = T2AppendPoint(s, s->curX + a[i], s->curY, 1);
+                    else
+                        err = T2AppendPoint(s, s->curX, s->curY + a[i], 1);
+                    }
+                
+                break;
+            
+            case 8:     /* rrcurveto */
+                require(!(n % 6), Decline);
+                err = T2StartPath(s);
+                
+                for (i = 0; !err && (i < n); i += 6)
+                    err = T2Curve(s, a[i], a[i + 1], a[i + 2], a[i + 3], a[i + 4], a[i + 5]);
+                
+                break;
+            
+            case 27:    /* hhcurveto */
+            case 26:    /* vvcurveto */
+                require((n % 4) < 2, Decline);
+                err = T2StartPath(s);
+                k = n % 4;
+                d = (k ? a[0] : 0);
+                
+                for (i = k; !err && (i < n); i += 4, d = 0)
+                    {
+                    if (b0 == 27)
+                        err = T2Curve(s, a[i], d, a[i + 1], a[i + 2], a[i + 3], 0);
+                    else
+                        err = T2Curve(s, d, a[i], a[i + 1], a[i + 2], 0, a[i + 3]);
+                    }
+                
+                break;
+            
+            case 31:    /* hvcurveto */
+            case 30:    /* vhcurveto */
+                require((n % 4) < 2, Decline);
+                err = T2StartPath(s);
+                k = n - (n % 4);
+                toggle = (b0 == 31);
+                
+                for (i = 0; !err && (i < k); i += 4, toggle = !toggle)
+                    {
+                    d = (((i + 4 == k) && (n % 4)) ? a[k] : 0);
+                    
+                    if (toggle)
+                        err = T2Curve(s, a[i], 0, a[i + 1], a[i + 2], d, a[i + 3]);
+                    else
+                        err = T2Curve(s, 0, a[i], a[i + 1], a[i + 2], a[i + 3], d);
+                    }
+                
+                break;
+            
+            case 24:    /* rcurveline */
+                require((n >= 2) && !((n - 2) % 6), Decline);
+                err = T2StartPath(s);
+                
+                for (i = 0; !err && (i < n - 2); i += 6)
+                    err = T2Curve(s, a[i], a[i + 1], a[i + 2], a[i + 3], a[i + 4], a[i + 5]);
+                
+                if (!err)
+                    err = T2AppendPoint(s, s->curX + a[n - 2], s->curY + a[n - 1], 1);
+                
+                break;
+            
+            case 25:    /* rlinecurve */
+                require((n >= 6) && !(n & 1), Decline);
+                err = T2StartPath(s);
+                
+                for (i = 0; !err && (i < n - 6); i += 2)
+                    err = T2AppendPoint(s, s->curX + a[i], s->curY + a[i + 1], 1);
+                
+                if (!err)
+                    err = T2Curve(s, a[i], a[i + 1], a[i + 2], a[i + 3], a[i + 4], a[i + 5]);
+                
+                break;
+            
+            case 14:    /* endchar */
+                if (n & 1)
+                    T2TakeWidth(s, &n);
+                
+                if (n == 4)
+                    {
+                    /* The remaining operands are from seac: adx, ady, bchar
+                       and achar. The caller looks up the components. */
+                    
+                    for (i = 0; i < 4; i += 1)
+                        s->seac[i] = a[i];
+                    
+                    s->haveSeac = 1;
+                    }
+                
+                else if (s->contourCount && !s->haveSeac && (s->pointCount - s->starts[s->contourCount - 1] == 1))
+                    err = T2AppendPoint(s, s->curX, s->curY, 1);
+                
+                break;
+            
+            case 12:    /* escape */
+                require(walk < end, Decline);
+                b1 = *walk++;
+                xStart = s->curX;
+                yStart = s->curY;
+                
+                if (b1 == 34)  /* hflex */
+                    {
+                    require(n >= 7, Decline);
+                    err = T2AppendPoint(s, s->curX + a[0], yStart, 0);
+                    err = err ? err : T2AppendPoint(s, s->curX + a[1], s->curY + a[2], 0);
+                    err = err ? err : T2AppendPoint(s, s->curX + a[3], s->curY, 1);
+                    err = err ? err : T2AppendPoint(s, s->curX + a[4], s->curY, 0);
+                    err = err ? err : T2AppendPoint(s, s->curX + a[5], yStart, 0);
+                    err = err ? err : T2AppendPoint(s, s->curX + a[6], yStart, 1);
+                    }
+                
+                else if (b1 == 35)  /* flex */
+                    {
+                    require(n >= 12, Decline);
+                    err = T2Curve(s, a[0], a[1], a[2], a[3], a[4], a[5]);
+                    err = err ? err : T2Curve(s, a[6], a[7], a[8], a[9], a[10], a[11]);
+                    }
+                
+                else if (b1 == 36)  /* hflex1 */
+                    {
+                    require(n >= 9, Decline);
+                    err = T2Curve(s, a[0], a[1], a[2], a[3], a[4], 0);
+                    err = err ? err : T2AppendPoint(s, s->curX + a[5], s->curY, 0);
+                    err = err ? err : T2AppendPoint(s, s->curX + a[6], s->curY + a[7], 0);
+                    err = err ? err : T2AppendPoint(s, s->curX + a[8], yStart, 1);
+                    }
+                
+                else if (b1 == 37)  /* flex1 */
+                    {
+                    /* The last operand is a delta along whichever axis the
+                       earlier deltas moved further. Like _buildGlyph, this
+                       sums every operand but the last (or last two, for y),
+                       so extra operands are treated the same way. */
+                    
+                    require(n >= 11, Decline);
+                    err = T2Curve(s, a[0], a[1], a[2], a[3], a[4], a[5]);
+                    err = err ? err : T2AppendPoint(s, s->curX + a[6], s->curY + a[7], 0);
+                    err = err ? err : T2AppendPoint(s, s->curX + a[8], s->curY + a[9], 0);
+                    
+                    for (i = 0, d = 0; i < n - 2; i += 2)
+                        d += a[i];
+                    
+                    for (i = 1, v = 0; i < n - 1; i += 2)
+                        v += a[i];
+                    
+                    if (!err && (labs(d) > labs(v)))
+                        err = T2AppendPoint(s, s->curX + a[10], yStart, 1);
+                    else if (!err)
+                        err = T2AppendPoint(s, xStart, s->curY + a[10], 1);
+                    }
+                
+                else
+                    goto Decline;
+                
+                break;
+            
+            /* Subroutine operators; these leave the rest of the stack alone. */
+            
+            case 10:    /* callsubr */
+                require(s->localSubrs, Decline);
+                err = T2CallSubr(s, s->localSubrs, depth, 0);
+                require_noerr(err, Exit);
+                continue;
+            
+            case 29:    /* callgsubr */
+                err = T2CallSubr(s, s->globalSubrs, depth, 1);
+                require_noerr(err, Exit);
+                continue;
+            
+            case 11:    /* return */
+                continue;
+            
+            default:
+                goto Decline;
+            }
+        
+        require_noerr(err, Exit);
+        
+        if (s->flatten)
+            {
+            err = T2AddToken(s, start, walk - start, opDepth);
+            require_noerr(err, Exit);
+            }
+        
+        s->stackCount = 0;
+        }
+    
+    /* _buildGlyph loses the stack when a subroutine ends with operands
+       rather than an operator, which inlining couldn't reproduce. */
+    
+    if (sawOperand)
+        {
+        require(!(s->flatten && depth), Decline);
+        s->stackCount = 0;
+        }
+    
+    return T2_OK;
+    
+    /*** ERROR HANDLERS ***/
+    Decline:    return T2_DECLINE;
+    Exit:       return err;
+    }  /* T2Run */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int T2StartPath(T2State *s)
+    {
+    /* Line and curve operators start from the current point if no contour
+       has been started yet (or a seac dropped them). */
+    
+    if (s->contourCount && !s->haveSeac)
+        return T2_OK;
+    
+    return T2AppendPoint(s, s->curX, s->curY, 1);
+    }  /* T2StartPath */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void T2TakeWidth(T2State *s, int *n)
+    {
+    /* Removes the width from the bottom of the stack. */
+    
+    s->width = s->stack[0];
+    s->haveWidth = 1;
+    *n -= 1;
+    s->stackCount = *n;
+    memmove(s->stack, s->stack + 1, *n * sizeof(long));
+    }  /* T2TakeWidth */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/*** INTERFACE PROCEDURES ***/
+
+static PyObject *ut_Checksum(PyObject *self, PyObject *args)
+    {
+    int                 err;
+    Py_buffer           buffer;
+    Py_ssize_t          len;
+    PyObject            *obj, *retVal;
+    const unsigned char *walk;
+    unsigned char       d[4], *p;
+    unsigned long       checksum = 0;
+    
+    err = !PyArg_ParseTuple(args, "O", &obj);
+    require_noerr(err, BadReturn);
+    
+    require_action(
+      PyObject_CheckBuffer(obj),
+      BadReturn,
+      PyErr_SetString(
+        PyExc_ValueError,
+        "Checksum requires a bytes or bytearray object!"););
+    
+    err = PyObject_GetBuffer(obj, &buffer, PyBUF_SIMPLE);
+    require_noerr(err, BadReturn);
+    
+    len = buffer.len;
+    walk = (const unsigned char *) buffer.buf;
+    
+    while (len >= 4)
+        {
+        /* The following code works regardless of endianness. */
+        d[0] = *walk++;
+        d[1] = *walk++;
+        d[2] = *walk++;
+        d[3] = *walk++;
+        checksum += ((d[0] << 24UL) + (d[1] << 16UL) + (d[2] << 8UL) + d[3]);
+        len -= 4;
+        }
+    
+    if (len)
+        {
+        d[1] = d[2] = d[3] = 0;  /* d[0] will be used if len > 0 */
+        p = d;
+        
+        while (len--)
+            *p++ = *walk++;
+        
+        checksum += ((d[0] << 24UL) + (d[1] << 16UL) + (d[2] << 8UL) + d[3]);
+        }
+    
+    PyBuffer_Release(&buffer);
+    retVal = Py_BuildValue("k", checksum & 0xFFFFFFFFUL);
+    require(retVal, BadReturn);
+    
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    BadReturn:  return NULL;
+    }  /* ut_Checksum */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static PyObject *ut_DecodeCharstring(PyObject *self, PyObject *args)
+    {
+    /* Given a Type 2 charstring, its local subrs (a sequence of bytes
+       objects, or None if there aren't any) and the global subrs, runs the
+       charstring and returns a tuple with five elements:
+       
+           points       array('l') of interleaved x and y coordinates
+           flags        bytes with 1 for each on-curve point, 0 otherwise
+           ends         array('l') of the index of each contour's last point
+           width        the width operand (without nominalWidthX), or None
+           seac         (adx, ady, bchar, achar) from an endchar, or None
+       
+       Returns None instead if the charstring needs something only the
+       Python interpreter in cffglyph.py handles. */
+    
+    int         err;
+    long        i;
+    Py_buffer   buffer;
+    PyObject    *charstringObj, *globalObj, *localObj, *retVal, *seacObj, *widthObj;
+    T2State     s;
+    
+    require(PyArg_ParseTuple(args, "OOO", &charstringObj, &localObj, &globalObj), BadReturn);
+    err = PyObject_GetBuffer(charstringObj, &buffer, PyBUF_SIMPLE);
+    require_noerr(err, BadReturn);
+    
+    memset(&s, 0, sizeof(s));
+    s.localSubrs = ((localObj == Py_None) ? NULL : localObj);
+    s.globalSubrs = globalObj;
+    err = T2Run(&s, (const unsigned char *) buffer.buf, buffer.len, 0);
+    PyBuffer_Release(&buffer);
+    require(err != T2_ERROR, FreeState);
+    
+    if (err == T2_DECLINE)
+        {
+        Py_INCREF(Py_None);
+        retVal = Py_None;
+        }
+    
+    else
+        {
+        /* Turn each contour's first point index into its last one. */
+        
+        for (i = 0; i < s.contourCount; i += 1)
+            s.starts[i] = ((i + 1 < s.contourCount) ? s.starts[i + 1] : (long) s.pointCount) - 1;
+        
+        if (s.haveWidth)
+            widthObj = PyLong_FromLong(s.width);
+        else
+            {
+            Py_INCREF(Py_None);
+            widthObj = Py_None;
+            }
+        
+        if (s.haveSeac)
+            seacObj = Py_BuildValue("(llll)", s.seac[0], s.seac[1], s.seac[2], s.seac[3]);
+        else
+            {
+            Py_INCREF(Py_None);
+            seacObj = Py_None;
+            }
+        
+        /* Py_BuildValue releases the "N" objects if any of them is NULL. */
+        
+        retVal = Py_BuildValue(
+          "(NNNNN)",
+          MakeArray("l", s.points, 2 * s.pointCount * (Py_ssize_t) sizeof(long)),
+          PyBytes_FromStringAndSize((const char *) s.flags, s.pointCount),
+          MakeArray("l", s.starts, s.contourCount * (Py_ssize_t) sizeof(long)),
+          widthObj,
+          seacObj);
+        
+        require(retVal, FreeState);
+        }
+    
+    T2FreeState(&s);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    FreeState:  T2FreeState(&s);
+    BadReturn:  return NULL;
+    }  /* ut_DecodeCharstring */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static PyObject *ut_DecodeDict(PyObject *self, PyObject *args)
+    {
+    /* Given the binary data for a CFF DICT, returns a tuple with two
+       elements:
+       
+           entries      a list of (operator, operands) pairs in order; the
+                        operator is an int, or a tuple (12, n) for an
+                        escaped one, and operands is a list of ints and
+                        floats
+           error        None, or a tuple (kind, value, operands) if the
+                        data couldn't be read to the end
+       
+       The kind in error is 1 for a reserved value (given as the value), 2
+       for data ending inside an operand or operator, or 3 for operands not
+       followed by an operator; its operands are those read since the last
+       operator. Real numbers are converted the same way as float(), so a
+       malformed one raises ValueError. */
+    
+    int                 b0, err, kind = 0, nybble, value = 0;
+    long                v;
+    double              d;
+    char                *real = NULL, *s;
+    Py_buffer           buffer;
+    PyObject            *entries, *entry, *key, *obj, *operand, *operands, *retVal;
+    const unsigned char *end, *walk;
+    static const char   *nybbleStrings[] = {"0", "1", "2", "3", "4", "5", "6", "7", "8", "9", ".", "E", "E-", "", "-", ""};
+    
+    require(PyArg_ParseTuple(args, "O", &obj), BadReturn);
+    err = PyObject_GetBuffer(obj, &buffer, PyBUF_SIMPLE);
+    require_noerr(err, BadReturn);
+    walk = (const unsigned char *) buffer.buf;
+    end = walk + buffer.len;
+    
+    /* Each byte of a real number adds at most four characters. */
+    
+    real = PyMem_Malloc(4 * buffer.len + 1);
+    require_action(real, FreeBuffer, PyErr_NoMemory(););
+    entries = PyList_New(0);
+    require(entries, FreeReal);
+    operands = PyList_New(0);
+    require(operands, FreeEntries);
+    
+    while (walk < end)
+        {
+        b0 = *walk++;
+        
+        if (b0 < 22)
+            {
+            /* Operator */
+            
+            if (b0 == 12)
+                {
+                if (walk == end)
+                    {
+                    kind = 2;
+                    break;
+                    }
+                
+                key = Py_BuildValue("(ii)", 12, *walk++);
+                }
+            
+            else
+                key = PyLong_FromLong(b0);
+            
+            entry = Py_BuildValue("(NN)", key, operands);
+            require(entry, FreeEntries);
+            err = PyList_Append(entries, entry);
+            Py_DECREF(entry);
+            require_noerr(err, FreeEntries);
+            operands = PyList_New(0);
+            require(operands, FreeEntries);
+            continue;
+            }
+        
+        /* Operands */
+        
+        if (((b0 >= 22) && (b0 <= 27)) || (b0 == 31) || (b0 == 255))
+            {
+            kind = 1;
+            value = b0;
+            break;
+            }
+        
+        if (b0 >= 32)
+            {
+            if (b0 <= 246)
+                v = b0 - 139;
+            
+            else if (walk == end)
+                {
+                kind = 2;
+                break;
+                }
+            
+            else
+                {
+                v = ((b0 < 251) ? ((b0 - 247) * 256 + *walk + 108) : ((251 - b0) * 256 - *walk - 108));
+                walk += 1;
+                }
+            }
+        
+        else if (b0 == 28)
+            {
+            if (end - walk < 2)
+                {
+                kind = 2;
+                break;
+                }
+            
+            v = (short) ((walk[0] << 8) | walk[1]);
+            walk += 2;
+            }
+        
+        else if (b0 == 29)
+            {
+            if (end - walk < 4)
+                {
+                kind = 2;
+                break;
+                }
+            
+            v = (long) (int) (((unsigned long) walk[0] << 24) | ((unsigned long) walk[1] << 16) | ((unsigned long) walk[2] << 8) | walk[3]);
+            walk += 4;
+            }
+        
+        else
+            {
+            /* A real number, in nybbles, ending with 0xF. */
+            
+            for (s = real, nybble = 0; !kind; nybble ^= 1)
+                {
+                if (!nybble && (walk == end))
+                    kind = 2;
+                else
+                    {
+                    v = (nybble ? (*walk++ & 0xF) : (*walk >> 4));
+                    
+                    if (v == 15)
+                        {
+                        walk += !nybble;
+                        break;
+                        }
+                    
+                    if (v == 13)
+                        {
+                        kind = 1;
+                        value = 13;
+                        }
+                    
+                    else
+                        {
+                        strcpy(s, nybbleStrings[v]);
+                        s += strlen(nybbleStrings[v]);
+                        }
+                    }
+                }
+            
+            if (kind)
+                break;
+            
+            *s = 0;
+            d = PyOS_string_to_double(real, NULL, NULL);
+            require(!((d == -1.0) && PyErr_Occurred()), FreeOperands);
+            operand = PyFloat_FromDouble(d);
+            require(operand, FreeOperands);
+            err = PyList_Append(operands, operand);
+            Py_DECREF(operand);
+            require_noerr(err, FreeOperands);
+            continue;
+            }
+        
+        operand = PyLong_FromLong(v);
+        require(operand, FreeOperands);
+        err = PyList_Append(operands, operand);
+        Py_DECREF(operand);
+        require_noerr(err, FreeOperands);
+        }
+    
+    if (!kind && PyList_GET_SIZE(operands))
+        kind = 3;
+    
+    if (kind)
+        retVal = Py_BuildValue("(N(iiN))", entries, kind, value, operands);
+    else
+        {
+        Py_DECREF(operands);
+        retVal = Py_BuildValue("(NO)", entries, Py_None);
+        }
+    
+    require(retVal, FreeReal);
+    PyMem_Free(real);
+    PyBuffer_Release(&buffer);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    FreeOperands:   Py_DECREF(operands);
+    FreeEntries:    Py_DECREF(entries);
+    FreeReal:       PyMem_Free(real);
+    FreeBuffer:     PyBuffer_Release(&buffer);
+    BadReturn:      return NULL;
+    }  /* ut_DecodeDict */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static PyObject *ut_EncodeDictOperands(PyObject *self, PyObject *args)
+    {
+    /* Given a sequence of DICT operands (ints, and floats for real
+       numbers), returns a bytes object with them encoded, each in its
+       shortest form. */
+    
+    long            v;
+    Py_ssize_t      count, i, n;
+    PyObject        *obj, *operand, *retVal, *seq;
+    unsigned char   *buffer, *walk;
+    
+    require(PyArg_ParseTuple(args, "O", &obj), BadReturn);
+    seq = PySequence_Fast(obj, "Expected a sequence of DICT operands!");
+    require(seq, BadReturn);
+    count = PySequence_Fast_GET_SIZE(seq);
+    
+    /* An integer takes at most 5 bytes and a real at most 14. */
+    
+    buffer = PyMem_Malloc(14 * count + 1);
+    require_action(buffer, FreeSeq, PyErr_NoMemory(););
+    walk = buffer;
+    
+    for (i = 0; i < count; i += 1)
+        {
+        operand = PySequence_Fast_GET_ITEM(seq, i);
+        
+        if (PyFloat_Check(operand))
+            {
+            n = PutDictReal(walk, PyFloat_AS_DOUBLE(operand));
+            require(n >= 0, FreeBuffer);
+            walk += n;
+            continue;
+            }
+        
+        v = PyLong_AsLong(operand);
+        require(!((v == -1) && PyErr_Occurred()), FreeBuffer);
+        
+        if ((v >= -107) && (v <= 107))
+            *walk++ = (unsigned char) (v + 139);
+        
+        else if ((v >= 108) && (v <= 1131))
+            {
+            *walk++ = (unsigned char) (((v - 108) >> 8) + 247);
+            *walk++ = (unsigned char) ((v - 108) & 0xFF);
+            }
+        
+        else if ((v >= -1131) && (v <= -108))
+            {
+            *walk++ = (unsigned char) (((-v - 108) >> 8) + 251);
+            *walk++ = (unsigned char) ((-v - 108) & 0xFF);
+            }
+        
+        else if ((v >= -32768) && (v <= 32767))
+            {
+            *walk++ = 28;
+            *walk++ = (unsigned char) ((v >> 8) & 0xFF);
+            *walk++ = (unsigned char) (v & 0xFF);
+            }
+        
+        else
+            {
+            require_action(
+              (v >= -2147483647L - 1) && (v <= 2147483647L),
+              FreeBuffer,
+              PyErr_SetString(PyExc_OverflowError, "DICT integer out of range!"););
+            
+            *walk++ = 29;
+            *walk++ = (unsigned char) ((v >> 24) & 0xFF);
+            *walk++ = (unsigned char) ((v >> 16) & 0xFF);
+            *walk++ = (unsigned char) ((v >> 8) & 0xFF);
+            *walk++ = (unsigned char) (v & 0xFF);
+            }
+        }
+    
+    retVal = PyBytes_FromStringAndSize((const char *) buffer, walk - buffer);
+    require(retVal, FreeBuffer);
+    
+    PyMem_Free(buffer);
+    Py_DECREF(seq);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    FreeBuffer: PyMem_Free(buffer);
+    FreeSeq:    Py_DECREF(seq);
+    BadReturn:  return NULL;
+    }  /* ut_EncodeDictOperands */
 
 /* --------------------------------------------------------------------------------------------- */
 
-/*** INTERFACE PROCEDURES ***/
-
-static PyObject *ut_Checksum(PyObject *self, PyObject *args)
+static PyObject *ut_EncodeSimpleGlyph(PyObject *self, PyObject *args)
     {
-    int                 err;
-    Py_buffer           buffer;
-    Py_ssize_t          len;
-    PyObject            *obj, *retVal;
-    const unsigned char *walk;
-    unsigned char       d[4], *p;
-    unsigned long       checksum = 0;
+    /* Given arrays of absolute x and y coordinates (typecode 'h', 'i' or 'l') and a
+       buffer of on-curve bytes, returns a bytes object with the flags, xCoordinates
+       and yCoordinates of a simple glyph. The encoding of each point is chosen by
+       a dynamic program over the flag runs so the total size is minimal; ties go
+       to the usual greedy encoding. The extraFlags are ORed into every flag (e.g.
+       0x80 for the high bit), and if overlapSimple is nonzero the OVERLAP_SIMPLE
+       bit is set in the first flag. */
     
-    err = !PyArg_ParseTuple(args, "O", &obj);
+    int                 b, bestBucket, c, err, overlapSimple, pb, pc, sizes[2][3], counts[2];
+    long                bestCost, dx, dy, extraFlags, lastX = 0, lastY = 0;
+    Py_buffer           onBuffer, xBuffer, yBuffer;
+    Py_ssize_t          i, n, run;
+    PyObject            *onObj, *retVal, *xObj, *yObj;
+    EncodingState       (*states)[2][ENCODING_COUNT];
+    const unsigned char *on;
+    unsigned char       axisFlags[2][3], base, bestChoice, *choices, *out, *walk;
+    unsigned char       (*candFlags)[ENCODING_COUNT];
+    signed char         (*candSizes)[ENCODING_COUNT];
+    
+    err = !PyArg_ParseTuple(args, "OOOli", &xObj, &yObj, &onObj, &extraFlags, &overlapSimple);
+    require_noerr(err, BadReturn);
+    
+    err = PyObject_GetBuffer(xObj, &xBuffer, PyBUF_FORMAT);
     require_noerr(err, BadReturn);
+    err = PyObject_GetBuffer(yObj, &yBuffer, PyBUF_FORMAT);
+    require_noerr(err, FreeXBuffer);
+    err = PyObject_GetBuffer(onObj, &onBuffer, PyBUF_SIMPLE);
+    require_noerr(err, FreeYBuffer);
+    
+    n = xBuffer.len / xBuffer.itemsize;
     
     require_action(
-      PyObject_CheckBuffer(obj),
-      BadReturn,
+      xBuffer.format && strchr("hil", xBuffer.format[0]) &&
+      yBuffer.format && strchr("hil", yBuffer.format[0]) &&
+      (yBuffer.len / yBuffer.itemsize == n) &&
+      (onBuffer.len == n),
+      FreeOnBuffer,
       PyErr_SetString(
         PyExc_ValueError,
-        "Checksum requires a bytes or bytearray object!"););
+        "EncodeSimpleGlyph requires matching integer arrays and on-curve bytes!"););
     
-    err = PyObject_GetBuffer(obj, &buffer, PyBUF_SIMPLE);
-    require_noerr(err, BadReturn);
+    /* one block holds the DP states, the candidate flags and sizes, and the choices */
+    states = PyMem_Malloc((n + 1) * (sizeof(*states) + sizeof(*candFlags) + sizeof(*candSizes) + 1));
+    require_action(states, FreeOnBuffer, PyErr_NoMemory(););
+    candFlags = (unsigned char (*)[ENCODING_COUNT]) (states + n + 1);
+    candSizes = (signed char (*)[ENCODING_COUNT]) (candFlags + n + 1);
+    choices = (unsigned char *) (candSizes + n + 1);
+    on = (const unsigned char *) onBuffer.buf;
     
-    len = buffer.len;
-    walk = (const unsigned char *) buffer.buf;
+    for (i = 0; i < n; i += 1)
+        {
+        base = (unsigned char) ((on[i] ? GLYF_ON_CURVE : 0) | extraFlags);
+        
+        if (!i && overlapSimple)
+            base |= GLYF_OVERLAP_SIMPLE;
+        
+        dx = GetCoordinate(&xBuffer, i) - lastX;
+        dy = GetCoordinate(&yBuffer, i) - lastY;
+        lastX += dx;
+        lastY += dy;
+        counts[0] = CoordinateOptions(dx, GLYF_X_SHORT, GLYF_X_SAME_OR_POSITIVE, axisFlags[0], sizes[0]);
+        counts[1] = CoordinateOptions(dy, GLYF_Y_SHORT, GLYF_Y_SAME_OR_POSITIVE, axisFlags[1], sizes[1]);
+        
+        for (c = 0; c < ENCODING_COUNT; c += 1)
+            {
+            states[i][0][c].cost = states[i][1][c].cost = LONG_MAX;
+            
+            if (((c / 3) >= counts[0]) || ((c % 3) >= counts[1]))
+                {
+                candSizes[i][c] = -1;
+                continue;
+                }
+            
+            candFlags[i][c] = (unsigned char) (base | axisFlags[0][c / 3] | axisFlags[1][c % 3]);
+            candSizes[i][c] = (signed char) (sizes[0][c / 3] + sizes[1][c % 3]);
+            
+            if (!i)
+                {
+                states[i][0][c].cost = 1 + candSizes[i][c];
+                states[i][0][c].runLength = 1;
+                continue;
+                }
+            
+            for (pb = 0; pb < 2; pb += 1)
+                {
+                for (pc = 0; pc < ENCODING_COUNT; pc += 1)
+                    {
+                    const EncodingState *prev = &states[i - 1][pb][pc];
+                    long                cost = prev->cost + candSizes[i][c];
+                    
+                    if (prev->cost == LONG_MAX)
+                        continue;
+                    
+                    if ((candFlags[i - 1][pc] == candFlags[i][c]) && (prev->runLength < MAX_RUN))
+                        {  /* extend the run; its second point adds the repeat count byte */
+                        b = 1;
+                        cost += (pb ? 0 : 1);
+                        run = prev->runLength + 1;
+                        }
+                    
+                    else
+                        {
+                        b = 0;
+                        cost += 1;
+                        run = 1;
+                        }
+                    
+                    if (cost < states[i][b][c].cost)
+                        {
+                        states[i][b][c].cost = cost;
+                        states[i][b][c].runLength = (long) run;
+                        states[i][b][c].prevState = (unsigned char) (pb * ENCODING_COUNT + pc);
+                        }
+                    }
+                }
+            }
+        }
     
-    while (len >= 4)
+    bestCost = LONG_MAX;
+    bestBucket = 0;
+    bestChoice = 0;
+    
+    for (c = 0; n && (c < ENCODING_COUNT); c += 1)
         {
-        /* The following code works regardless of endianness. */
-        d[0] = *walk++;
-        d[1] = *walk++;
-        d[2] = *walk++;
-        d[3] = *walk++;
-        checksum += ((d[0] << 24UL) + (d[1] << 16UL) + (d[2] << 8UL) + d[3]);
-        len -= 4;
+        for (b = 0; b < 2; b += 1)
+            {
+            if (states[n - 1][b][c].cost < bestCost)
+                {
+                bestCost = states[n - 1][b][c].cost;
+                bestBucket = b;
+                bestChoice = (unsigned char) c;
+                }
+            }
         }
     
-    if (len)
+    for (i = n - 1; i >= 0; i -= 1)
         {
-        d[1] = d[2] = d[3] = 0;  /* d[0] will be used if len > 0 */
-        p = d;
+        unsigned char   prevState = states[i][bestBucket][bestChoice].prevState;
         
-        while (len--)
-            *p++ = *walk++;
+        choices[i] = bestChoice;
+        bestBucket = prevState / ENCODING_COUNT;
+        bestChoice = prevState % ENCODING_COUNT;
+        }
+    
+    out = PyMem_Malloc(5 * n + 1);
+    require_action(out, FreeStates, PyErr_NoMemory(););
+    walk = out;
+    
+    for (i = 0; i < n; i += run)
+        {
+        base = candFlags[i][choices[i]];
         
-        checksum += ((d[0] << 24UL) + (d[1] << 16UL) + (d[2] << 8UL) + d[3]);
+        for (run = 1; (i + run < n) && (run < MAX_RUN); run += 1)
+            {
+            if (candFlags[i + run][choices[i + run]] != base)
+                break;
+            }
+        
+        if (run > 1)
+            {
+            *walk++ = (unsigned char) (base | GLYF_REPEAT);
+            *walk++ = (unsigned char) (run - 1);
+            }
+        
+        else
+            *walk++ = base;
         }
     
-    PyBuffer_Release(&buffer);
-    retVal = Py_BuildValue("k", checksum & 0xFFFFFFFFUL);
-    require(retVal, BadReturn);
+    for (b = 0, lastX = 0; b < 2; b += 1, lastX = 0)
+        {
+        Py_buffer       *buffer = (b ? &yBuffer : &xBuffer);
+        unsigned char   shortBit = (b ? GLYF_Y_SHORT : GLYF_X_SHORT);
+        unsigned char   sameBit = (b ? GLYF_Y_SAME_OR_POSITIVE : GLYF_X_SAME_OR_POSITIVE);
+        
+        for (i = 0; i < n; i += 1)
+            {
+            dx = GetCoordinate(buffer, i) - lastX;
+            lastX += dx;
+            err = PutCoordinate(&walk, dx, candFlags[i][choices[i]], shortBit, sameBit);
+            require_noerr(err, FreeOut);
+            }
+        }
+    
+    retVal = PyBytes_FromStringAndSize((const char *) out, walk - out);
+    require(retVal, FreeOut);
     
+    PyMem_Free(out);
+    PyMem_Free(states);
+    PyBuffer_Release(&onBuffer);
+    PyBuffer_Release(&yBuffer);
+    PyBuffer_Release(&xBuffer);
     return retVal;
     
     /*** ERROR HANDLERS ***/
-    BadReturn:  return NULL;
-    }  /* ut_Checksum */
+    FreeOut:        PyMem_Free(out);
+    FreeStates:     PyMem_Free(states);
+    FreeOnBuffer:   PyBuffer_Release(&onBuffer);
+    FreeYBuffer:    PyBuffer_Release(&yBuffer);
+    FreeXBuffer:    PyBuffer_Release(&xBuffer);
+    BadReturn:      return NULL;
+    }  /* ut_EncodeSimpleGlyph */
 
 /* --------------------------------------------------------------------------------------------- */
 
@@ -400,6 +2649,66 @@ static PyObject *ut_Implode(PyObject *self, PyObject *args)
 
 /* --------------------------------------------------------------------------------------------- */
 
+static PyObject *ut_IndexOffsets(PyObject *self, PyObject *args)
+    {
+    /* Given the offset array of a CFF INDEX and its offSize (1 through 4),
+       returns an array.array('I') of the decoded offsets. The offsets must
+       never decrease, since each item's length is the difference between
+       its offset and the next one; this is checked in a single pass. */
+    
+    int                 err, offSize;
+    Py_buffer           buffer;
+    Py_ssize_t          i, n;
+    PyObject            *obj, *retVal;
+    const unsigned char *walk;
+    unsigned int        *offsets, v;
+    
+    err = !PyArg_ParseTuple(args, "Oi", &obj, &offSize);
+    require_noerr(err, BadReturn);
+    
+    require_action(
+      (offSize >= 1) && (offSize <= 4),
+      BadReturn,
+      PyErr_SetString(PyExc_ValueError, "Invalid INDEX offSize!"););
+    
+    err = PyObject_GetBuffer(obj, &buffer, PyBUF_SIMPLE);
+    require_noerr(err, BadReturn);
+    
+    n = buffer.len / offSize;
+    offsets = PyMem_Malloc((n ? n : 1) * sizeof(unsigned int));
+    require_action(offsets, FreeBuffer, PyErr_NoMemory(););
+    walk = (const unsigned char *) buffer.buf;
+    
+    for (i = 0; i < n; i += 1)
+        {
+        int     count = offSize;
+        
+        for (v = 0; count--; )
+            v = (v << 8) | *walk++;
+        
+        require_action(
+          !i || (v >= offsets[i - 1]),
+          FreeOffsets,
+          PyErr_SetString(PyExc_ValueError, "Offsets not sorted in INDEX!"););
+        
+        offsets[i] = v;
+        }
+    
+    retVal = MakeArray("I", offsets, n * (Py_ssize_t) sizeof(unsigned int));
+    require(retVal, FreeOffsets);
+    
+    PyMem_Free(offsets);
+    PyBuffer_Release(&buffer);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    FreeOffsets:    PyMem_Free(offsets);
+    FreeBuffer:     PyBuffer_Release(&buffer);
+    BadReturn:      return NULL;
+    }  /* ut_IndexOffsets */
+
+/* --------------------------------------------------------------------------------------------- */
+
 static PyObject *ut_Pack(PyObject *self, PyObject *args)
     {
     char            *format, *formatWalk;
@@ -874,6 +3183,339 @@ static PyObject *ut_Pack(PyObject *self, PyObject *args)
 
 /* --------------------------------------------------------------------------------------------- */
 
+static PyObject *ut_PackDeltas(PyObject *self, PyObject *args)
+    {
+    /* Given a sequence of integer deltas, returns a bytes object with them
+       packed as in a 'gvar' tuple: runs of up to 64 zeroes, bytes or words,
+       each led by a control byte. A lone zero among bytes, or a lone byte
+       value among words, is left in the run around it, since ending the run
+       there would cost a control byte without saving anything. */
+    
+    long            *deltas, v;
+    Py_ssize_t      i, n, run;
+    PyObject        *deltasObj, *retVal;
+    unsigned char   *out, *walk;
+    
+    require(PyArg_ParseTuple(args, "O", &deltasObj), BadReturn);
+    deltas = LongsFromSequence(deltasObj, &n);
+    require(deltas, BadReturn);
+    
+    for (i = 0; i < n; i += 1)
+        {
+        require_action(
+          (deltas[i] >= -32768) && (deltas[i] <= 32767),
+          FreeDeltas,
+          PyErr_SetString(PyExc_ValueError, "Delta does not fit in 16 bits!"););
+        }
+    
+    out = PyMem_Malloc(3 * n + 1);
+    require_action(out, FreeDeltas, PyErr_NoMemory(););
+    walk = out;
+    
+    for (i = 0; i < n; i += run)
+        {
+        if (!deltas[i])
+            {
+            for (run = 1; (i + run < n) && (run < 64) && !deltas[i + run]; run += 1)
+                ;
+            
+            *walk++ = (unsigned char) (0x80 | (run - 1));
+            continue;
+            }
+        
+        if (FITS_IN_BYTE(deltas[i]))
+            {
+            for (run = 1; (i + run < n) && (run < 64); run += 1)
+                {
+                v = deltas[i + run];
+                
+                if (!FITS_IN_BYTE(v) || (!v && (i + run + 1 < n) && !deltas[i + run + 1]))
+                    break;
+                }
+            
+            *walk++ = (unsigned char) (run - 1);
+            
+            for (v = 0; v < run; v += 1)
+                *walk++ = (unsigned char) (deltas[i + v] & 0xFF);
+            
+            continue;
+            }
+        
+        for (run = 1; (i + run < n) && (run < 64); run += 1)
+            {
+            v = deltas[i + run];
+            
+            if (!v || (FITS_IN_BYTE(v) && (i + run + 1 < n) && FITS_IN_BYTE(deltas[i + run + 1])))
+                break;
+            }
+        
+        *walk++ = (unsigned char) (0x40 | (run - 1));
+        
+        for (v = 0; v < run; v += 1)
+            {
+            *walk++ = (unsigned char) ((deltas[i + v] >> 8) & 0xFF);
+            *walk++ = (unsigned char) (deltas[i + v] & 0xFF);
+            }
+        }
+    
+    retVal = PyBytes_FromStringAndSize((const char *) out, walk - out);
+    
+    PyMem_Free(out);
+    PyMem_Free(deltas);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    FreeDeltas: PyMem_Free(deltas);
+    BadReturn:  return NULL;
+    }  /* ut_PackDeltas */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static PyObject *ut_PackPoints(PyObject *self, PyObject *args)
+    {
+    /* Given a sorted sequence of point indices and the glyph's total point
+       count (including the 4 phantom points), returns a bytes object with
+       them packed as in a 'gvar' tuple: a count, then runs of up to 128
+       index differences as bytes or words, each led by a control byte. If
+       the points are all of the glyph's points the special zero count is
+       used instead. */
+    
+    long            *points, v;
+    Py_ssize_t      i, n, pointCount, run;
+    PyObject        *pointsObj, *retVal;
+    unsigned char   *out, *walk;
+    
+    require(PyArg_ParseTuple(args, "On", &pointsObj, &pointCount), BadReturn);
+    points = LongsFromSequence(pointsObj, &n);
+    require(points, BadReturn);
+    require_action(n, FreePoints, PyErr_SetString(PyExc_ValueError, "No points to pack!"););
+    
+    for (i = 0; i < n; i += 1)
+        {
+        require_action(
+          (points[i] >= (i ? points[i - 1] + 1 : 0)),
+          FreePoints,
+          PyErr_SetString(PyExc_ValueError, "Point indices must be sorted and unique!"););
+        }
+    
+    require_action(
+      points[n - 1] < pointCount,
+      FreePoints,
+      PyErr_SetString(PyExc_ValueError, "Largest point index exceeds glyph's count!"););
+    
+    require_action(n < 32768, FreePoints, PyErr_SetString(PyExc_ValueError, "Too many points to pack!"););
+    
+    if (n == pointCount)
+        {
+        PyMem_Free(points);
+        return PyBytes_FromStringAndSize("", 1);
+        }
+    
+    out = PyMem_Malloc(3 * n + 2);
+    require_action(out, FreePoints, PyErr_NoMemory(););
+    walk = out;
+    
+    if (n < 128)
+        *walk++ = (unsigned char) n;
+    
+    else
+        {
+        *walk++ = (unsigned char) (0x80 | (n >> 8));
+        *walk++ = (unsigned char) (n & 0xFF);
+        }
+    
+    /* The runs hold the differences between successive indices, the first
+       one being taken from zero. */
+    
+    for (i = n - 1; i > 0; i -= 1)
+        points[i] -= points[i - 1];
+    
+    for (i = 0; i < n; i += run)
+        {
+        int isWord = (points[i] > 255);
+        
+        for (run = 1; (i + run < n) && (run < 128) && ((points[i + run] > 255) == isWord); run += 1)
+            ;
+        
+        *walk++ = (unsigned char) ((isWord ? 0x80 : 0) | (run - 1));
+        
+        for (v = 0; v < run; v += 1)
+            {
+            if (isWord)
+                *walk++ = (unsigned char) ((points[i + v] >> 8) & 0xFF);
+            
+            *walk++ = (unsigned char) (points[i + v] & 0xFF);
+            }
+        }
+    
+    retVal = PyBytes_FromStringAndSize((const char *) out, walk - out);
+    
+    PyMem_Free(out);
+    PyMem_Free(points);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    FreePoints: PyMem_Free(points);
+    BadReturn:  return NULL;
+    }  /* ut_PackPoints */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static PyObject *ut_Subroutinize(PyObject *self, PyObject *args)
+    {
+    /* Given a sequence of Type 2 charstrings, a parallel sequence with the
+       local subrs each one uses (a sequence of bytes objects, or None), the
+       global subrs and a budget in seconds of processor time, flattens the
+       charstrings and makes new global subrs from the runs of tokens they
+       share. Returns a tuple with two lists of bytes objects:
+       
+           charstrings  the new charstrings, in the same order
+           subrs        the new global subrs
+       
+       Returns None instead if a charstring can't be flattened (see T2Run)
+       or the budget runs out before subrs can be chosen. */
+    
+    int         alphabet, err, g, n, *seq = NULL;
+    double      budget;
+    clock_t     deadline;
+    Py_buffer   buffer;
+    Py_ssize_t  count;
+    PyObject    *charstringsObj, *globalObj, *item, *localObj, *localSubrs, *newCharstrings, *retVal, *subrs;
+    SubrState   t;
+    T2State     s;
+    
+    require(PyArg_ParseTuple(args, "OOOd", &charstringsObj, &localObj, &globalObj, &budget), BadReturn);
+    deadline = clock() + (clock_t) (budget * CLOCKS_PER_SEC);
+    count = PySequence_Size(charstringsObj);
+    require(count >= 0, BadReturn);
+    
+    require_action(
+      PySequence_Size(localObj) == count,
+      BadReturn,
+      PyErr_SetString(PyExc_ValueError, "Need local subrs for each charstring!"););
+    
+    memset(&s, 0, sizeof(s));
+    memset(&t, 0, sizeof(t));
+    s.flatten = 1;
+    s.globalSubrs = globalObj;
+    t.t2 = &s;
+    t.charstringCount = (int) count;
+    t.positions = PyMem_New(Py_ssize_t, count + 1);
+    t.parseStarts = PyMem_New(Py_ssize_t, count + 1);
+    require_action(t.positions && t.parseStarts, FreeState, PyErr_NoMemory(););
+    
+    for (g = 0, err = T2_OK; (g < count) && (err == T2_OK); g += 1)
+        {
+        item = PySequence_GetItem(charstringsObj, g);
+        require(item, FreeState);
+        localSubrs = PySequence_GetItem(localObj, g);
+        require_action(localSubrs, FreeState, Py_DECREF(item););
+        err = PyObject_GetBuffer(item, &buffer, PyBUF_SIMPLE);
+        
+        if (!err)
+            {
+            s.localSubrs = ((localSubrs == Py_None) ? NULL : localSubrs);
+            s.stackCount = s.haveWidth = s.haveSeac = 0;
+            s.stemCount = s.contourCount = s.curX = s.curY = 0;
+            t.positions[g] = s.tokenCount + g;
+            err = T2Run(&s, (const unsigned char *) buffer.buf, buffer.len, 0);
+            PyBuffer_Release(&buffer);
+            }
+        
+        else
+            err = T2_ERROR;
+        
+        Py_DECREF(localSubrs);
+        Py_DECREF(item);
+        }
+    
+    require(err != T2_ERROR, FreeState);
+    t.positions[count] = s.tokenCount + count;
+    
+    if ((err == T2_DECLINE) || !s.tokenCount || (t.positions[count] >= INT_MAX / 2))
+        goto Decline;
+    
+    /* Every token has a start, so the end of the last one goes after them. */
+    
+    s.tokens[s.tokenCount] = s.flatCount;
+    n = (int) t.positions[count];
+    seq = PyMem_New(int, n);
+    t.tokenAt = PyMem_New(int, n);
+    t.sizeBefore = PyMem_New(long, n + 1);
+    t.cost = PyMem_New(long, n + 1);
+    t.choice = PyMem_New(int, n + 1);
+    require_action(seq && t.tokenAt && t.sizeBefore && t.cost && t.choice, FreeState, PyErr_NoMemory(););
+    alphabet = SubrNumberTokens(&t, seq);
+    require(alphabet >= 0, FreeState);
+    err = SubrFindCandidates(&t, seq, n, deadline);
+    PyMem_Free(seq);
+    seq = NULL;
+    require(err != T2_ERROR, FreeState);
+    
+    if (err == T2_DECLINE)
+        goto Decline;
+    
+    /* One pass to see which subrs get used, another (time permitting) after
+       dropping the ones that don't pay for themselves, and a last one whose
+       parses are kept. */
+    
+    err = SubrPass(&t);
+    err = (err ? err : SubrNumber(&t, 0));
+    
+    if (!err && (clock() < deadline))
+        {
+        err = SubrPass(&t);
+        err = (err ? err : SubrNumber(&t, 0));
+        }
+    
+    err = (err ? err : SubrPass(&t));
+    err = (err ? err : SubrNumber(&t, 1));
+    require_noerr(err, FreeState);
+    
+    newCharstrings = PyList_New(count);
+    require(newCharstrings, FreeState);
+    subrs = PyList_New(t.subrCount);
+    require(subrs, FreeCharstrings);
+    
+    for (g = 0; g < count; g += 1)
+        {
+        item = SubrEmit(&t, t.parseStarts[g], t.parseStarts[g + 1], 0);
+        require(item, FreeSubrs);
+        PyList_SET_ITEM(newCharstrings, g, item);
+        }
+    
+    for (g = 0; g < t.candidateCount; g += 1)
+        {
+        if (t.candidates[g].index < 0)
+            continue;
+        
+        item = SubrEmit(&t, t.candidates[g].parseStart, t.candidates[g].parseStop, 1);
+        require(item, FreeSubrs);
+        PyList_SET_ITEM(subrs, t.candidates[g].index, item);
+        }
+    
+    retVal = Py_BuildValue("(NN)", newCharstrings, subrs);
+    require(retVal, FreeState);
+    
+    SubrFreeState(&t);
+    T2FreeState(&s);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Decline:            SubrFreeState(&t);
+                        T2FreeState(&s);
+                        Py_INCREF(Py_None);
+                        return Py_None;
+    FreeSubrs:          Py_DECREF(subrs);
+    FreeCharstrings:    Py_DECREF(newCharstrings);
+    FreeState:          PyMem_Free(seq);
+                        SubrFreeState(&t);
+                        T2FreeState(&s);
+    BadReturn:          return NULL;
+    }  /* ut_Subroutinize */
+
+/* --------------------------------------------------------------------------------------------- */
+
 /*** MODULE CREATION ***/
 
 static struct PyModuleDef utilitiesmodule =
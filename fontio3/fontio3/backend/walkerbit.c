@@ -22,6 +22,14 @@ const unsigned char highMasks[8] = {
     0xC0,
     0x80};
 
+#define GLYF_ON_CURVE 0x01
+#define GLYF_X_SHORT 0x02
+#define GLYF_Y_SHORT 0x04
+#define GLYF_REPEAT 0x08
+#define GLYF_X_SAME_OR_POSITIVE 0x10
+#define GLYF_Y_SAME_OR_POSITIVE 0x20
+#define GLYF_HIGH_BIT 0x80
+
 /* ------------------------------------------------------------------------- */
 
 /*** TYPES ***/
@@ -52,6 +60,39 @@ static int BytesFromBits(
 
 static void CapsuleDestructor(PyObject *capsule);
 
+static int DecodeCoordinates(
+  const unsigned char   *b,
+  unsigned long         length,
+  const unsigned char   *flags,
+  Py_ssize_t            pointCount,
+  unsigned char         shortBit,
+  unsigned char         sameBit,
+  short                 *coords,
+  unsigned long         *used);
+
+static int DecodePackedDeltas(
+  const unsigned char   *b,
+  unsigned long         length,
+  Py_ssize_t            count,
+  short                 *deltas,
+  unsigned long         *used);
+
+static int DecodePackedPoints(
+  const unsigned char   *b,
+  unsigned long         length,
+  unsigned long         pointCount,
+  unsigned int          **points,
+  Py_ssize_t            *count,
+  unsigned long         *used);
+
+static PyObject *DecodeTupleData(
+  const unsigned char   *b,
+  unsigned long         length,
+  Py_ssize_t            pointCount,
+  const unsigned int    *sharedPoints,
+  Py_ssize_t            sharedCount,
+  unsigned long         *used);
+
 static unsigned long FormatByteSize(
   const char    *format,
   unsigned long formatLength,
@@ -67,12 +108,16 @@ static int FormatProcess(
 
 static void FreeContext(WKB_Context *context);
 
+static PyObject *MakeArray(const char *typeCode, const void *v, Py_ssize_t byteCount);
+
 static int MakeConstants(
   unsigned long bitCountPerItem,
   PyObject **constOne,
   PyObject **constTwo,
   PyObject **constSignedToSubtract);
 
+static PyObject *ReadF2Dot14Tuple(const unsigned char *b, long axisCount);
+
 static PyObject *wkb_AbsRest(PyObject *self, PyObject *args);
 static PyObject *wkb_Align(PyObject *self, PyObject *args);
 static PyObject *wkb_AsStringAndOffset(PyObject *self, PyObject *args);
@@ -80,6 +125,7 @@ static PyObject *wkb_AtEnd(PyObject *self, PyObject *args);
 static PyObject *wkb_BitLength(PyObject *self, PyObject *args);
 static PyObject *wkb_CalcSize(PyObject *self, PyObject *args);
 static PyObject *wkb_GetOffset(PyObject *self, PyObject *args);
+static PyObject *wkb_GlyphSlice(PyObject *self, PyObject *args);
 static PyObject *wkb_Group(PyObject *self, PyObject *args);
 static PyObject *wkb_NewContext(PyObject *self, PyObject *args);
 static PyObject *wkb_PascalString(PyObject *self, PyObject *args);
@@ -91,7 +137,12 @@ static PyObject *wkb_SubWalkerSetup(PyObject *self, PyObject *args);
 static PyObject *wkb_Unpack(PyObject *self, PyObject *args);
 static PyObject *wkb_UnpackBits(PyObject *self, PyObject *args);
 static PyObject *wkb_UnpackBitsGroup(PyObject *self, PyObject *args);
+static PyObject *wkb_UnpackGlyphVariations(PyObject *self, PyObject *args);
+static PyObject *wkb_UnpackLocaOffsets(PyObject *self, PyObject *args);
+static PyObject *wkb_UnpackPackedDeltas(PyObject *self, PyObject *args);
+static PyObject *wkb_UnpackPackedPoints(PyObject *self, PyObject *args);
 static PyObject *wkb_UnpackRest(PyObject *self, PyObject *args);
+static PyObject *wkb_UnpackSimpleGlyph(PyObject *self, PyObject *args);
 
 /* ------------------------------------------------------------------------- */
 
@@ -105,6 +156,7 @@ static PyMethodDef WalkerBitMethods[] = {
     {"wkbBitLength", wkb_BitLength, METH_VARARGS, NULL},
     {"wkbCalcSize", wkb_CalcSize, METH_VARARGS, NULL},
     {"wkbGetOffset", wkb_GetOffset, METH_VARARGS, NULL},
+    {"wkbGlyphSlice", wkb_GlyphSlice, METH_VARARGS, NULL},
     {"wkbGroup", wkb_Group, METH_VARARGS, NULL},
     {"wkbNewContext", wkb_NewContext, METH_VARARGS, NULL},
     {"wkbPascalString", wkb_PascalString, METH_VARARGS, NULL},
@@ -116,7 +168,12 @@ static PyMethodDef WalkerBitMethods[] = {
     {"wkbUnpack", wkb_Unpack, METH_VARARGS, NULL},
     {"wkbUnpackBits", wkb_UnpackBits, METH_VARARGS, NULL},
     {"wkbUnpackBitsGroup", wkb_UnpackBitsGroup, METH_VARARGS, NULL},
+    {"wkbUnpackGlyphVariations", wkb_UnpackGlyphVariations, METH_VARARGS, NULL},
+    {"wkbUnpackLocaOffsets", wkb_UnpackLocaOffsets, METH_VARARGS, NULL},
+    {"wkbUnpackPackedDeltas", wkb_UnpackPackedDeltas, METH_VARARGS, NULL},
+    {"wkbUnpackPackedPoints", wkb_UnpackPackedPoints, METH_VARARGS, NULL},
     {"wkbUnpackRest", wkb_UnpackRest, METH_VARARGS, NULL},
+    {"wkbUnpackSimpleGlyph", wkb_UnpackSimpleGlyph, METH_VARARGS, NULL},
     {NULL, NULL, 0, NULL}};
 
 /* ------------------------------------------------------------------------- */
@@ -194,6 +251,247 @@ static void CapsuleDestructor(PyObject *capsule)
         FreeContext(context);
     }   /* CapsuleDestructor */
 
+static int DecodeCoordinates(
+  const unsigned char   *b,
+  unsigned long         length,
+  const unsigned char   *flags,
+  Py_ssize_t            pointCount,
+  unsigned char         shortBit,
+  unsigned char         sameBit,
+  short                 *coords,
+  unsigned long         *used)
+
+    {
+    int             value = 0;
+    unsigned long   walk = 0;
+    Py_ssize_t      i;
+    
+    for (i = 0; i < pointCount; i += 1)
+        {
+        if (flags[i] & shortBit)
+            {
+            require(walk + 1UL <= length, Err_BadReturn);
+            value += ((flags[i] & sameBit) ? b[walk] : -b[walk]);
+            walk += 1UL;
+            }
+        
+        else if (!(flags[i] & sameBit))
+            {
+            require(walk + 2UL <= length, Err_BadReturn);
+            value += (short) ((b[walk] << 8) | b[walk + 1UL]);
+            walk += 2UL;
+            }
+        
+        coords[i] = (short) value;
+        }
+    
+    *used = walk;
+    return 0;
+    
+    /*** ERROR HANDLERS ***/
+    Err_BadReturn:  PyErr_SetString(PyExc_IndexError, "Attempt to unpack past end of string!");
+                    return -1;
+    }  /* DecodeCoordinates */
+
+static int DecodePackedDeltas(
+  const unsigned char   *b,
+  unsigned long         length,
+  Py_ssize_t            count,
+  short                 *deltas,
+  unsigned long         *used)
+
+    {
+    unsigned char   code;
+    unsigned long   walk = 0;
+    Py_ssize_t      i = 0, runCount;
+    
+    while (i < count)
+        {
+        require(walk < length, Err_PastEnd);
+        code = b[walk++];
+        runCount = (Py_ssize_t) (code & 0x3F) + 1;
+        
+        if (code & 0x80)
+            {  /* DELTAS_ARE_ZERO */
+            for ( ; runCount; runCount -= 1, i += 1)
+                {
+                if (i < count)
+                    deltas[i] = 0;
+                }
+            }
+        
+        else if (code & 0x40)
+            {  /* DELTAS_ARE_WORDS */
+            require(walk + 2UL * runCount <= length, Err_PastEnd);
+            
+            for ( ; runCount; runCount -= 1, i += 1, walk += 2UL)
+                {
+                if (i < count)
+                    deltas[i] = (short) ((b[walk] << 8) | b[walk + 1UL]);
+                }
+            }
+        
+        else
+            {
+            require(walk + runCount <= length, Err_PastEnd);
+            
+            for ( ; runCount; runCount -= 1, i += 1, walk += 1UL)
+                {
+                if (i < count)
+                    deltas[i] = (signed char) b[walk];
+                }
+            }
+        }
+    
+    *used = walk;
+    return 0;
+    
+    /*** ERROR HANDLERS ***/
+    Err_PastEnd:    PyErr_SetString(PyExc_IndexError, "Attempt to unpack past end of string!");
+                    return -1;
+    }  /* DecodePackedDeltas */
+
+static int DecodePackedPoints(
+  const unsigned char   *b,
+  unsigned long         length,
+  unsigned long         pointCount,
+  unsigned int          **points,
+  Py_ssize_t            *count,
+  unsigned long         *used)
+
+    {
+    unsigned char   code;
+    unsigned int    *v, last = 0;
+    unsigned long   walk = 0;
+    Py_ssize_t      i = 0, runCount, totalPoints;
+    
+    require(length >= 1UL, Err_PastEnd);
+    totalPoints = b[walk++];
+    
+    if (!totalPoints)
+        totalPoints = (Py_ssize_t) pointCount + 4;  /* all points, including the phantoms */
+    
+    else if (totalPoints & 0x80)
+        {
+        require(walk < length, Err_PastEnd);
+        totalPoints = ((totalPoints & 0x7F) << 8) | b[walk++];
+        }
+    
+    v = PyMem_Malloc((totalPoints + 1) * sizeof(unsigned int));
+    require_action(v, Err_BadReturn, PyErr_NoMemory(););
+    
+    if (walk == 1UL && !b[0])
+        {
+        for (i = 0; i < totalPoints; i += 1)
+            v[i] = (unsigned int) i;
+        }
+    
+    while (i < totalPoints)
+        {
+        require(walk < length, Err_FreeV);
+        code = b[walk++];
+        runCount = (Py_ssize_t) (code & 0x7F) + 1;
+        
+        require_action(
+          i + runCount <= totalPoints,
+          Err_FreeVNoSet,
+          PyErr_SetString(PyExc_ValueError, "Packed point run exceeds the point count!"););
+        
+        if (code & 0x80)
+            {  /* POINTS_ARE_WORDS */
+            require(walk + 2UL * runCount <= length, Err_FreeV);
+            
+            for ( ; runCount; runCount -= 1, walk += 2UL)
+                v[i++] = last = last + ((b[walk] << 8) | b[walk + 1UL]);
+            }
+        
+        else
+            {
+            require(walk + runCount <= length, Err_FreeV);
+            
+            for ( ; runCount; runCount -= 1, walk += 1UL)
+                v[i++] = last = last + b[walk];
+            }
+        }
+    
+    *points = v;
+    *count = totalPoints;
+    *used = walk;
+    return 0;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeV:      PyErr_SetString(PyExc_IndexError, "Attempt to unpack past end of string!");
+    Err_FreeVNoSet: PyMem_Free(v);
+                    return -1;
+    Err_PastEnd:    PyErr_SetString(PyExc_IndexError, "Attempt to unpack past end of string!");
+    Err_BadReturn:  return -1;
+    }  /* DecodePackedPoints */
+
+static PyObject *DecodeTupleData(
+  const unsigned char   *b,
+  unsigned long         length,
+  Py_ssize_t            pointCount,
+  const unsigned int    *sharedPoints,
+  Py_ssize_t            sharedCount,
+  unsigned long         *used)
+
+    {
+    const unsigned int  *points = sharedPoints;
+    unsigned int        *privatePoints = NULL;
+    unsigned long       walk = 0, piece;
+    short               *deltas;
+    Py_ssize_t          count = sharedCount;
+    PyObject            *pyPoints, *pyXs, *pyYs, *retVal;
+    
+    if (!points)
+        {
+        require_noerr(
+          DecodePackedPoints(b, length, (unsigned long) pointCount, &privatePoints, &count, &walk),
+          Err_BadReturn);
+        
+        points = privatePoints;
+        }
+    
+    deltas = PyMem_Malloc((2 * count + 1) * sizeof(short));
+    require_action(deltas, Err_FreePoints, PyErr_NoMemory(););
+    
+    require_noerr(
+      DecodePackedDeltas(b + walk, length - walk, count, deltas, &piece),
+      Err_FreeDeltas);
+    
+    walk += piece;
+    
+    require_noerr(
+      DecodePackedDeltas(b + walk, length - walk, count, deltas + count, &piece),
+      Err_FreeDeltas);
+    
+    walk += piece;
+    
+    pyPoints = MakeArray("I", points, count * (Py_ssize_t) sizeof(unsigned int));
+    require(pyPoints, Err_FreeDeltas);
+    pyXs = MakeArray("h", deltas, count * (Py_ssize_t) sizeof(short));
+    require(pyXs, Err_FreePyPoints);
+    pyYs = MakeArray("h", deltas + count, count * (Py_ssize_t) sizeof(short));
+    require(pyYs, Err_FreePyXs);
+    retVal = Py_BuildValue("NNN", pyPoints, pyXs, pyYs);
+    require(retVal, Err_FreeDeltas);
+    
+    PyMem_Free(deltas);
+    
+    if (privatePoints)
+        PyMem_Free(privatePoints);
+    
+    *used = walk;
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreePyXs:       Py_DECREF(pyXs);
+    Err_FreePyPoints:   Py_DECREF(pyPoints);
+    Err_FreeDeltas:     PyMem_Free(deltas);
+    Err_FreePoints:     if (privatePoints) PyMem_Free(privatePoints);
+    Err_BadReturn:      return NULL;
+    }  /* DecodeTupleData */
+
 static unsigned long FormatByteSize(
   const char    *format,
   unsigned long formatLength,
@@ -636,6 +934,27 @@ static void FreeContext(WKB_Context *context)
     PyMem_Free(context);
     }  /* FreeContext */
 
+static PyObject *MakeArray(const char *typeCode, const void *v, Py_ssize_t byteCount)
+    {
+    PyObject    *arrayModule, *bytes, *retVal;
+    
+    arrayModule = PyImport_ImportModule("array");
+    require(arrayModule, Err_BadReturn);
+    bytes = PyBytes_FromStringAndSize((const char *) v, byteCount);
+    require(bytes, Err_FreeModule);
+    retVal = PyObject_CallMethod(arrayModule, "array", "sO", typeCode, bytes);
+    require(retVal, Err_FreeBytes);
+    
+    Py_DECREF(bytes);
+    Py_DECREF(arrayModule);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeBytes:      Py_DECREF(bytes);
+    Err_FreeModule:     Py_DECREF(arrayModule);
+    Err_BadReturn:      return NULL;
+    }  /* MakeArray */
+
 static int MakeConstants(
   unsigned long bitCountPerItem,
   PyObject **constOne,
@@ -667,6 +986,22 @@ static int MakeConstants(
     Err_BadReturn:      return -1;
     }   /* MakeConstants */
 
+static PyObject *ReadF2Dot14Tuple(const unsigned char *b, long axisCount)
+    {
+    long        i;
+    PyObject    *retVal = PyTuple_New(axisCount);
+    
+    require(retVal, Err_BadReturn);
+    
+    for (i = 0; i < axisCount; i += 1, b += 2)
+        PyTuple_SET_ITEM(retVal, i, PyLong_FromLong((short) ((b[0] << 8) | b[1])));
+    
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_BadReturn:  return NULL;
+    }  /* ReadF2Dot14Tuple */
+
 /* --------------------------------------------------------------------------------------------- */
 
 static PyObject *wkb_AbsRest(PyObject *self, PyObject *args)
@@ -864,6 +1199,66 @@ static PyObject *wkb_GetOffset(PyObject *self, PyObject *args)
     Err_BadReturn:  return NULL;
     }  /* wkb_GetOffset */
 
+static PyObject *wkb_GlyphSlice(PyObject *self, PyObject *args)
+    {
+    const unsigned long *offsets;
+    unsigned long       byteLimit, byteStart, limit, start;
+    Py_buffer           offsetsBuffer;
+    Py_ssize_t          index;
+    PyObject            *co, *offsetsObj, *retVal, *view;
+    WKB_Context         *context;
+    
+    require_noerr(
+      !PyArg_ParseTuple(args, "OOn", &co, &offsetsObj, &index),
+      Err_BadReturn);
+    
+    context = PyCapsule_GetPointer(co, "walkerbit_capsule");
+    require(context, Err_BadReturn);
+    
+    require_noerr(
+      PyObject_GetBuffer(offsetsObj, &offsetsBuffer, PyBUF_FORMAT),
+      Err_BadReturn);
+    
+    require_action(
+      offsetsBuffer.format && (offsetsBuffer.format[0] == 'L') && !offsetsBuffer.format[1],
+      Err_ReleaseBuffer,
+      PyErr_SetString(PyExc_TypeError, "Offsets must be an array('L')!"););
+    
+    require_action(
+      (index >= 0) && (index + 1 < offsetsBuffer.len / (Py_ssize_t) sizeof(unsigned long)),
+      Err_ReleaseBuffer,
+      PyErr_SetString(PyExc_IndexError, "Glyph index out of range!"););
+    
+    offsets = (const unsigned long *) offsetsBuffer.buf;
+    byteStart = context->origBitStart >> 3UL;
+    byteLimit = context->bitLimit >> 3UL;
+    start = byteStart + offsets[index];
+    limit = byteStart + offsets[index + 1];
+    
+    require_action(
+      start <= limit,
+      Err_ReleaseBuffer,
+      PyErr_SetString(PyExc_ValueError, "Glyph offsets are out of order!"););
+    
+    require_action(
+      limit <= byteLimit,
+      Err_ReleaseBuffer,
+      PyErr_SetString(PyExc_ValueError, "Glyph data extend past the end of the table!"););
+    
+    view = PyMemoryView_FromObject(context->originalObject);
+    require(view, Err_ReleaseBuffer);
+    retVal = PySequence_GetSlice(view, (Py_ssize_t) start, (Py_ssize_t) limit);
+    Py_DECREF(view);
+    require(retVal, Err_ReleaseBuffer);
+    
+    PyBuffer_Release(&offsetsBuffer);
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_ReleaseBuffer:  PyBuffer_Release(&offsetsBuffer);
+    Err_BadReturn:      return NULL;
+    }  /* wkb_GlyphSlice */
+
 static PyObject *wkb_Group(PyObject *self, PyObject *args)
     {
     char            finalCoerce;
@@ -1508,6 +1903,278 @@ static PyObject *wkb_UnpackBitsGroup(PyObject *self, PyObject *args)
     Err_BadReturn:      return NULL;
     }   /* wkb_UnpackBitsGroup */
 
+static PyObject *wkb_UnpackGlyphVariations(PyObject *self, PyObject *args)
+    {
+    const unsigned char *b;
+    unsigned int        *sharedPoints = NULL;
+    unsigned long       dataWalk, headerSize, length, used, walk;
+    long                axisCount, pointCount, tupleCount, tupleIndex;
+    Py_ssize_t          i, sharedCount = 0;
+    PyObject            *co, *end, *peak, *retVal, *start, *t, *tupleData;
+    WKB_Context         *context;
+    
+    require_noerr(
+      !PyArg_ParseTuple(args, "Oll", &co, &axisCount, &pointCount),
+      Err_BadReturn);
+    
+    context = PyCapsule_GetPointer(co, "walkerbit_capsule");
+    require(context, Err_BadReturn);
+    
+    require_action(
+      !(context->currBitOffset & 7UL),
+      Err_BadReturn,
+      PyErr_SetString(PyExc_ValueError, "Walker must be byte-aligned to unpack variations!"););
+    
+    b = (const unsigned char *) context->liveBuffer.buf + (context->currBitOffset >> 3UL);
+    length = (context->bitLimit - context->currBitOffset) >> 3UL;
+    require(length >= 4UL, Err_PastEnd);
+    tupleCount = (b[0] << 8) | b[1];
+    dataWalk = (b[2] << 8) | b[3];
+    walk = 4UL;
+    require(dataWalk <= length, Err_PastEnd);
+    
+    if (tupleCount & 0x8000)
+        {
+        require_noerr(
+          DecodePackedPoints(b + dataWalk, length - dataWalk, (unsigned long) pointCount, &sharedPoints, &sharedCount, &used),
+          Err_BadReturn);
+        
+        dataWalk += used;
+        }
+    
+    tupleCount &= 0x0FFF;
+    retVal = PyList_New(tupleCount);
+    require(retVal, Err_FreeShared);
+    
+    for (i = 0; i < tupleCount; i += 1)
+        {
+        require(walk + 4UL <= length, Err_PastEndList);
+        tupleIndex = (b[walk + 2UL] << 8) | b[walk + 3UL];
+        walk += 4UL;
+        headerSize = 2UL * axisCount * ((tupleIndex & 0x8000 ? 1 : 0) + (tupleIndex & 0x4000 ? 2 : 0));
+        require(walk + headerSize <= length, Err_PastEndList);
+        peak = start = end = NULL;
+        
+        if (tupleIndex & 0x8000)
+            {  /* EMBEDDED_PEAK_TUPLE */
+            peak = ReadF2Dot14Tuple(b + walk, axisCount);
+            require(peak, Err_FreeList);
+            walk += 2UL * axisCount;
+            }
+        
+        if (tupleIndex & 0x4000)
+            {  /* INTERMEDIATE_REGION */
+            start = ReadF2Dot14Tuple(b + walk, axisCount);
+            require(start, Err_FreeTuples);
+            end = ReadF2Dot14Tuple(b + walk + 2UL * axisCount, axisCount);
+            require(end, Err_FreeTuples);
+            walk += 4UL * axisCount;
+            }
+        
+        tupleData = DecodeTupleData(
+          b + dataWalk,
+          length - dataWalk,
+          pointCount,
+          ((tupleIndex & 0x2000) ? NULL : sharedPoints),
+          sharedCount,
+          &used);
+        
+        require(tupleData, Err_FreeTuples);
+        dataWalk += used;
+        
+        /* The N conversions below steal a reference, so missing tuples need one of their own */
+        
+        if (!peak)
+            {
+            Py_INCREF(Py_None);
+            peak = Py_None;
+            }
+        
+        if (!start)
+            {
+            Py_INCREF(Py_None);
+            start = Py_None;
+            }
+        
+        if (!end)
+            {
+            Py_INCREF(Py_None);
+            end = Py_None;
+            }
+        
+        t = Py_BuildValue(
+          "lNNNOOO",
+          tupleIndex,
+          peak,
+          start,
+          end,
+          PyTuple_GET_ITEM(tupleData, 0),
+          PyTuple_GET_ITEM(tupleData, 1),
+          PyTuple_GET_ITEM(tupleData, 2));
+        
+        Py_DECREF(tupleData);
+        require(t, Err_FreeList);
+        PyList_SET_ITEM(retVal, i, t);
+        }
+    
+    if (sharedPoints)
+        PyMem_Free(sharedPoints);
+    
+    context->currBitOffset += 8UL * walk;
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeTuples:     Py_XDECREF(end);
+                        Py_XDECREF(start);
+                        Py_XDECREF(peak);
+                        goto Err_FreeList;
+    Err_PastEndList:    PyErr_SetString(PyExc_IndexError, "Attempt to unpack past end of string!");
+    Err_FreeList:       Py_DECREF(retVal);
+    Err_FreeShared:     if (sharedPoints) PyMem_Free(sharedPoints);
+                        goto Err_BadReturn;
+    Err_PastEnd:        PyErr_SetString(PyExc_IndexError, "Attempt to unpack past end of string!");
+    Err_BadReturn:      return NULL;
+    }  /* wkb_UnpackGlyphVariations */
+
+static PyObject *wkb_UnpackLocaOffsets(PyObject *self, PyObject *args)
+    {
+    char                isLong;
+    const unsigned char *b;
+    unsigned long       byteOffset, entrySize, *offsets;
+    Py_ssize_t          count, i;
+    PyObject            *co, *retVal;
+    WKB_Context         *context;
+    
+    require_noerr(
+      !PyArg_ParseTuple(args, "Ob", &co, &isLong),
+      Err_BadReturn);
+    
+    context = PyCapsule_GetPointer(co, "walkerbit_capsule");
+    require(context, Err_BadReturn);
+    
+    require_action(
+      !(context->currBitOffset & 7UL),
+      Err_BadReturn,
+      PyErr_SetString(PyExc_ValueError, "Walker must be byte-aligned to unpack offsets!"););
+    
+    byteOffset = context->currBitOffset >> 3UL;
+    entrySize = (isLong ? 4UL : 2UL);
+    count = (Py_ssize_t) (((context->bitLimit >> 3UL) - byteOffset) / entrySize);
+    offsets = PyMem_Malloc((count + 1) * sizeof(unsigned long));
+    require_action(offsets, Err_BadReturn, PyErr_NoMemory(););
+    b = (const unsigned char *) context->liveBuffer.buf + byteOffset;
+    
+    for (i = 0; i < count; i += 1, b += entrySize)
+        {
+        if (isLong && context->isBigEndian)
+            offsets[i] = ((unsigned long) b[0] << 24) | ((unsigned long) b[1] << 16) | ((unsigned long) b[2] << 8) | b[3];
+        else if (isLong)
+            offsets[i] = ((unsigned long) b[3] << 24) | ((unsigned long) b[2] << 16) | ((unsigned long) b[1] << 8) | b[0];
+        else if (context->isBigEndian)
+            offsets[i] = 2UL * (((unsigned long) b[0] << 8) | b[1]);
+        else
+            offsets[i] = 2UL * (((unsigned long) b[1] << 8) | b[0]);
+        }
+    
+    retVal = MakeArray("L", offsets, count * (Py_ssize_t) sizeof(unsigned long));
+    PyMem_Free(offsets);
+    require(retVal, Err_BadReturn);
+    
+    context->currBitOffset += 8UL * entrySize * (unsigned long) count;
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_BadReturn:  return NULL;
+    }  /* wkb_UnpackLocaOffsets */
+
+static PyObject *wkb_UnpackPackedDeltas(PyObject *self, PyObject *args)
+    {
+    unsigned long   byteOffset, used;
+    short           *deltas;
+    Py_ssize_t      count;
+    PyObject        *co, *retVal;
+    WKB_Context     *context;
+    
+    require_noerr(
+      !PyArg_ParseTuple(args, "On", &co, &count),
+      Err_BadReturn);
+    
+    context = PyCapsule_GetPointer(co, "walkerbit_capsule");
+    require(context, Err_BadReturn);
+    
+    require_action(
+      !(context->currBitOffset & 7UL) && (count >= 0),
+      Err_BadReturn,
+      PyErr_SetString(PyExc_ValueError, "Walker must be byte-aligned to unpack deltas!"););
+    
+    byteOffset = context->currBitOffset >> 3UL;
+    deltas = PyMem_Malloc((count + 1) * sizeof(short));
+    require_action(deltas, Err_BadReturn, PyErr_NoMemory(););
+    
+    require_noerr(
+      DecodePackedDeltas(
+        (const unsigned char *) context->liveBuffer.buf + byteOffset,
+        (context->bitLimit >> 3UL) - byteOffset,
+        count,
+        deltas,
+        &used),
+      Err_FreeDeltas);
+    
+    retVal = MakeArray("h", deltas, count * (Py_ssize_t) sizeof(short));
+    require(retVal, Err_FreeDeltas);
+    
+    PyMem_Free(deltas);
+    context->currBitOffset += 8UL * used;
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeDeltas: PyMem_Free(deltas);
+    Err_BadReturn:  return NULL;
+    }  /* wkb_UnpackPackedDeltas */
+
+static PyObject *wkb_UnpackPackedPoints(PyObject *self, PyObject *args)
+    {
+    unsigned int    *points;
+    unsigned long   byteOffset, pointCount, used;
+    Py_ssize_t      count;
+    PyObject        *co, *retVal;
+    WKB_Context     *context;
+    
+    require_noerr(
+      !PyArg_ParseTuple(args, "Ok", &co, &pointCount),
+      Err_BadReturn);
+    
+    context = PyCapsule_GetPointer(co, "walkerbit_capsule");
+    require(context, Err_BadReturn);
+    
+    require_action(
+      !(context->currBitOffset & 7UL),
+      Err_BadReturn,
+      PyErr_SetString(PyExc_ValueError, "Walker must be byte-aligned to unpack points!"););
+    
+    byteOffset = context->currBitOffset >> 3UL;
+    
+    require_noerr(
+      DecodePackedPoints(
+        (const unsigned char *) context->liveBuffer.buf + byteOffset,
+        (context->bitLimit >> 3UL) - byteOffset,
+        pointCount,
+        &points,
+        &count,
+        &used),
+      Err_BadReturn);
+    
+    retVal = MakeArray("I", points, count * (Py_ssize_t) sizeof(unsigned int));
+    PyMem_Free(points);
+    require(retVal, Err_BadReturn);
+    
+    context->currBitOffset += 8UL * used;
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_BadReturn:  return NULL;
+    }  /* wkb_UnpackPackedPoints */
+
 static PyObject *wkb_UnpackRest(PyObject *self, PyObject *args)
     {
     char            coerce, strict;
@@ -1625,6 +2292,164 @@ static PyObject *wkb_UnpackRest(PyObject *self, PyObject *args)
     Err_BadReturn:  return NULL;
     }  /* wkb_UnpackRest */
 
+static PyObject *wkb_UnpackSimpleGlyph(PyObject *self, PyObject *args)
+    {
+    const unsigned char *b;
+    short               bounds[4], *xs = NULL;
+    int                 highBit = 0;
+    unsigned char       *flags, *onCurve;
+    unsigned short      *contourEnds;
+    unsigned long       hintLength, length, used, walk;
+    long                numContours;
+    Py_ssize_t          i, pointCount = 0, repeatCount;
+    PyObject            *co, *pyEnds, *pyHints, *pyOnCurve, *pyXs, *pyYs, *retVal;
+    WKB_Context         *context;
+    
+    require_noerr(
+      !PyArg_ParseTuple(args, "O", &co),
+      Err_BadReturn);
+    
+    context = PyCapsule_GetPointer(co, "walkerbit_capsule");
+    require(context, Err_BadReturn);
+    
+    require_action(
+      !(context->currBitOffset & 7UL),
+      Err_BadReturn,
+      PyErr_SetString(PyExc_ValueError, "Walker must be byte-aligned to unpack a glyph!"););
+    
+    b = (const unsigned char *) context->liveBuffer.buf + (context->currBitOffset >> 3UL);
+    length = (context->bitLimit - context->currBitOffset) >> 3UL;
+    require(length >= 10UL, Err_PastEnd);
+    numContours = (short) ((b[0] << 8) | b[1]);
+    
+    /* A negative contour count is left for the caller to deal with. */
+    
+    if (numContours < 0)
+        Py_RETURN_NONE;
+    
+    for (i = 0; i < 4; i += 1)
+        bounds[i] = (short) ((b[2 + 2 * i] << 8) | b[3 + 2 * i]);
+    
+    walk = 10UL;
+    require(walk + 2UL * numContours + 2UL <= length, Err_PastEnd);
+    contourEnds = PyMem_Malloc((numContours + 1) * sizeof(unsigned short));
+    require_action(contourEnds, Err_BadReturn, PyErr_NoMemory(););
+    
+    for (i = 0; i < numContours; i += 1, walk += 2UL)
+        contourEnds[i] = (unsigned short) ((b[walk] << 8) | b[walk + 1UL]);
+    
+    if (numContours)
+        pointCount = (Py_ssize_t) contourEnds[numContours - 1] + 1;
+    
+    /* Repeated ends (empty contours) are fine, but no end may be past the
+       last point. */
+    
+    for (i = 0; i < numContours; i += 1)
+        {
+        require_action(
+          contourEnds[i] < pointCount,
+          Err_FreeEnds,
+          PyErr_SetString(PyExc_ValueError, "Contour end points are out of range!"););
+        }
+    
+    hintLength = (b[walk] << 8) | b[walk + 1UL];
+    walk += 2UL;
+    
+    require_action(
+      walk + hintLength <= length,
+      Err_FreeEnds,
+      PyErr_SetString(PyExc_IndexError, "Attempt to unpack past end of string!"););
+    
+    pyHints = PyBytes_FromStringAndSize((const char *) b + walk, hintLength);
+    require(pyHints, Err_FreeEnds);
+    walk += hintLength;
+    
+    /* one block holds xs, ys, the expanded flags and the on-curve bytes */
+    xs = PyMem_Malloc(2 * pointCount * sizeof(short) + 2 * pointCount + 1);
+    require_action(xs, Err_FreeHints, PyErr_NoMemory(););
+    flags = (unsigned char *) (xs + 2 * pointCount);
+    onCurve = flags + pointCount;
+    
+    for (i = 0; i < pointCount; i += 1)
+        {
+        require(walk < length, Err_PastEndArrays);
+        flags[i] = b[walk++];
+        
+        if (flags[i] & GLYF_REPEAT)
+            {
+            require(walk < length, Err_PastEndArrays);
+            repeatCount = b[walk++];
+            
+            require_action(
+              i + repeatCount < pointCount,
+              Err_FreeArrays,
+              PyErr_SetString(PyExc_ValueError, "Flag repeat count runs past the last point!"););
+            
+            for ( ; repeatCount; repeatCount -= 1, i += 1)
+                flags[i + 1] = flags[i];
+            }
+        }
+    
+    for (i = 0; i < pointCount; i += 1)
+        {
+        onCurve[i] = flags[i] & GLYF_ON_CURVE;
+        highBit = highBit || (flags[i] & GLYF_HIGH_BIT);
+        }
+    
+    require_noerr(
+      DecodeCoordinates(b + walk, length - walk, flags, pointCount, GLYF_X_SHORT, GLYF_X_SAME_OR_POSITIVE, xs, &used),
+      Err_FreeArrays);
+    
+    walk += used;
+    
+    require_noerr(
+      DecodeCoordinates(b + walk, length - walk, flags, pointCount, GLYF_Y_SHORT, GLYF_Y_SAME_OR_POSITIVE, xs + pointCount, &used),
+      Err_FreeArrays);
+    
+    walk += used;
+    
+    pyXs = MakeArray("h", xs, pointCount * (Py_ssize_t) sizeof(short));
+    require(pyXs, Err_FreeArrays);
+    pyYs = MakeArray("h", xs + pointCount, pointCount * (Py_ssize_t) sizeof(short));
+    require(pyYs, Err_FreeXs);
+    pyOnCurve = PyBytes_FromStringAndSize((const char *) onCurve, pointCount);
+    require(pyOnCurve, Err_FreeYs);
+    pyEnds = MakeArray("H", contourEnds, numContours * (Py_ssize_t) sizeof(unsigned short));
+    require(pyEnds, Err_FreeOnCurve);
+    
+    retVal = Py_BuildValue(
+      "(hhhh)OOOOON",
+      bounds[0], bounds[1], bounds[2], bounds[3],
+      pyXs, pyYs, pyOnCurve, pyEnds, pyHints,
+      PyBool_FromLong(highBit));
+    
+    require(retVal, Err_FreeEnds2);
+    
+    Py_DECREF(pyEnds);
+    Py_DECREF(pyOnCurve);
+    Py_DECREF(pyYs);
+    Py_DECREF(pyXs);
+    Py_DECREF(pyHints);
+    PyMem_Free(xs);
+    PyMem_Free(contourEnds);
+    context->currBitOffset += 8UL * walk;
+    return retVal;
+    
+    /*** ERROR HANDLERS ***/
+    Err_FreeEnds2:      Py_DECREF(pyEnds);
+    Err_FreeOnCurve:    Py_DECREF(pyOnCurve);
+    Err_FreeYs:         Py_DECREF(pyYs);
+    Err_FreeXs:         Py_DECREF(pyXs);
+                        goto Err_FreeArrays;
+    Err_PastEndArrays:  PyErr_SetString(PyExc_IndexError, "Attempt to unpack past end of string!");
+    Err_FreeArrays:     PyMem_Free(xs);
+    Err_FreeHints:      Py_DECREF(pyHints);
+    Err_FreeEnds:       PyMem_Free(contourEnds);
+                        goto Err_BadReturn;
+    Err_PastEnd:        PyErr_SetString(PyExc_IndexError, "Attempt to unpack past end of string!");
+    Err_BadReturn:      return NULL;
+    }  /* wkb_UnpackSimpleGlyph */
+
 /* --------------------------------------------------------------------------------------------- */
 
 /*** MODULE CREATION ***/
@@ -10,6 +10,7 @@ Support for collections of unrelated fonts.
 
 # System imports
 import functools
+import hashlib
 import logging
 
 # Other imports
@@ -96,6 +97,46 @@ class CollectionEditor(list, metaclass=seqmeta.FontDataMetaclass):
     # Methods
     #
     
+    def _makeBuilt(self, changedKeys, parallelBuild, **kwArgs):
+        """
+        Builds the changed tables that don't affect other tables (see
+        fontedit._serialBuildTags) for all the fonts, in worker processes if
+        parallelBuild is specified, and returns a dict mapping (index, tag)
+        pairs to (binary string, checksum) pairs.
+        """
+        
+        pto = kwArgs.pop('perTableOptions', {})
+        
+        jobs = [
+          (i, tag)
+          for i, keys in enumerate(changedKeys)
+          for tag in sorted(keys)
+          if tag not in fontedit._serialBuildTags]
+        
+        pool, results = None, []
+        
+        if parallelBuild:
+            pool, results = fontedit._startParallelBuild(
+              [(self[i], tag, kwArgs, pto) for i, tag in jobs],
+              parallelBuild)
+        
+        built = {}
+        
+        for n, (i, tag) in enumerate(jobs):
+            try:
+                built[(i, tag)] = results[n].get()
+            
+            except Exception:
+                # Not built in a worker (or it failed there, in which case
+                # building it here raises the same exception).
+                built[(i, tag)] = self[i]._buildTableString(tag, kwArgs, pto)
+        
+        if pool is not None:
+            pool.close()
+            pool.join()
+        
+        return built
+    
     def _makeChangedKeys(self):
         changedKeys = [None] * len(self)
         
@@ -114,13 +155,41 @@ class CollectionEditor(list, metaclass=seqmeta.FontDataMetaclass):
         
         return stakes
     
-    def _makeUniques(self, changedKeys):
+    def _makeUniques(self, changedKeys, built):
         uniques = {}  # tag -> {avatar1: set(equals), avatar2: set(equals)...}
         allTags = functools.reduce(set.union, (set(obj) for obj in self))
         
         for tag in allTags:
             uniques[tag] = d = {}
             
+            if tag not in fontedit._serialBuildTags:
+                # These tables are compared by digests of their bytes: the
+                # raw bytes for unchanged tables (hashed once per place in
+                # the source), and the already-built bytes for changed ones.
+                
+                avatars = {}  # digest -> avatar index
+                
+                for i, obj in enumerate(self):
+                    if tag not in obj:
+                        continue
+                    
+                    if (i, tag) in built:
+                        digest = hashlib.blake2b(
+                          built[(i, tag)][0],
+                          digest_size = 20).digest()
+                    
+                    else:
+                        digest = obj._rawDigest(tag)
+                    
+                    if digest in avatars:
+                        d[avatars[digest]].add(i)
+                    
+                    else:
+                        avatars[digest] = i
+                        d[i] = set()
+                
+                continue
+            
             for i, obj in enumerate(self):
                 if tag not in obj:
                     continue
@@ -161,6 +230,52 @@ class CollectionEditor(list, metaclass=seqmeta.FontDataMetaclass):
     def buildBinary(self, w, **kwArgs):
         """
         Adds the binary data for the CollectionEditor to the specified writer.
+        
+        Changed tables that don't affect other tables are built once, up
+        front, and identical tables are then found by comparing digests of
+        their bytes, so nothing is built twice. If the parallelBuild keyword
+        argument is specified, these tables are built in that many worker
+        processes (or one per CPU, if it's True); see Editor.buildBinary().
+        
+        Each font's 'head' checkSumAdjustment is set once all the tables are
+        in place, so the whole-font checksum of every font comes out right:
+        
+        >>> e1 = fontedit.Editor.frommissingglyph(
+        ...   ttsimpleglyph._testingValues[2],
+        ...   hmtx.MtxEntry(advance=1000))
+        >>> e2 = fontedit.Editor.frommissingglyph(
+        ...   ttsimpleglyph._testingValues[2],
+        ...   hmtx.MtxEntry(advance=600))
+        >>> s = CollectionEditor([e1, e2]).binaryString()
+        >>> [hex(n) for n in _fontChecksums(s)]
+        ['0xb1b0afba', '0xb1b0afba']
+        
+        Tables are stored once for all the fonts whose bytes for them are the
+        same, whether they were changed or not, and a parallel build gives
+        the same result as a serial one:
+        
+        >>> fd, path = tempfile.mkstemp()
+        >>> os.close(fd)
+        >>> CollectionEditor([e1, e2]).writeFont(path)
+        >>> c = CollectionEditor.frompath(path)
+        >>> for e in c:
+        ...     e.post = e.post
+        >>> c[1].name[(3, 1, 1033, 1)] = "Other"
+        >>> c[1].name = c[1].name
+        >>> s = c.binaryString()
+        >>> c.binaryString(parallelBuild=2) == s
+        True
+        >>> (d0, h0), (d1, h1) = _directories(s)
+        >>> sorted(tag for tag in d0 if d0[tag] == d1[tag])
+        [b'cmap', b'glyf', b'loca', b'maxp', b'post']
+        >>> def _table(d, tag):
+        ...     offset, length = d[tag]
+        ...     return s[offset:offset+length]
+        >>> all(
+        ...   (d0[tag] == d1[tag]) == (_table(d0, tag) == _table(d1, tag))
+        ...   for tag in d0)
+        True
+        >>> os.remove(path)
         """
         
         if 'stakeValue' in kwArgs:
@@ -186,13 +301,9 @@ class CollectionEditor(list, metaclass=seqmeta.FontDataMetaclass):
         if vv == 0x20000:
             w.add("3L", 0, 0, 0)  # ulDsigTag, ulDsigLength, ulDsigOffset for v2
         
-        changedKeys = self._makeChangedKeys()
-        uniques = self._makeUniques(changedKeys)
-        stakes = self._makeStakes(w)
-        headerChecksumRanges = []
-        
         delKeys = {
           'baseStake',
+          'built',
           'changedKeys',
           'checksums',
           'familyIndex',
@@ -205,6 +316,13 @@ class CollectionEditor(list, metaclass=seqmeta.FontDataMetaclass):
         for delKey in delKeys:
             kwArgs.pop(delKey, None)
         
+        parallelBuild = kwArgs.pop('parallelBuild', False)
+        changedKeys = self._makeChangedKeys()
+        built = self._makeBuilt(changedKeys, parallelBuild, **kwArgs)
+        uniques = self._makeUniques(changedKeys, built)
+        stakes = self._makeStakes(w)
+        headerChecksumRanges = []
+        
         for i, obj in enumerate(self):
             startByteLength = w.byteLength
             
@@ -229,11 +347,19 @@ class CollectionEditor(list, metaclass=seqmeta.FontDataMetaclass):
               stakes = stakes,
               changedKeys = changedKeys,
               uniques = uniques,
+              built = built,
               familyIndex = i,
               checksums = checksums,
               lengths = lengths,
               headerChecksumRanges = headerChecksumRanges,
               **kwArgs)
+        
+        for i, obj in enumerate(self):
+            obj.buildBinary_headAdjustment(
+              w = w,
+              familyIndex = i,
+              checksums = checksums,
+              headerChecksumRanges = headerChecksumRanges)
     
     @classmethod
     def frompath(cls, path, **kwArgs):
@@ -437,6 +563,8 @@ class CollectionEditor(list, metaclass=seqmeta.FontDataMetaclass):
         r = cls(version=version)
         fw = fontedit.Editor.fromwalker
         kwArgs.pop('fromTTC', None)
+        rawDigests = {}  # shared, so tables the fonts share are hashed once
+        rawChecksumCache = {}  # likewise, so they're only summed once
         
         for offset in w.group("L", w.unpack("L")):
             
@@ -448,7 +576,10 @@ class CollectionEditor(list, metaclass=seqmeta.FontDataMetaclass):
             
             wSub = w.subWalker(0)
             wSub.skip(offset)
-            r.append(fw(wSub, fromTTC=True, **kwArgs))
+            e = fw(wSub, fromTTC=True, **kwArgs)
+            e._creationExtras['rawDigests'] = rawDigests
+            e._creationExtras['rawChecksumCache'] = rawChecksumCache
+            r.append(e)
         
         dsigTag = w.unpack("4s")
         
@@ -489,6 +620,45 @@ class CollectionEditor(list, metaclass=seqmeta.FontDataMetaclass):
 if 0:
     def __________________(): pass
 
+if __debug__:
+    import os
+    import struct
+    import tempfile
+    from fontio3 import hmtx, utilitiesbackend
+    from fontio3.glyf import ttsimpleglyph
+    
+    def _directories(s):
+        # Returns a list with a dict for each font in the TTC s, mapping its
+        # tags to (offset, length) pairs, and the (start, stop) of its header.
+        r = []
+        
+        for offset in struct.unpack_from(">%dL" % s[11], s, 12):
+            numTables = struct.unpack_from(">H", s, offset + 4)[0]
+            stop = offset + 12 + 16 * numTables
+            
+            d = {
+              s[i:i+4]: struct.unpack_from(">2L", s, i + 8)
+              for i in range(offset + 12, stop, 16)}
+            
+            r.append((d, (offset, stop)))
+        
+        return r
+    
+    def _fontChecksums(s):
+        # Returns the whole-font checksum of each font in the TTC s, which
+        # is the checksum of its table directory plus those of its tables.
+        r = []
+        
+        for d, (start, stop) in _directories(s):
+            total = utilitiesbackend.utChecksum(s[start:stop])
+            
+            for offset, length in d.values():
+                total += utilitiesbackend.utChecksum(s[offset:offset+length])
+            
+            r.append(total % 0x100000000)
+        
+        return r
+
 def _test():
     import doctest
     doctest.testmod()
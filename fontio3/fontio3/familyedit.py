@@ -536,6 +536,13 @@ class FamilyEditor(list, metaclass=seqmeta.FontDataMetaclass):
               lengths = lengths,
               headerChecksumRanges = headerChecksumRanges,
               **kwArgs)
+        
+        for i, obj in enumerate(self):
+            obj.buildBinary_headAdjustment(
+              w = w,
+              familyIndex = i,
+              checksums = checksums,
+              headerChecksumRanges = headerChecksumRanges)
     
     @classmethod
     def frompath(cls, path, **kwArgs):
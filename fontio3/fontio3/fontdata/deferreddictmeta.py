@@ -1095,6 +1095,13 @@ from fontio3.utilities import pp, valassist
 
 _singletonNCV = object()  # unique object meaning "needs creation"
 
+_privateAttrs = frozenset({
+  '_creationExtras',
+  '_dAdded',
+  '_dOrig',
+  '_keysCurrentlyCached',
+  '_namer'})
+
 validDictSpecKeys = frozenset([
   'dict_asimmutablefunc',
   'dict_compactremovesfalses',
@@ -5946,8 +5953,20 @@ def SM_getattr(self, key):
     ...   (k, (None if v is _singletonNCV else v))
     ...   for k, v in sorted(t._dOrig.items(), key=operator.itemgetter(0))]
     [('a', None), ('f', 'fffff'), ('z', None)]
+    
+    Special names, and the object's own private attributes, are never looked
+    up as keys. (The latter can only get here while an object is being
+    unpickled, before its ``__dict__`` has been restored.) This is what lets
+    deferred dicts be pickled:
+    
+    >>> t2 = Test.__new__(Test)  # as pickle makes it, with no __dict__ yet
+    >>> hasattr(t2, '__setstate__'), hasattr(t2, '_dOrig')
+    (False, False)
     """
     
+    if key.startswith('__') or key in _privateAttrs:
+        raise AttributeError(key)
+    
     try:
         if self._DEFDSPEC.get('item_keyisbytes', False):
             if not isinstance(key, bytes):
@@ -9,13 +9,17 @@ Top-level support for displaying and editing font data.
 """
 
 # System imports
+import concurrent.futures
+import hashlib
 import itertools
 import io
 import logging
+import multiprocessing
 import operator
 import tempfile
 import pickle
 import os
+import shutil
 import struct
 from xml.dom import minidom
 from xml.parsers.expat import ExpatError
@@ -81,7 +85,7 @@ from fontio3.MTsf import MTsf
 from fontio3.MVAR import MVAR
 from fontio3.name import name
 from fontio3.opbd import opbd
-from fontio3.opentype.living_variations import IVS
+from fontio3.opentype.living_variations import IVS, LivingAxialCoordinate
 from fontio3.OS_2 import OS_2
 from fontio3.PCLT import PCLT
 from fontio3.post import post
@@ -96,9 +100,11 @@ from fontio3.TSI import TSILoc, TSIDat, TSI5
 from fontio3.utilities import (
   bsh,
   filewalkerbit,
+  filewriter,
   namer,
   oldRound,
   ScalerError,
+  tablecache,
   walkerbit,
   writer)
 
@@ -151,7 +157,7 @@ _makerInfo = {
   b'fvar': (fvar.Fvar.fromwalker, (lambda x: {'editor': x})),
   b'gasp': (gasp.Gasp.fromwalker, (lambda x: {})),
   b'GDEF': (GDEF.GDEF, (lambda x: {'editor': x})),
-  b'glyf': (glyf.Glyf.fromwalker, (lambda x: {'locaObj': x.loca})),
+  b'glyf': (glyf.Glyf.fromwalker, (lambda x: _glyfKWArgs(x))),
   b'GPOS': (GPOS.GPOS, (lambda x: {'GDEF': x.GDEF} if b'GDEF' in x else {})),
   b'GSUB': (GSUB.GSUB, (lambda x: {'editor': x})),
   b'gvar': (gvar.Gvar.fromwalker, (lambda x: {'editor': x})),
@@ -579,6 +585,33 @@ _repertoire_bare_min = frozenset([
   b'maxp',
   b'name',
   b'post'])
+
+# Building these tables changes other tables (or, for 'head', refers to the
+# font-wide "headAdj" index map), so they're always built in order, into the
+# font's own writer. The rest are built separately, and so may be built in
+# worker processes (see Editor.buildBinary).
+
+_serialBuildTags = frozenset([
+  b'bdat',
+  b'bloc',
+  b'CBDT',
+  b'CBLC',
+  b'EBDT',
+  b'EBLC',
+  b'glyf',
+  b'head',
+  b'loca',
+  b'TSI0',
+  b'TSI1',
+  b'TSI2',
+  b'TSI3'])
+
+# This is the list of (editor, tag, kwArgs, perTableOptions) jobs for a
+# parallel build in progress (see _startParallelBuild). It's set before the
+# worker processes are forked, so they inherit it instead of having the
+# tables sent to them.
+
+_buildState = None
   
 # -----------------------------------------------------------------------------
 
@@ -586,6 +619,10 @@ _repertoire_bare_min = frozenset([
 # Private functions
 #
 
+def _buildInWorker(i):
+    editor, tag, kwArgs, pto = _buildState[i]
+    return editor._buildTableString(tag, kwArgs, pto)
+
 def _ddFactory(key, self, d):
     w = d['pieceInfo'][key]
     w.reset()
@@ -671,10 +708,82 @@ def _ddFactory(key, self, d):
         if key in pto:
             dKWArgs.update(pto[key])
         
+        if d.get('tableCache') is not None:
+            return _makeCached(self, d['tableCache'], key, w, f, dKWArgs)
+        
         return f(w, **dKWArgs)
     
     return binary.Binary(w.rest())
 
+def _glyfKWArgs(self):
+    # If the 'loca' table hasn't been made yet, the glyphs are located using
+    # a native offset array unpacked straight from its raw data, so that no
+    # Loca object gets built just to look at a few glyphs.
+    
+    if b'loca' in self.unmadeKeys():
+        w = self.getRawWalker(b'loca')
+        
+        if w is not None:
+            isLong = bool(self.head.indexToLocFormat)
+            return {'locaOffsets': w.unpackLocaOffsets(isLong)}
+    
+    return {'locaObj': self.loca}
+
+def _makeCached(self, cache, key, w, f, kwArgs):
+    # Makes the table with the specified tag via f, unless the TableCache
+    # already has it. Arguments that are other tables of this Editor (like
+    # GPOS's GDEF, or glyf's loca) are keyed by the digest of their raw data,
+    # as long as they haven't been changed since the font was read; tables
+    # given anything else that isn't a plain value (like the Editor itself)
+    # aren't cached, since it can change without this table's data changing.
+    
+    madeTags = {
+      id(obj): tag
+      for tag, obj in self._dOrig.items()
+      if tag not in self._dAdded}
+    
+    keyArgs = dict(kwArgs)
+    
+    for k, v in kwArgs.items():
+        if (v is not None) and (id(v) in madeTags):
+            digest = self._rawDigest(madeTags[id(v)])
+            
+            if digest is not None:
+                keyArgs[k] = (madeTags[id(v)], digest)
+    
+    cacheKey = cache.key(key, w.rest(), keyArgs)
+    w.reset()
+    
+    if cacheKey is None:
+        return f(w, **kwArgs)
+    
+    obj = cache.load(cacheKey)
+    
+    if obj is not None:
+        return obj
+    
+    obj = f(w, **kwArgs)
+    
+    if obj is None:
+        return None
+    
+    # A deferred table (like 'glyf') keeps a walker for the items it hasn't
+    # made yet, so it can't be pickled. If it has no attributes of its own
+    # it's cached as a plain copy with every item made; otherwise it isn't
+    # cached at all.
+    
+    if isinstance(type(obj), deferreddictmeta.FontDataMetaclass):
+        if obj._ATTRSPEC:
+            return obj
+        
+        toStore = type(obj)(dict(obj.items()))
+    
+    else:
+        toStore = obj
+    
+    cache.store(cacheKey, toStore)
+    return obj
+
 def _recalc_device_metrics(obj, **kwArgs):
     if b'CFF ' in obj:
         return  # don't try to recalc a CFF, at least for now
@@ -873,6 +982,39 @@ def _recalc_device_metrics(obj, **kwArgs):
         obj.__dict__['hdmxpicklefile'] = hpkl.name
         hpkl.close()
 
+def _startParallelBuild(jobs, count):
+    # Starts building the tables for the specified jobs, which are (editor,
+    # tag, kwArgs, perTableOptions) tuples, in count worker processes (or one
+    # per CPU, if count is True). Returns the pool (for the caller to close
+    # and join) and a list of AsyncResults, one per job, whose get() values
+    # are the pairs returned by Editor._buildTableString(); or (None, []) if
+    # no processes could be forked.
+    
+    global _buildState
+    
+    if (not jobs) or ('fork' not in multiprocessing.get_all_start_methods()):
+        return None, []
+    
+    # The workers are all forked when the pool is made, so they see
+    # _buildState, and the Editors as they are right now. A fork-context
+    # Pool is used because ProcessPoolExecutor only takes a context from
+    # Python 3.7 on.
+    
+    _buildState = jobs
+    
+    try:
+        pool = multiprocessing.get_context('fork').Pool(
+          (None if count is True else count))
+    
+    finally:
+        _buildState = None
+    
+    results = [
+      pool.apply_async(_buildInWorker, (i,))
+      for i in range(len(jobs))]
+    
+    return pool, results
+
 def _validate(obj, **kwArgs):
     toSkip = set(kwArgs.get('tablesToSkip', []))
     logger = kwArgs.pop('logger')
@@ -970,6 +1112,46 @@ def _validate(obj, **kwArgs):
 if 0:
     def __________________(): pass
 
+class _WOFFTableWalkers(dict):
+    """
+    A dict mapping table tags to walkers over the tables of a WOFF font, for
+    use as an Editor's pieceInfo. A table's data are only read (and inflated,
+    if compressed) the first time its walker is asked for; that walker is
+    then kept, so each table is inflated at most once, and tables that are
+    never used are never inflated at all.
+    """
+    
+    #
+    # Methods
+    #
+    
+    def __contains__(self, tag):
+        return tag in self.entries
+    
+    def __init__(self, w, entries):
+        """
+        Initializes the object with w, a walker over the whole WOFF file, and
+        entries, a dict mapping tags to (offset, compLength, origLength)
+        tuples from its table directory.
+        """
+        
+        super().__init__()
+        self.w = w
+        self.entries = entries
+    
+    def __missing__(self, tag):
+        offset, compLength, origLength = self.entries[tag]
+        s = self.w.piece(compLength, offset, relative=False)
+        
+        if compLength < origLength:
+            s = zlib.decompress(s, bufsize=origLength)
+        
+        if len(s) != origLength:
+            raise ValueError("WOFF table %r has the wrong length!" % (tag,))
+        
+        r = self[tag] = walkerbit.StringWalker(s)
+        return r
+
 class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
     """
     Editors are the fundamental object allowing access to all font data. They
@@ -1021,6 +1203,39 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
     # Methods
     #
     
+    def _buildTableString(self, tag, kwArgs, pto):
+        """
+        Builds the table with the specified tag into its own writer, and
+        returns a pair with the resulting binary string and its checksum.
+        This is used by buildBinary() for tables not in _serialBuildTags.
+        """
+        
+        if tag == b'CFF ':
+            # CFF only takes its own options, not the ones for the whole font
+            d = {
+              key: kwArgs[key]
+              for key in ('subroutinize', 'subroutinizeBudget')
+              if key in kwArgs}
+            
+            d.update(pto.get(tag, {}))
+        
+        else:
+            d = (_bbInfo[tag](self) if tag in _bbInfo else {})
+            d.update(kwArgs)
+            d.update(pto.get(tag, {}))
+        
+        obj = self[tag]
+        
+        if hasattr(obj, 'buildBinary'):
+            w = writer.LinkedWriter()
+            obj.buildBinary(w, **d)
+            s = w.binaryString()
+        
+        else:
+            s = obj
+        
+        return s, utilitiesbackend.utChecksum(s)
+    
     def _makeOffsetOrdering(self, forApple):
 #         if forApple:
 #             return sorted(self)
@@ -1039,6 +1254,147 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
         v.extend(sorted(set(self) - set(dOrder)))
         return v
     
+    def _rawChecksum(self, tag, s):
+        """
+        Returns the checksum for s, the raw (unchanged) data for the specified
+        table; s may be None, in which case the raw data are read here, a
+        megabyte at a time.
+        
+        The checksum in the source font's table directory is only used if
+        fromvalidatedwalker() found that it matches the data. Otherwise it
+        might be wrong, so the checksum is computed from the data and
+        remembered in the creation extras, keyed like the digests in
+        _rawDigest(), so a table written again (or shared by fonts read from
+        one TTC) is only summed once.
+        
+        >>> e = Editor.frommissingglyph(
+        ...   ttsimpleglyph._testingValues[2],
+        ...   hmtx.MtxEntry(advance=1000))
+        >>> s = bytearray(e.binaryString())
+        >>> tags = [bytes(s[i:i+4]) for i in range(12, 12 + 16 * s[5], 16)]
+        >>> i = 16 * tags.index(b'post') + 16
+        >>> s[i:i+4] = (int.from_bytes(s[i:i+4], 'big') + 1).to_bytes(4, 'big')
+        >>> fd, path = tempfile.mkstemp()
+        >>> os.write(fd, s) == len(s)
+        True
+        >>> os.close(fd)
+        >>> e2 = Editor.frompath(path)
+        >>> e2.name[(3, 1, 1033, 1)] = "Changed"
+        >>> e2.name = e2.name
+        >>> s2 = e2.binaryString()
+        >>> hex(utilitiesbackend.utChecksum(s2))
+        '0xb1b0afba'
+        >>> s2[i:i+4] == s[i:i+4]
+        False
+        >>> s2[i:i+4] == e.binaryString()[i:i+4]
+        True
+        
+        A validated read reuses the directory checksums that matched:
+        
+        >>> logger = logging.getLogger("rawChecksumTest")
+        >>> logger.addHandler(logging.NullHandler())
+        >>> logger.propagate = False
+        >>> e3 = Editor.fromvalidatedpath(path, logger=logger)
+        >>> verified = e3._creationExtras['verifiedChecksums']
+        >>> b'maxp' in verified, b'post' in verified
+        (True, False)
+        >>> e3.name[(3, 1, 1033, 1)] = "Changed"
+        >>> e3.name = e3.name
+        >>> e3.binaryString() == s2
+        True
+        >>> [key[0] for key in e3._creationExtras['rawChecksumCache']]
+        [b'post']
+        >>> os.remove(path)
+        """
+        
+        ce = self._creationExtras
+        
+        if tag in ce.get('verifiedChecksums', ()):
+            return ce['rawChecksums'][tag]
+        
+        rw = self.getRawWalker(tag)
+        
+        if rw is None:
+            return utilitiesbackend.utChecksum(s)
+        
+        d = ce.setdefault('rawChecksumCache', {})
+        key = (tag, rw.getOffset(), int(rw.length()))
+        
+        if key not in d:
+            if s is None:
+                size = key[2]
+                
+                d[key] = sum(
+                  utilitiesbackend.utChecksum(
+                    rw.piece(min(0x100000, size - i), i, relative=False))
+                  for i in range(0, size, 0x100000)) % 0x100000000
+            
+            else:
+                d[key] = utilitiesbackend.utChecksum(s)
+        
+        return d[key]
+    
+    def _rawDigest(self, tag):
+        """
+        Returns a BLAKE2b digest of the raw (unchanged) data for the specified
+        table, or None if there are no raw data. Digests are remembered in the
+        creation extras, keyed on the tag and where the data live in the
+        source; the fonts read from one TTC share this dict (see
+        CollectionEditor.fromwalker), so a table they share is hashed once.
+        
+        >>> e = Editor.frommissingglyph(
+        ...   ttsimpleglyph._testingValues[2],
+        ...   hmtx.MtxEntry(advance=1000))
+        >>> print(e._rawDigest(b'maxp'))
+        None
+        >>> fd, path = tempfile.mkstemp()
+        >>> os.close(fd)
+        >>> e.writeFont(path)
+        >>> e2 = Editor.frompath(path)
+        >>> raw = e2.getRawTable(b'maxp')
+        >>> e2._rawDigest(b'maxp') == hashlib.blake2b(raw, digest_size=20).digest()
+        True
+        >>> os.remove(path)
+        """
+        
+        rw = self.getRawWalker(tag)
+        
+        if rw is None:
+            return None
+        
+        d = self._creationExtras.setdefault('rawDigests', {})
+        key = (tag, rw.getOffset(), int(rw.length()))
+        
+        if key not in d:
+            d[key] = hashlib.blake2b(rw.rest(), digest_size=20).digest()
+        
+        return d[key]
+    
+    def _rawFileRange(self, tag, w):
+        """
+        If the writer w can take pieces straight from a file, and the raw data
+        for the specified table are in the file this Editor was read from,
+        returns a (path, offset, length) tuple for those data. Otherwise
+        returns None.
+        """
+        
+        ce = self._creationExtras
+        path = ce.get('originalPath')
+        
+        if (
+          path is None or
+          (not hasattr(w, 'addFileRange')) or
+          tag not in ce.get('rawChecksums', {})):
+          
+            return None
+        
+        rw = self.getRawWalker(tag)
+        
+        if not isinstance(rw, filewalkerbit.FileWalkerBit):
+            return None
+        
+        return (path, rw.getOffset(), int(rw.length()))
+    
     def _updateDependentObjects(self, **kwArgs):
         """
         """
@@ -1261,6 +1617,7 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
     def _validate_toc(w, logger, numTables, startOffset, endOfFile, fromTTC):
         okToProceed = True
         toc = []
+        verified = set()  # tags whose directory checksums match their data
         minValidOffset = startOffset + 12 + 16 * numTables
         csaOffset = None  # checkSumAdjustment absolute offset
         
@@ -1359,6 +1716,9 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
                     
                     allClear = False
                 
+                elif tag != b'head':
+                    verified.add(tag)
+                
                 if allClear:
                     logger.info((
                       'V0151',
@@ -1385,7 +1745,7 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
                   (cs, fontCSA),
                   "Font's checksum should be 0x%08X, but is 0x%08X."))
         
-        return okToProceed, toc
+        return okToProceed, toc, verified
     
     @staticmethod
     def _validate_topology(w, logger, toc, isTrueType, forApple, fromTTC):
@@ -1794,8 +2154,96 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
         risk of duplicate names for different tables being used for different
         purposes. Note that these values will override the ones in the default
         arguments dictionary that lives in _bbInfo.
+        
+        The 'CFF ' table only gets its own options: those in perTableOptions,
+        and the subroutinize and subroutinizeBudget keyword arguments (see
+        CFF.buildBinary()), so a CFF font can be subroutinized as it's written:
+        
+        >>> e = Editor.frommissingglyph(
+        ...   ttsimpleglyph._testingValues[2],
+        ...   hmtx.MtxEntry(advance=1000))
+        >>> del e[b'glyf'], e[b'loca']
+        >>> e[b'CFF '] = CFF.CFF.fromwalker(
+        ...   walker.StringWalker(utilities.fromhex(CFF._testingData)))
+        >>> cs = utilities.fromhex(
+        ...   "8C 8B BD F7 ED 77 F7 A7 BD 01 8B BD F8 24 BD 03 "
+        ...   "8B 04 F8 88 F9 50 FC 88 06 F7 8E FB C5 15 FB 3E "
+        ...   "F7 93 05 F7 E8 06 FB 20 FB C0 15 F7 3E F7 93 05 "
+        ...   "FC 92 07 FC 06 5E 15 F7 3E F7 93 F7 3E FB 93 05 "
+        ...   "FC 06 F8 BF 15 F7 3E FB 93 FB 3E FB 93 05 0E")
+        >>> for i in range(2, 12):
+        ...     e[b'CFF '][i] = cffglyph.CFFGlyph.fromcffdata(
+        ...       cs,
+        ...       {'nominalWidthX': 499},
+        ...       [],
+        ...       {})
+        >>> s = e.binaryString()
+        >>> pto = {b'CFF ': {'subroutinize': True}}
+        >>> sSub = e.binaryString(perTableOptions=pto)
+        >>> sSub == e.binaryString(subroutinize=True)
+        True
+        >>> len(sSub) < len(s)
+        True
+        >>> fd, path = tempfile.mkstemp()
+        >>> os.close(fd)
+        >>> for bs in (s, sSub):
+        ...     with open(path, "wb") as f:
+        ...         n = f.write(bs)
+        ...     e2 = Editor.frompath(path)
+        ...     print(e2[b'CFF '] == e[b'CFF '])
+        True
+        True
+        >>> os.remove(path)
+        
+        Tables that were never made, or that have not been changed since the
+        font was read, are not rebuilt; their original bytes are copied
+        straight from the source, along with their original checksums.
+        
+        Changed tables other than those in _serialBuildTags (whose building
+        affects other tables) are each built into their own writer. If the
+        parallelBuild keyword argument is specified, these tables are built
+        in that many worker processes (or one per CPU, if it's True), while
+        the serial tables like 'glyf' are built here. This needs the fork
+        start method, since the workers get the Editor by inheriting it; on
+        other systems, and for any table that fails in a worker, the tables
+        are built here as usual. Either way the font comes out the same:
+        
+        >>> e = Editor.frommissingglyph(
+        ...   ttsimpleglyph._testingValues[2],
+        ...   hmtx.MtxEntry(advance=1000))
+        >>> for tag in list(e):
+        ...     e[tag] = e[tag]
+        >>> e.binaryString(parallelBuild=2) == e.binaryString()
+        True
+        
+        If a directoryCallback keyword argument is specified, it is called
+        once the font is built with a dict mapping each table's tag to a
+        (checksum, offset, length) tuple, where the offset is relative to the
+        start of the font. This lets clients (like writeWoffFont) find the
+        tables in the output without parsing its table directory.
+        
+        >>> e = Editor.frommissingglyph(
+        ...   ttsimpleglyph._testingValues[2],
+        ...   hmtx.MtxEntry(advance=1000))
+        >>> directory = {}
+        >>> s = e.binaryString(directoryCallback=directory.update)
+        >>> toc = {
+        ...   s[i:i+4]: struct.unpack_from(">3L", s, i + 4)
+        ...   for i in range(12, 12 + 16 * len(directory), 16)}
+        >>> sorted(toc) == sorted(directory) == sorted(e)
+        True
+        >>> all(directory[tag] == toc[tag] for tag in toc)
+        True
+        >>> all(
+        ...   utilitiesbackend.utChecksum(s[offset:offset+length]) == checksum
+        ...   for tag, (checksum, offset, length) in directory.items()
+        ...   if tag != b'head')
+        True
         """
         
+        directoryCallback = kwArgs.pop('directoryCallback', None)
+        parallelBuild = kwArgs.pop('parallelBuild', False)
+        
         if 'stakeValue' in kwArgs:
             stakeValue = kwArgs.pop('stakeValue')
             w.stakeCurrentWithValue(stakeValue)
@@ -1803,6 +2251,7 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
             stakeValue = w.stakeCurrent()
         
         self._updateDependentObjects(**kwArgs)
+        headerStart = w.byteLength
         
         if kwArgs.get('forApple', False):
             w.addString(b"true")
@@ -1821,9 +2270,12 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
             w.addUnresolvedOffset("L", stakeValue, tagOffsetStake[tag])
             w.addUnresolvedIndex("L", "lengths", tag)
         
+        headerStop = w.byteLength
+        
         # Now add the actual tables
         checksums = {tag: 0 for tag in self}
         lengths = checksums.copy()
+        offsets = checksums.copy()
         w.addIndexMap("checksums", checksums)  # temp, for w.checkSum() calls
         w.addIndexMap("lengths", lengths)  # temp, for w.checkSum() calls
         self.head.checkSumAdjustment = 0
@@ -1840,7 +2292,22 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
             ck.add(b'TSI2')
             ck.discard(b'TSI3')
         
-        for tag in self._makeOffsetOrdering(kwArgs.get('forApple', False)):
+        ordering = self._makeOffsetOrdering(kwArgs.get('forApple', False))
+        results = {}
+        pool = None
+        
+        if parallelBuild:
+            toBuild = [
+              tag for tag in ordering
+              if tag in ck and tag not in _serialBuildTags]
+            
+            pool, v = _startParallelBuild(
+              [(self, tag, kwArgs, pto) for tag in toBuild],
+              parallelBuild)
+            
+            results = dict(zip(toBuild, v))
+        
+        for tag in ordering:
             bsForced = None
             
             if (tag == b'TSI1') and (b'TSI0' in ck):
@@ -1851,11 +2318,33 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
             
             w.stakeCurrentWithValue(tagOffsetStake[tag])
             startByteLength = w.byteLength
+            offsets[tag] = startByteLength - headerStart
             
             if tag not in ck:
-                s = self.getRawTable(tag)
+                fileRange = self._rawFileRange(tag, w)
+                
+                if fileRange is not None:
+                    w.addFileRange(*fileRange)
+                    checksums[tag] = self._rawChecksum(tag, None)
+                
+                else:
+                    s = self.getRawTable(tag)
+                    w.addString(s)
+                    checksums[tag] = self._rawChecksum(tag, s)
+            
+            elif tag not in _serialBuildTags:
+                try:
+                    s, checksums[tag] = results[tag].get()
+                
+                except Exception:
+                    # Not built in a worker (or it failed there, in which
+                    # case building it here raises the same exception).
+                    s, checksums[tag] = self._buildTableString(
+                      tag,
+                      kwArgs,
+                      pto)
+                
                 w.addString(s)
-                checksums[tag] = utilitiesbackend.utChecksum(s)
             
             else:
                 d = (_bbInfo[tag](self) if tag in _bbInfo else {})
@@ -1872,11 +2361,6 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
                     d['locCallback'] = _lc
                     d['forApple'] = False  # override this
                     ck.add(b'CBLC')
-
-                elif tag == b'CFF ':
-                    wCFFCached = writer.LinkedWriter()
-                    self['CFF '].buildBinary(wCFFCached)
-                    bsForced = wCFFCached.binaryString()
                 
                 elif tag == b'EBDT':
                     def _lc(newLoc): self.EBLC = newLoc
@@ -1947,6 +2431,7 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
                     w.alignToByteMultiple(4)
                     w.stakeCurrentWithValue(tagOffsetStake[b'TSI1'])
                     startByteLength = w.byteLength
+                    offsets[b'TSI1'] = startByteLength - headerStart
                     w.addString(sTSI1)
                     undoneChecksums[b'TSI1'] = (startByteLength, w.byteLength)
                     lengths[b'TSI1'] = len(sTSI1)
@@ -1968,6 +2453,7 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
                     w.alignToByteMultiple(4)
                     w.stakeCurrentWithValue(tagOffsetStake[b'TSI3'])
                     startByteLength = w.byteLength
+                    offsets[b'TSI3'] = startByteLength - headerStart
                     w.addString(sTSI3)
                     undoneChecksums[b'TSI3'] = (startByteLength, w.byteLength)
                     lengths[b'TSI3'] = len(sTSI3)
@@ -1996,6 +2482,10 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
             lengths[tag] = w.byteLength - startByteLength
             w.alignToByteMultiple(4)
         
+        if pool is not None:
+            pool.close()
+            pool.join()
+        
         for tag, (start, stop) in undoneChecksums.items():
             checksums[tag] = w.checkSum(start, stop)
         
@@ -2004,11 +2494,21 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
         w.addIndexMap("checksums", checksums)
         w.deleteIndexMap("lengths")
         w.addIndexMap("lengths", lengths)
-        # we checksum with zero in the 'head' checkSumAdjustment
-        totalChecksum = w.checkSum()
+        # we checksum with zero in the 'head' checkSumAdjustment. Since every
+        # table starts on a 4-byte boundary and is zero-padded, the whole-font
+        # checksum is the header's checksum plus the tables' checksums (each
+        # computed from the bytes written; see _rawChecksum()); this avoids
+        # rereading tables that were added as file ranges.
+        totalChecksum = w.checkSum(headerStart, headerStop)
+        totalChecksum += sum(checksums.values())
         adjValue = (0xB1B0AFBA - totalChecksum) % 0x100000000
         w.deleteIndexMap("headAdj")
         w.addIndexMap("headAdj", {'head': adjValue})
+        
+        if directoryCallback is not None:
+            directoryCallback({
+              tag: (checksums[tag], offsets[tag], lengths[tag])
+              for tag in checksums})
     
     def buildBinary_headerOnly(
       self,
@@ -2058,10 +2558,17 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
       **kwArgs):
         
         """
+        Adds the tables for the font at familyIndex in a CollectionEditor.
+        Only the tables for which this font is the avatar in uniques are
+        added. If the built keyword argument is specified, it maps (index,
+        tag) pairs to the (binary string, checksum) pairs for tables already
+        built by the CollectionEditor, which are used instead of building
+        those tables again.
         """
         
         ck = changedKeys[familyIndex] | {b'head'}
         pto = kwArgs.pop('perTableOptions', {})
+        built = kwArgs.pop('built', {})
         wGlyfCached = None
         
         if b'TSI0' in ck or b'TSI1' in ck:
@@ -2083,8 +2590,14 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
             
             # we only output a table if it's an avatar in uniques
             if familyIndex in uniques[tag]:
+                cs = None
+                
                 if tag not in ck:
                     s = self.getRawTable(tag)
+                    cs = self._rawChecksum(tag, s)
+                
+                elif (familyIndex, tag) in built:
+                    s, cs = built[(familyIndex, tag)]
                 
                 else:
                     d = (_bbInfo[tag](self) if tag in _bbInfo else {})
@@ -2183,7 +2696,10 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
                             s = self[tag]
                     
                 w.stakeCurrentWithValue(stakes[familyIndex][tag])
-                cs = utilitiesbackend.utChecksum(s)
+                
+                if cs is None:
+                    cs = utilitiesbackend.utChecksum(s)
+                
                 checksums[(familyIndex, tag)] = cs
                 lengths[(familyIndex, tag)] = len(s)
                 
@@ -2192,18 +2708,44 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
                     checksums[(otherIndex, tag)] = cs
                     lengths[(otherIndex, tag)] = len(s)
                 
-                w.addString(s)
+                if tag == b'head':
+                    # the checkSumAdjustment is filled in later, by
+                    # buildBinary_headAdjustment()
+                    w.addString(s[:8])
+                    w.addUnresolvedIndex("L", ("headAdj", familyIndex), 'head')
+                    w.addIndexMap(("headAdj", familyIndex), {'head': 0})
+                    w.addString(s[12:])
+                
+                else:
+                    w.addString(s)
+                
                 w.alignToByteMultiple(4)
+    
+    def buildBinary_headAdjustment(
+      self,
+      w,
+      familyIndex,
+      checksums,
+      headerChecksumRanges):
+        
+        """
+        Fills in the 'head' checkSumAdjustment for the font at familyIndex in
+        a CollectionEditor. This is called once the tables for all the fonts
+        have been added, since only then are all the offsets in this font's
+        table directory known. As in buildBinary(), the whole-font checksum
+        is the directory's checksum plus the checksums of the tables, all of
+        which were computed from the bytes being written.
+        """
         
-        # Now do final 'head' adjustment
         start, stop = headerChecksumRanges[familyIndex]
-        totalChecksum = w.checkSum(start, stop, unresolvedOK=True)
+        totalChecksum = w.checkSum(start, stop)
         
         for index, tag in sorted(checksums):
             if index == familyIndex:
                 totalChecksum += checksums[(index, tag)]
         
         adjValue = (0xB1B0AFBA - totalChecksum) % 0x100000000
+        w.deleteIndexMap(("headAdj", familyIndex))
         w.addIndexMap(("headAdj", familyIndex), {'head': adjValue})
     
     @classmethod
@@ -2354,7 +2896,7 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
         if not okToProceed:
             return None
         
-        okToProceed, toc = cls._validate_toc(
+        okToProceed, toc, verified = cls._validate_toc(
           w,
           logger,
           numTables,
@@ -2385,6 +2927,7 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
         w.skip(startOffset)
         kwArgs.pop('doValidation', None)
         r = cls.fromwalker(w, doValidation=True, logger=logger, **kwArgs)
+        r._creationExtras['verifiedChecksums'] = verified
         tablesToValidate = sorted(set(r) - set(kwArgs.get('tablesToSkip', [])))
         skippedTables = sorted(set(r) - set(tablesToValidate))
         
@@ -2404,19 +2947,100 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
     @classmethod
     def fromwalker(cls, w, **kwArgs):
         """
+        Returns a new Editor from the specified walker, which may be for an
+        sfnt font or a WOFF font. No tables are made here; each is made when
+        it is first used. For a WOFF font, a table's data are not even read
+        and inflated until then, so a client only looking at the 'name' table
+        never pays for inflating 'glyf'.
+        
+        >>> e = Editor.frommissingglyph(
+        ...   ttsimpleglyph._testingValues[2],
+        ...   hmtx.MtxEntry(advance=1000))
+        >>> fd, path = tempfile.mkstemp()
+        >>> os.close(fd)
+        >>> e.writeWoffFont(path)
+        >>> e2 = Editor.frompath(path)
+        >>> e2.name == e.name
+        True
+        >>> sorted(e2._creationExtras['pieceInfo'])
+        [b'name']
+        >>> e2.glyf[1] == e.glyf[1]
+        True
+        
+        If a tableCache keyword argument is specified (a TableCache, or the
+        path to its directory), tables are kept there once they're made, and
+        loaded from there the next time a font with the same table is read,
+        instead of being parsed again. This is only done for fonts read
+        without validation, since a cached table logs nothing.
+        
+        >>> cacheDir = tempfile.mkdtemp()
+        >>> e2 = Editor.frompath(path, tableCache=cacheDir)
+        >>> e2.name == e.name
+        True
+        >>> len(os.listdir(cacheDir))
+        1
+        >>> tc = tablecache.TableCache(cacheDir)
+        >>> e3 = Editor.frompath(path, tableCache=tc)
+        >>> e3.name == e.name, tc.hits
+        (True, 1)
+        
+        A table given other tables of the font is keyed by their raw data, as
+        long as they haven't been changed. So GPOS, which is always given
+        GDEF for its mark filtering sets, is cached; and so is glyf, which
+        has every glyph made before it's stored. Reading this font again gets
+        GPOS, head (which says how to read 'loca') and glyf from the cache;
+        GDEF is given the Editor itself, so it is always parsed:
+        
+        >>> e.GDEF = GDEF_v1._testingValues[1]
+        >>> e.GPOS = GPOS_v10._testingValues[1].__deepcopy__()
+        >>> for featureTable in e.GPOS.features.values():
+        ...     for lookupObj in featureTable:
+        ...         lookupObj.markFilteringSet = e.GDEF.markSets[1]
+        >>> e.writeFont(path)
+        >>> Editor.frompath(path).GPOS == e.GPOS
+        True
+        >>> e4 = Editor.frompath(path, tableCache=tc)
+        >>> e4.GPOS == e.GPOS, e4.glyf == e.glyf
+        (True, True)
+        >>> hits = tc.hits
+        >>> e5 = Editor.frompath(path, tableCache=tc)
+        >>> e5.GPOS == e.GPOS, e5.glyf == e.glyf, tc.hits - hits
+        (True, True, 3)
+        >>> os.remove(path)
+        >>> shutil.rmtree(cacheDir)
         """
         
         version = w.unpack("4s", advance=False)
-        toc = w.group("4s3L", w.unpack("4xH6x"))
-        otki = (obj[0] for obj in toc)
-        pieceInfo = {}
+        rawChecksums = {}
+        
+        if version == b'wOF2':
+            raise ValueError("WOFF2 fonts are not supported!")
+        
+        elif version == b'wOFF':
+            version, numTables = w.unpack("4x4s4xH30x")
+            entries = {}
+            
+            for t in w.group("4s4L", numTables):
+                tag, offset, compLength, origLength, checksum = t
+                entries[tag] = (offset, compLength, origLength)
+                rawChecksums[tag] = checksum
+            
+            otki = iter(list(entries))
+            pieceInfo = _WOFFTableWalkers(w, entries)
         
-        for tag, ignore, offset, size in toc:
-            pieceInfo[tag] = w.subWalker(offset, newLimit=offset+size)
+        else:
+            toc = w.group("4s3L", w.unpack("4xH6x"))
+            otki = (obj[0] for obj in toc)
+            pieceInfo = {}
+            
+            for tag, checksum, offset, size in toc:
+                pieceInfo[tag] = w.subWalker(offset, newLimit=offset+size)
+                rawChecksums[tag] = checksum
         
         ce = dict(
           oneTimeKeyIterator = otki,
           pieceInfo = pieceInfo,
+          rawChecksums = rawChecksums,
           doValidation = kwArgs.get('doValidation', False),
           logger = kwArgs.get('logger', None),
           tablesToSkip = kwArgs.get('tablesToSkip', []),
@@ -2424,6 +3048,14 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
           perTableOptions = kwArgs.get('perTableOptions', {}),
           version=version)
         
+        tc = kwArgs.get('tableCache', None)
+        
+        if tc is not None and not ce['doValidation']:
+            if not isinstance(tc, tablecache.TableCache):
+                tc = tablecache.TableCache(tc)
+            
+            ce['tableCache'] = tc
+        
         return cls(creationExtras=ce)
     
     def getNamer(self):
@@ -2571,6 +3203,135 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
 
         return r
     
+    def instanced(self, coords, **kwArgs):
+        """
+        Returns a new Editor with the static instance of this TrueType variable
+        font at the specified coordinates. These are normalized, one for each
+        axis in the Gvar object's axisOrder, just as for Glyf.getVariation().
+        
+        The new 'glyf' table comes from Glyf.instanced(), which computes the
+        scalar for each tuple once and then moves all the glyphs together on
+        native threads. The advances in the new 'hmtx' table are adjusted by
+        the 'HVAR' deltas if that table is present, or by the phantom point
+        deltas otherwise, and are never less than zero. The outlines are not
+        shifted to keep the origin in place, so the sidebearing of a changed
+        glyph is its new xMin less the x of its moved first phantom point, as
+        in the fontTools instancer. The variation tables ('avar', 'cvar', 'fvar',
+        'gvar', 'HVAR', 'MVAR' and 'VVAR') are not copied to the new Editor.
+        
+        The following keyword arguments are supported:
+        
+            threadCount     The number of native threads to use. Default is
+                            0, meaning one per CPU.
+        
+        A ValueError is raised if the Editor has no 'gvar' table.
+        
+        >>> AC = axial_coordinate.AxialCoordinate
+        >>> peak = axial_coordinates.AxialCoordinates(
+        ...   [AC(1.0)],
+        ...   axisOrder = ('wght',))
+        >>> pd = point_dict.PointDict({
+        ...   0: deltas_dict.DeltasDict({peak: deltas.Deltas(-20, 0)}),
+        ...   9: deltas_dict.DeltasDict({peak: deltas.Deltas(100, 0)})})
+        >>> e = utilities.fakeEditor(3, hmtx={1: 1200, 2: 1200})
+        >>> e.hmtx[1] = e.hmtx[2] = hmtx.MtxEntry(1200, 620)
+        >>> e.glyf = glyf.Glyf({
+        ...   0: ttsimpleglyph.TTSimpleGlyph(),
+        ...   1: ttsimpleglyph._testingValues[2],
+        ...   2: ttsimpleglyph._testingValues[2]})
+        >>> e.gvar = gvar.Gvar(
+        ...   axisOrder = ('wght',),
+        ...   glyphData = glyph_dict.GlyphDict({1: pd}))
+        >>> e2 = e.instanced((0.5,))
+        >>> e2.reallyHas(b'gvar'), e.reallyHas(b'gvar')
+        (False, True)
+        >>> [(m.advance, m.sidebearing) for m in e2.hmtx.values()]
+        [(0, 0), (1250, 610), (1200, 620)]
+        
+        When the origin moves the outline stays put, so the sidebearing takes
+        up the difference; advances are clamped at zero:
+        
+        >>> pd[8] = deltas_dict.DeltasDict({peak: deltas.Deltas(40, 0)})
+        >>> pd[9] = deltas_dict.DeltasDict({peak: deltas.Deltas(-2500, 0)})
+        >>> e2 = e.instanced((0.5,))
+        >>> [(m.advance, m.sidebearing) for m in e2.hmtx.values()]
+        [(0, 0), (0, 590), (1200, 620)]
+        >>> print(e2.glyf[1].bounds)
+        Minimum X = 610, Minimum Y = 610, Maximum X = 970, Maximum Y = 1090
+        >>> del pd[8]
+        >>> pd[9] = deltas_dict.DeltasDict({peak: deltas.Deltas(100, 0)})
+        
+        If there is an 'HVAR' table its deltas are used for the advances:
+        
+        >>> region = LivingRegion.fromdict({'wght': (0.0, 1.0, 1.0)})
+        >>> ld = LivingDeltas({LivingDeltasMember((region, -60))})
+        >>> e.HVAR = HVAR.HVAR(
+        ...   advances = livingdeltas_dict.LivingDeltasDict({1: ld, 2: ld}))
+        >>> e2 = e.instanced((0.5,), threadCount=1)
+        >>> [(m.advance, m.sidebearing) for m in e2.hmtx.values()]
+        [(0, 0), (1170, 610), (1170, 620)]
+        """
+        
+        if not self.reallyHas(b'gvar'):
+            raise ValueError("Editor has no 'gvar' table!")
+        
+        glyfObj, final4s = self.glyf.instanced(coords, editor=self, **kwArgs)
+        
+        if self.reallyHas(b'HVAR'):
+            d = dict(zip(self.gvar.axisOrder, coords))
+            lac = LivingAxialCoordinate.fromdict(d)
+            
+            advDeltas = {
+              glyphIndex: int(round(ldObj.interpolate(lac)))
+              for glyphIndex, ldObj in self.HVAR.advances.items()}
+        
+        else:
+            advDeltas = {
+              glyphIndex: final4[1][0] - final4[0][0]
+              for glyphIndex, final4 in final4s.items()}
+        
+        oldGlyf = self.glyf
+        hmtxObj = hmtx.Hmtx()
+        
+        for glyphIndex, mtxObj in self.hmtx.items():
+            obj = glyfObj.get(glyphIndex)
+            oldObj = oldGlyf.get(glyphIndex)
+            sidebearing = mtxObj.sidebearing
+            
+            if (
+              (obj is not None) and
+              (obj is not oldObj) and
+              (obj.bounds is not None)):
+                
+                # the origin is where the first phantom point ends up
+                originX = 0
+                
+                if (oldObj is not None) and (oldObj.bounds is not None):
+                    originX = oldObj.bounds.xMin - sidebearing
+                
+                if glyphIndex in final4s:
+                    originX += final4s[glyphIndex][0][0]
+                
+                sidebearing = obj.bounds.xMin - originX
+            
+            hmtxObj[glyphIndex] = hmtx.MtxEntry(
+              max(0, mtxObj.advance + advDeltas.get(glyphIndex, 0)),
+              sidebearing)
+        
+        r = self.__copy__()
+        r._dOrig = r._dOrig.copy()
+        r._dAdded = r._dAdded.copy()
+        r.glyf = glyfObj
+        r.hmtx = hmtxObj
+        
+        for tag in (b'avar', b'cvar', b'fvar', b'gvar', b'HVAR', b'MVAR', b'VVAR'):
+            if tag in r:
+                del r[tag]
+        
+        r.changed(b'glyf')
+        r.changed(b'hmtx')
+        return r
+    
     def setRawTable(self, key, value, **kwArgs):
         """
         Sets the value (which must be a bytestring) for the specified key. The
@@ -2635,6 +3396,72 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
         f = open(path, "wb")
         f.write(self.binaryString(**kwArgs))
         f.close()
+    
+    def writeFontIncremental(self, path, **kwArgs):
+        """
+        Writes the font to the specified path, like writeFont(), but without
+        ever building the whole font in memory. Changed tables are built into
+        a LinkedFileWriter, whose pieces live in a temporary file; tables that
+        are unchanged since the font was read from a file are copied straight
+        from that file into the new one (using copy_file_range or sendfile
+        where the system supports them). The keyword arguments are the same as
+        for buildBinary().
+        
+        The path may be the same as the one the font was read from; in this
+        case the new font is written to a temporary file in the same directory
+        which then replaces the original, so the data being copied are never
+        overwritten while they're still needed. The replacement keeps the
+        original file's permissions.
+        
+        >>> e = Editor.frommissingglyph(
+        ...   ttsimpleglyph._testingValues[2],
+        ...   hmtx.MtxEntry(advance=1000))
+        >>> fd, path = tempfile.mkstemp()
+        >>> os.close(fd)
+        >>> e.writeFont(path)
+        >>> os.chmod(path, 0o640)
+        >>> e2 = Editor.frompath(path)
+        >>> e2.name[(3, 1, 1033, 1)] = "Changed"
+        >>> e2.name = e2.name
+        >>> s = e2.binaryString()
+        >>> path2 = path + ".out"
+        >>> e2.writeFontIncremental(path2)
+        >>> open(path2, "rb").read() == s
+        True
+        >>> e2.writeFontIncremental(path)
+        >>> open(path, "rb").read() == s
+        True
+        >>> oct(os.stat(path).st_mode & 0o777)
+        '0o640'
+        >>> os.remove(path)
+        >>> os.remove(path2)
+        """
+        
+        w = filewriter.LinkedFileWriter()
+        self.buildBinary(w, **kwArgs)
+        origPath = self._creationExtras.get('originalPath')
+        
+        if (
+          origPath is not None and
+          os.path.exists(path) and
+          os.path.samefile(origPath, path)):
+          
+            fd, tempPath = tempfile.mkstemp(
+              dir = os.path.dirname(os.path.abspath(path)))
+            
+            os.close(fd)
+            
+            try:
+                w.writeToFile(tempPath)
+                shutil.copymode(path, tempPath)  # mkstemp made it 0o600
+                os.replace(tempPath, path)
+            
+            except:
+                os.remove(tempPath)
+                raise
+        
+        else:
+            w.writeToFile(path)
 
     def writeEOTFont(self, path, **kwArgs):
         """
@@ -2726,31 +3553,93 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
         Write Editor as a WOFF file. Optional meta and private data
         to include as part of the WOFF may be specified with the
         'metadata' or 'privatedata' kwArgs.
+        
+        The tables are found in the built font via buildBinary()'s
+        directoryCallback, and are compressed concurrently in a pool of
+        threads (zlib releases the GIL while it works). These keyword
+        arguments control the compression:
+        
+            compressionLevel    The zlib compression level to use. Default
+                                is 9, or 6 if fastCompression is True.
+            
+            fastCompression     Default is False; if True, a faster (if
+                                slightly larger) level is used. This is
+                                useful for fonts not headed for production.
+            
+            maxWorkers          The maximum number of compression threads.
+                                Default is None, which lets the thread pool
+                                decide.
+        
+        Whatever the compression, the tables read back from the WOFF font are
+        the same as those in the sfnt font:
+        
+        >>> e = Editor.frommissingglyph(
+        ...   ttsimpleglyph._testingValues[2],
+        ...   hmtx.MtxEntry(advance=1000))
+        >>> fd, path = tempfile.mkstemp()
+        >>> os.close(fd)
+        >>> e.writeFont(path + ".ttf")
+        >>> sfnt = Editor.frompath(path + ".ttf")
+        >>> sizes = []
+        >>> for kw in ({}, {'fastCompression': True}, {'compressionLevel': 1}):
+        ...     e.writeWoffFont(path, **kw)
+        ...     sizes.append(os.path.getsize(path))
+        ...     e2 = Editor.frompath(path)
+        ...     print(all(
+        ...       e2.getRawTable(tag) == sfnt.getRawTable(tag)
+        ...       for tag in sfnt))
+        True
+        True
+        True
+        >>> sizes[0] <= sizes[1] <= sizes[2]
+        True
+        >>> os.remove(path)
+        >>> os.remove(path + ".ttf")
         """
         
-        sbb = self.binaryString(**kwArgs)
-        sfntSize = len(sbb)
-        sb = io.BytesIO(sbb)
+        fast = kwArgs.pop('fastCompression', False)
+        level = kwArgs.pop('compressionLevel', (6 if fast else 9))
+        maxWorkers = kwArgs.pop('maxWorkers', None)
+        metadata = kwArgs.pop('metadata', b"")
+        privatedata = kwArgs.pop('privatedata', b"")
+        
+        if isinstance(metadata, str):
+            metadata = metadata.encode('utf-8')
         
-        metadata = kwArgs.get('metadata', "")
         # metadata MUST be well-formed XML; if it's not, we don't include it.
         try:
             md = minidom.parseString(metadata)
         except ExpatError:
-            metadata = ""
+            metadata = b""
+        
+        metadataCmp = zlib.compress(metadata, level)
+        directory = {}
+        sbb = self.binaryString(directoryCallback=directory.update, **kwArgs)
+        sfntView = memoryview(sbb)
+        
+        def _compress(tag):
+            ignore, offset, length = directory[tag]
+            tblRaw = sfntView[offset:offset+length]
+            tblCmp = zlib.compress(tblRaw, level)
+            return (bytes(tblRaw) if len(tblCmp) >= length else tblCmp)
+        
+        # Start the biggest tables first, so they don't end up running alone
+        # after all the small ones are finished.
+        
+        bySize = sorted(directory, key=lambda t: -directory[t][2])
+        
+        with concurrent.futures.ThreadPoolExecutor(maxWorkers) as ex:
+            dCmp = dict(zip(bySize, ex.map(_compress, bySize)))
         
-        metadataCmp = zlib.compress(metadata, 9)
-        privatedata = kwArgs.get('privatedata', "")
         wb = writer.LinkedWriter()
         tStart = wb.stakeCurrent()
         wb.addString(b'wOFF')                                # WOFF signature
-        wb.addString(sb.read(4))                             # flavor
+        wb.addString(sbb[0:4])                               # flavor
         tEnd = wb.getNewStake()                              
         wb.addUnresolvedOffset("L", tStart, tEnd)            # WOFF length
-        numTables = struct.unpack(">H", sb.read(2))[0]
-        wb.add("H", numTables)                               # numTables
+        wb.add("H", len(directory))                          # numTables
         wb.add("H", 0)                                       # reserved (0)
-        wb.add("L", sfntSize)                                # totalSfntSize
+        wb.add("L", len(sbb))                                # totalSfntSize
         wb.add("L", self.head.fontRevision)                  # majorVersion, minorVersion
 
         if metadata:
@@ -2770,33 +3659,23 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
 
         
         # Table Directory
-        sb.seek(12)
-        dTKOL = {}
         tOFstakes = {}
-        tLCstakes = {}
-        for t in range(numTables):
-            ttag, tcks, toff, tlen = struct.unpack(">LLLL", sb.read(16))
-            dTKOL[t] = (ttag, tcks, toff, tlen)
-
-            wb.add("L", ttag)                                    # tag
-            tOFstakes[t] = wb.getNewStake()
-            wb.addUnresolvedOffset("L", tStart, tOFstakes[t])    # offset
-            tLCstakes[t] = wb.addDeferredValue("L")              # lenCompressed
+        for tag in sorted(directory):
+            tcks, toff, tlen = directory[tag]
+            wb.addString(tag)                                    # tag
+            tOFstakes[tag] = wb.getNewStake()
+            wb.addUnresolvedOffset("L", tStart, tOFstakes[tag])  # offset
+            wb.add("L", len(dCmp[tag]))                          # lenCompressed
             wb.add("L", tlen)                                    # lenUncompressed
             wb.add("L", tcks)                                    # checksumUncompressed
 
 
         # Table Data
-        tOrder = sorted(dTKOL, key=lambda x:dTKOL[x][2])
-        for t in tOrder:
+        tOrder = sorted(directory, key=lambda x:directory[x][1])
+        for tag in tOrder:
             wb.alignToByteMultiple(4)
-            sb.seek(dTKOL[t][2])
-            tblRaw = sb.read(dTKOL[t][3])
-            tblCmp = zlib.compress(tblRaw, 9)
-            if len(tblCmp) >= len(tblRaw): tblCmp = tblRaw
-            wb.setDeferredValue(tLCstakes[t], "L", len(tblCmp))
-            wb.stakeCurrentWithValue(tOFstakes[t])
-            wb.addString(tblCmp)            
+            wb.stakeCurrentWithValue(tOFstakes[tag])
+            wb.addString(dCmp[tag])
         wb.alignToByteMultiple(4)
         
         # meta and private data, if present
@@ -2825,6 +3704,30 @@ class Editor(object, metaclass=deferreddictmeta.FontDataMetaclass):
 if 0:
     def __________________(): pass
 
+if __debug__:
+    from fontio3 import utilities
+    from fontio3.CFF import cffglyph
+    from fontio3.GDEF import GDEF_v1
+    from fontio3.glyf import ttsimpleglyph
+    from fontio3.GPOS import GPOS_v10
+    
+    from fontio3.gvar import (
+      axial_coordinate,
+      axial_coordinates,
+      deltas,
+      deltas_dict,
+      glyph_dict,
+      point_dict)
+    
+    from fontio3.HVAR import livingdeltas_dict
+    
+    from fontio3.opentype.living_variations import (
+      LivingDeltas,
+      LivingDeltasMember,
+      LivingRegion)
+    
+    from fontio3.utilities import walker
+
 def _test():
     import doctest
     doctest.testmod()
@@ -10,15 +10,17 @@ to make the performance acceptable for even very large fonts.
 """
 
 # System imports
+import array
 import collections
 import functools
 import itertools
 import logging
 
 # Other imports
-from fontio3 import loca
+from fontio3 import fastmathbackend, loca
 from fontio3.fontdata import deferreddictmeta
 from fontio3.glyf import ttbounds, ttcompositeglyph, ttsimpleglyph
+from fontio3.utilities import walkerbit
 
 # -----------------------------------------------------------------------------
 
@@ -27,8 +29,7 @@ from fontio3.glyf import ttbounds, ttcompositeglyph, ttsimpleglyph
 #
 
 def _ddFactory(key, d):
-    offset, byteLength = d['loca'][key]
-    w = d['wGlyf'].subWalker(offset, relative=True, newLimit=byteLength)
+    w = walkerbit.StringWalker(d['wGlyf'].glyphSlice(d['locaOffsets'], key))
     
     if w.stillGoing():
         if d['doValidation']:
@@ -70,6 +71,24 @@ def _doFinal4(pdMod, startPoint):
       pdMod.get(p, (0, 0))
       for p in range(startPoint, startPoint + 4))
 
+def _sumScaledTuples(tuples, count):
+    """
+    Returns a pair of lists with the rounded sums of the scaled x and y deltas
+    from the specified PointDict.scaledTuples() output, for indices 0 through
+    count - 1. No inferencing is done, as is correct for composite glyphs.
+    """
+    
+    xs = [0.0] * count
+    ys = [0.0] * count
+    
+    for scalar, points, xDeltas, yDeltas in tuples:
+        for p, dx, dy in zip(points, xDeltas, yDeltas):
+            if p < count:
+                xs[p] += scalar * dx
+                ys[p] += scalar * dy
+    
+    return [int(round(n)) for n in xs], [int(round(n)) for n in ys]
+
 def _recalc_all(glyfObj, **kwArgs):
     allGlyphSet = set(glyfObj)
     r = glyfObj.__copy__()
@@ -186,80 +205,24 @@ class Glyf(object, metaclass=deferreddictmeta.FontDataMetaclass):
     @staticmethod
     def _getVariation_simple(glyphObj, pdMod, **kwArgs):
         ptCount = glyphObj.pointCount(**kwArgs)
-        from fontio3.gvar import deltas
-        deltaFunc = deltas.Deltas
-        deltaZero = deltaFunc(0, 0)
-        walkPoint = 0
-        
-        for c in glyphObj.contours:
-            pointsFull = set(range(walkPoint, walkPoint + len(c)))
-            basePoint = walkPoint
-            walkPoint += len(c)
-            pointsInContour = {n for n in pointsFull if n in pdMod}
-            
-            if not pointsInContour:
-                for p in pointsFull:
-                    pdMod[p] = deltaZero
-                
-                continue
-            
-            sortedInContour = sorted(pointsInContour)
-            
-            vDeltas = [
-              (list(pdMod[p]) if p in pointsInContour else [0, 0])
-              for p in sorted(pointsFull)]
-            
-            dPrevNext = {}
-            
-            for p in pointsFull - pointsInContour:
-                if p < sortedInContour[0]:
-                    pPrev = sortedInContour[-1]
-                else:
-                    pPrev = max(q for q in pointsInContour if q < p)
-                
-                if p > sortedInContour[-1]:
-                    pNext = sortedInContour[0]
-                else:
-                    pNext = min(q for q in pointsInContour if q > p)
-                
-                dPrevNext[p] = (pPrev, pNext)
-            
-            for xy in (0, 1):
-                for p in pointsFull - pointsInContour:
-                    xyCoord = c[p-basePoint][xy]
-                    pPrev, pNext = dPrevNext[p]
-                    xyPrev = c[pPrev-basePoint][xy]
-                    xyNext = c[pNext-basePoint][xy]
-                    
-                    if xyPrev > xyNext:
-                        xyNext, xyPrev = xyPrev, xyNext
-                        pNext, pPrev = pPrev, pNext
-                    
-                    if xyPrev <= xyCoord <= xyNext:
-                        # it lies between; do interpolation
-                        portion = (xyCoord - xyPrev) / (xyNext - xyPrev)
-                        totalDist = vDeltas[pNext-basePoint][xy] - vDeltas[pPrev-basePoint][xy]
-                        vDeltas[p-basePoint][xy] = vDeltas[pPrev-basePoint][xy] + portion * totalDist
-                    
-                    elif abs(xyPrev-xyCoord) < abs(xyNext-xyCoord):
-                        # it lies outside; shift by xyPrev's shift
-                        vDeltas[p-basePoint][xy] = vDeltas[pPrev-basePoint][xy]
-                    
-                    else:
-                        # it lies outside; shift by xyNext's shift
-                        vDeltas[p-basePoint][xy] = vDeltas[pNext-basePoint][xy]
-            
-            for p in pointsFull:
-                pdMod[p] = deltaFunc(*vDeltas[p-basePoint])
+        xs, ys, onCurve, ends = glyphObj.contours.packedArrays()
+        present = array.array('l', sorted(pdMod))
         
-        ptIndex = 0
+        dxs, dys = fastmathbackend.fmInterpolateUntouched(
+          xs,
+          ys,
+          onCurve,
+          ends,
+          present,
+          array.array('d', (pdMod[p][0] for p in present)),
+          array.array('d', (pdMod[p][1] for p in present)))
         
-        for c in glyphObj.contours:
-            for indexInContour, p in enumerate(c):
-                dlt = pdMod[ptIndex]
-                dlt = [int(round(dlt[0])), int(round(dlt[1]))]
-                c[indexInContour] = p.moved(*dlt)
-                ptIndex += 1
+        glyphObj.contours = glyphObj.contours.frompackedarrays(
+          [x + int(round(dx)) for x, dx in zip(xs, dxs)],
+          [y + int(round(dy)) for y, dy in zip(ys, dys)],
+          onCurve,
+          ends,
+          highBit = glyphObj.contours.highBit)
         
         return glyphObj, _doFinal4(pdMod, ptCount)
 
@@ -424,7 +387,7 @@ class Glyf(object, metaclass=deferreddictmeta.FontDataMetaclass):
             self._validateTightness()
             umk = self.unmadeKeys()
             ceCopy = self.copyCreationExtras()
-            cecLoca = ceCopy.get('loca')
+            cecOffsets = ceCopy.get('locaOffsets')
             cecBase = ceCopy.get('wGlyf')
             walkOffset = 0
             locaObj = loca.Loca(itertools.repeat(None, len(self)))
@@ -435,15 +398,7 @@ class Glyf(object, metaclass=deferreddictmeta.FontDataMetaclass):
                 startOffset = w.byteLength
                 
                 if i in umk:
-                    offset, byteLength = cecLoca[i]
-                    cecBase.reset()
-                    
-                    wRaw = cecBase.subWalker(
-                      offset,
-                      relative = True,
-                      newLimit = byteLength)
-                    
-                    w.addString(wRaw.rest())
+                    w.addString(bytes(cecBase.glyphSlice(cecOffsets, i)))
                 
                 else:
                     self[i].buildBinary(w, scaledOffsets=forApple)
@@ -563,6 +518,67 @@ class Glyf(object, metaclass=deferreddictmeta.FontDataMetaclass):
         
         return workingSet
     
+    def flattenedArrays(self, glyphIndices=None, **kwArgs):
+        """
+        Returns a dict mapping glyph indices to fully decomposed outlines, as
+        (xs, ys, onCurve, contourEnds) tuples in the form that
+        TTContours.packedArrays() produces. Simple glyphs are packed as they
+        are; all the requested composite glyphs are flattened together in a
+        single fastmath backend call, so this is the preferred way to
+        decompose many glyphs at once (for bounds, hdmx, outline export and
+        so on). Composite glyphs whose components cannot be resolved map to
+        None.
+        
+        If glyphIndices is not specified, all the glyphs in self are done.
+        
+        >>> ctv = ttcompositeglyph._testingValues
+        >>> stv = ttsimpleglyph._testingValues
+        >>> g = Glyf({5: ctv[1], 12: ctv[2], 80: stv[2], 100: stv[2]})
+        >>> d = g.flattenedArrays()
+        >>> sorted(d)
+        [5, 12, 80, 100]
+        >>> [len(d[i][0]) for i in (5, 80, 100)]
+        [16, 8, 8]
+        >>> print(d[12])
+        None
+        >>> list(g.flattenedArrays([5])[5][3])
+        [3, 7, 11, 15]
+        """
+        
+        if glyphIndices is None:
+            glyphIndices = list(self)
+        
+        r = {}
+        simples = {}
+        roots = []
+        
+        for glyphIndex in glyphIndices:
+            obj = self.get(glyphIndex)
+            
+            if obj is None:
+                continue
+            
+            if obj.isComposite:
+                roots.append((glyphIndex, obj))
+            
+            else:
+                r[glyphIndex] = simples[glyphIndex] = obj.contours.packedArrays()
+        
+        if roots:
+            simples, composites = ttcompositeglyph.packedSources(
+              self,
+              [obj for glyphIndex, obj in roots],
+              simples = simples)
+            
+            v = fastmathbackend.fmFlattenComposites(
+              simples,
+              composites,
+              [obj.components.packedComponents() for glyphIndex, obj in roots])
+            
+            r.update(zip((glyphIndex for glyphIndex, obj in roots), v))
+        
+        return r
+    
     @classmethod
     def fromvalidatedwalker(cls, w, **kwArgs):
         """
@@ -592,23 +608,49 @@ class Glyf(object, metaclass=deferreddictmeta.FontDataMetaclass):
     @classmethod
     def fromwalker(cls, w, **kwArgs):
         """
+        Returns a new Glyf object from the specified walker. No glyphs are
+        decoded here; each one is sliced out of w with the walker's native
+        glyphSlice() method the first time it is accessed. One of these two
+        keyword arguments is required:
+        
+            locaObj         A Loca object for the glyphs. If this is None, then
+                            None is returned.
+            
+            locaOffsets     An array('L') of the glyphs' byte offsets, as
+                            returned by the walker's unpackLocaOffsets()
+                            method. An Editor passes this when its 'loca'
+                            table hasn't been made yet, so opening a font to
+                            look at a few glyphs never builds a Loca object.
+        
+        >>> obj = ttsimpleglyph._testingValues[2]
+        >>> bs = obj.binaryString()
+        >>> w = walkerbit.StringWalker(bs + bs)
+        >>> offsets = array.array('L', [0, len(bs), 2 * len(bs)])
+        >>> g = Glyf.fromwalker(w, locaOffsets=offsets)
+        >>> len(g), sorted(g.unmadeKeys())
+        (2, [0, 1])
+        >>> g[1] == obj, sorted(g.unmadeKeys())
+        (True, [0])
         """
         
-        locaObj = kwArgs['locaObj']
+        locaOffsets = kwArgs.get('locaOffsets')
         
-        if locaObj is not None:
-            otki = iter(range(len(locaObj)))
+        if locaOffsets is None:
+            locaObj = kwArgs['locaObj']
             
-            ce = dict(
-              oneTimeKeyIterator = otki,
-              loca = locaObj,
-              wGlyf = w,
-              doValidation = kwArgs.get('doValidation', False),
-              logger = kwArgs.get('logger', None))
+            if locaObj is None:
+                return None
             
-            return cls(creationExtras=ce)
+            locaOffsets = locaObj.offsets()
+        
+        ce = dict(
+          oneTimeKeyIterator = iter(range(len(locaOffsets) - 1)),
+          locaOffsets = locaOffsets,
+          wGlyf = w,
+          doValidation = kwArgs.get('doValidation', False),
+          logger = kwArgs.get('logger', None))
         
-        return None
+        return cls(creationExtras=ce)
     
     def getVariation(self, glyphIndex, coords, **kwArgs):
         """
@@ -666,9 +708,200 @@ class Glyf(object, metaclass=deferreddictmeta.FontDataMetaclass):
         if d.isComposite:
             d = ttsimpleglyph.TTSimpleGlyph.fromcompositeglyph(d, **kwArgs)
 
-        pts = (tuple(p) for c in d.contours for p in c)
+        pts = (tuple(p) for p in d.contours.pointIterator())
         return {p:i for i,p in enumerate(pts)}
     
+    def instanced(self, coords, **kwArgs):
+        """
+        Returns a pair (glyfObj, final4s) for the static instance of self at
+        the specified (normalized) coordinates. The new Glyf object has every
+        glyph with 'gvar' data moved to its position at coords, with new
+        bounds and without hints, just as getVariation() does for a single
+        glyph; final4s maps each of those glyph indices to the (deltaX,
+        deltaY) pairs for its 4 phantom points. Composite glyphs without
+        'gvar' data of their own get new bounds if their components moved.
+        
+        As in getVariation(), the outlines are not shifted to keep the origin
+        in place; the first phantom point moves instead, so a glyph's new left
+        sidebearing is its new xMin less the moved origin's x (the origin's
+        old x plus final4s[glyphIndex][0][0]).
+        
+        The scalar for each distinct tuple is only computed once, and the
+        deltas for all the simple glyphs are inferred in a single fastmath
+        backend call, on native threads. The following keyword arguments are
+        supported:
+        
+            editor          The Editor object, used to get the Gvar object.
+                            This is required.
+            
+            threadCount     The number of native threads used for the simple
+                            glyphs. Default is 0, meaning one per CPU.
+        
+        >>> AC = axial_coordinate.AxialCoordinate
+        >>> peak = axial_coordinates.AxialCoordinates(
+        ...   [AC(1.0)],
+        ...   axisOrder = ('wght',))
+        >>> pd = point_dict.PointDict({
+        ...   0: deltas_dict.DeltasDict({peak: deltas.Deltas(-20, -20)}),
+        ...   2: deltas_dict.DeltasDict({peak: deltas.Deltas(40, 40)}),
+        ...   9: deltas_dict.DeltasDict({peak: deltas.Deltas(100, 0)})})
+        >>> pdComp = point_dict.PointDict({
+        ...   1: deltas_dict.DeltasDict({peak: deltas.Deltas(0, 30)})})
+        >>> e = utilities.fakeEditor(200)
+        >>> e.gvar = gvar.Gvar(
+        ...   axisOrder = ('wght',),
+        ...   glyphData = glyph_dict.GlyphDict({5: pdComp, 80: pd}))
+        >>> ctv = ttcompositeglyph._testingValues
+        >>> stv = ttsimpleglyph._testingValues
+        >>> g = Glyf({5: ctv[1], 6: ctv[1], 80: stv[2], 100: stv[2]})
+        >>> g2, final4s = g.instanced((0.5,), editor=e, threadCount=2)
+        >>> sorted(final4s)
+        [5, 80]
+        >>> final4s[80]
+        ((0, 0), (50, 0), (0, 0), (0, 0))
+        >>> [tuple(p) for p in g2[80].contours[0]]
+        [(610, 600), (610, 1110), (1000, 1110), (1000, 600)]
+        >>> print(g2[80].bounds)
+        Minimum X = 610, Minimum Y = 600, Maximum X = 1000, Maximum Y = 1110
+        >>> g2[80].hintBytes, g2[100] is g[100]
+        (b'', True)
+        >>> print(g2[5].components[1].transformationMatrix)
+        Shift Y by -25.0
+        >>> print(g2[6].bounds)
+        Minimum X = 610, Minimum Y = 560, Maximum X = 1525, Maximum Y = 2370
+        >>> g[80].bounds == stv[2].bounds, g[6] is ctv[1]
+        (True, True)
+        
+        The outlines match getVariation()'s, glyph by glyph, even when the
+        origin moves:
+        
+        >>> pd[8] = deltas_dict.DeltasDict({peak: deltas.Deltas(30, 0)})
+        >>> pdComp[2] = deltas_dict.DeltasDict({peak: deltas.Deltas(-24, 0)})
+        >>> e.glyf = g
+        >>> g2, final4s = g.instanced((0.5,), editor=e)
+        >>> final4s[5][0], final4s[80][0]
+        ((-12, 0), (15, 0))
+        >>> e2 = utilities.fakeEditor(200)
+        >>> e2.glyf = g2
+        >>> def points(obj, editor):
+        ...     if obj.isComposite:
+        ...         obj = ttsimpleglyph.TTSimpleGlyph.fromcompositeglyph(
+        ...           obj,
+        ...           editor = editor)
+        ...     return [tuple(p) for p in obj.contours.pointIterator()]
+        >>> for i in (5, 80):
+        ...     obj = g.getVariation(i, (0.5,), editor=e)[0]
+        ...     print(points(obj, e) == points(g2[i], e2))
+        True
+        True
+        """
+        
+        e = kwArgs['editor']
+        r = type(self)()
+        final4s = {}
+        
+        if not e.reallyHas('gvar'):
+            r.update(self.items())
+            return r, final4s
+        
+        gvarObj = e.gvar
+        
+        if len(coords) != len(gvarObj.axisOrder):
+            raise ValueError("Coordinate has unexpected number of axes!")
+        
+        scalarCache = {}
+        composites = []
+        keys = []
+        jobs = []
+        
+        for glyphIndex, obj in self.items():
+            pd = gvarObj.glyphData.get(glyphIndex, None)
+            r[glyphIndex] = obj
+            
+            if obj is None:
+                continue
+            
+            if obj.isComposite:
+                composites.append(glyphIndex)
+            
+            if pd is None:
+                continue
+            
+            tuples = pd.scaledTuples(coords, scalarCache=scalarCache)
+            
+            if not obj.isComposite:
+                keys.append(glyphIndex)
+                jobs.append((obj.contours.packedArrays(), tuples))
+                continue
+            
+            count = len(obj.components)
+            dxs, dys = _sumScaledTuples(tuples, count + 4)
+            newObj = obj.__deepcopy__()
+            newObj.hintBytes = b''
+            
+            for c, dx, dy in zip(newObj.components, dxs, dys):
+                m = c.transformationMatrix
+                
+                # Shifting after the matrix only changes the last row; doing
+                # it directly keeps the offsets integral.
+                if dx or dy:
+                    c.transformationMatrix = type(m)([
+                      list(m[0]),
+                      list(m[1]),
+                      [m[2][0] + dx, m[2][1] + dy, 1]])
+            
+            r[glyphIndex] = newObj
+            final4s[glyphIndex] = tuple(zip(dxs[count:], dys[count:]))
+        
+        it = fastmathbackend.fmInterpolateUntouchedBatch(
+          jobs,
+          kwArgs.get('threadCount', 0))
+        
+        packedMoved = []
+        
+        for glyphIndex, (packed, tuples), (dxs, dys) in zip(keys, jobs, it):
+            xs, ys, onCurve, ends = packed
+            n = len(xs)
+            final4 = tuple((int(round(dx)), int(round(dy))) for dx, dy in zip(dxs[n:], dys[n:]))
+            
+            moved = (
+              array.array('l', (int(x) + int(round(dx)) for x, dx in zip(xs, dxs))),
+              array.array('l', (int(y) + int(round(dy)) for y, dy in zip(ys, dys))),
+              onCurve,
+              ends)
+            
+            packedMoved.append(moved)
+            
+            r[glyphIndex] = ttsimpleglyph.TTSimpleGlyph(
+              contours = self[glyphIndex].contours.frompackedarrays(
+                *moved,
+                highBit = self[glyphIndex].contours.highBit),
+              hintBytes = b'')
+            
+            final4s[glyphIndex] = final4
+        
+        if composites:
+            d = r.flattenedArrays(composites)
+            composites = [i for i in composites if d[i] is not None]
+            keys.extend(composites)
+            packedMoved.extend(d[i] for i in composites)
+        
+        TTB = ttbounds.TTBounds
+        
+        # empty glyphs get None, as TTBounds.fromcontours() gives them
+        for glyphIndex, b in zip(keys, fastmathbackend.fmQuadBoundsBatch(packedMoved)):
+            obj = r[glyphIndex]
+            
+            if obj is self[glyphIndex]:
+                obj = r[glyphIndex] = obj.__copy__()
+            
+            if b is None:
+                obj.bounds = None
+            else:
+                obj.bounds = TTB(*[int(n) for n in b])
+        
+        return r, final4s
+    
     def singleIterator(self, glyphIndex, **kwArgs):
         """
         Returns a generator over tuples. These tuples represent splines or line
@@ -728,6 +961,77 @@ class Glyf(object, metaclass=deferreddictmeta.FontDataMetaclass):
           TTB.unioned,
           (obj.bounds for obj in self.values() if obj),
           TTB(xMin=32767, xMax=-32767, yMin=32767, yMax=-32767))
+    
+    def variationDeltas(self, coords, glyphIndices=None, **kwArgs):
+        """
+        Returns a dict mapping glyph indices to (xDeltas, yDeltas) pairs, each
+        an array('d') with the unrounded deltas for every point (plus the 4
+        phantom points) of a simple glyph at the specified coordinates. All the
+        tuple variations of all the glyphs are interpolated in a single
+        fastmath backend call, so this is the preferred way to get the deltas
+        for many glyphs at once. Composite glyphs, and glyphs with no 'gvar'
+        data, are omitted.
+        
+        If glyphIndices is not specified, all the glyphs with 'gvar' data are
+        done. The 'editor' keyword argument is required; a 'threadCount'
+        keyword argument may be given, as for instanced().
+        
+        >>> AC = axial_coordinate.AxialCoordinate
+        >>> peak = axial_coordinates.AxialCoordinates(
+        ...   [AC(1.0)],
+        ...   axisOrder = ('wght',))
+        >>> pd = point_dict.PointDict({
+        ...   0: deltas_dict.DeltasDict({peak: deltas.Deltas(-20, -20)}),
+        ...   2: deltas_dict.DeltasDict({peak: deltas.Deltas(40, 40)})})
+        >>> e = utilities.fakeEditor(200)
+        >>> e.gvar = gvar.Gvar(
+        ...   axisOrder = ('wght',),
+        ...   glyphData = glyph_dict.GlyphDict({5: pd, 80: pd}))
+        >>> ctv = ttcompositeglyph._testingValues
+        >>> stv = ttsimpleglyph._testingValues
+        >>> g = Glyf({5: ctv[1], 80: stv[2], 100: stv[2]})
+        >>> d = g.variationDeltas((0.5,), editor=e)
+        >>> sorted(d)
+        [80]
+        >>> list(d[80][0])
+        [-10.0, -10.0, 20.0, 20.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0]
+        >>> list(d[80][1])
+        [-10.0, 20.0, 20.0, -10.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0]
+        """
+        
+        e = kwArgs['editor']
+        
+        if not e.reallyHas('gvar'):
+            return {}
+        
+        gvarObj = e.gvar
+        
+        if len(coords) != len(gvarObj.axisOrder):
+            raise ValueError("Coordinate has unexpected number of axes!")
+        
+        if glyphIndices is None:
+            glyphIndices = list(gvarObj.glyphData)
+        
+        scalarCache = {}
+        keys = []
+        jobs = []
+        
+        for glyphIndex in glyphIndices:
+            pd = gvarObj.glyphData.get(glyphIndex, None)
+            obj = (None if pd is None else self.get(glyphIndex))
+            
+            if (obj is None) or obj.isComposite:
+                continue
+            
+            keys.append(glyphIndex)
+            tuples = pd.scaledTuples(coords, scalarCache=scalarCache)
+            jobs.append((obj.contours.packedArrays(), tuples))
+        
+        it = fastmathbackend.fmInterpolateUntouchedBatch(
+          jobs,
+          kwArgs.get('threadCount', 0))
+        
+        return dict(zip(keys, it))
 
 # -----------------------------------------------------------------------------
 
@@ -738,6 +1042,18 @@ class Glyf(object, metaclass=deferreddictmeta.FontDataMetaclass):
 if 0:
     def __________________(): pass
 
+if __debug__:
+    from fontio3 import utilities
+    
+    from fontio3.gvar import (
+      axial_coordinate,
+      axial_coordinates,
+      deltas,
+      deltas_dict,
+      glyph_dict,
+      gvar,
+      point_dict)
+
 def _test():
     import doctest
     doctest.testmod()
@@ -152,6 +152,15 @@ class TTBounds(rectangle.Rectangle):
         
         >>> print(TTBounds.fromcontours([[], [], []]))
         Minimum X = 0, Minimum Y = 0, Maximum X = 0, Maximum Y = 0
+        
+        Compact TTContours objects are measured directly from their arrays:
+        
+        >>> t = ttcontours._testingValues[1].packedArrays()
+        >>> obj = ttcontours.TTContours.frompackedarrays(*t)
+        >>> print(TTBounds.fromcontours(obj))
+        Minimum X = 620, Minimum Y = 610, Maximum X = 980, Maximum Y = 1090
+        >>> obj.isCompact()
+        True
         """
         
         if iterable is None or len(iterable) == 0:
@@ -159,6 +168,15 @@ class TTBounds(rectangle.Rectangle):
         
         mxIt = kwArgs.get('mxIter', None)
         
+        if mxIt is None and getattr(iterable, 'isCompact', bool)():
+            xs, ys = iterable.packedArrays()[0:2]
+            
+            return cls(
+              int(min(xs)),
+              int(min(ys)),
+              int(max(xs)),
+              int(max(ys)))
+        
         if mxIt is not None:
             v = [c.transformed(m) for c, m in zip(iterable, mxIt)]
         else:
@@ -192,7 +192,9 @@ class TTComponent(object, metaclass=simplemeta.FontDataMetaclass):
         mShift, mScale = self.transformationMatrix.toShiftAndScale(
           self.offsetsAreScaled)
         
-        xOffset, yOffset = [mShift[2][0], mShift[2][1]]
+        # Matrix arithmetic leaves the offsets as floats, but they are stored
+        # as integers.
+        xOffset, yOffset = [int(round(mShift[2][0])), int(round(mShift[2][1]))]
         flatMatrix = [mScale[0][0], mScale[0][1], mScale[1][0], mScale[1][1]]
         f = ttcomponentflags.TTComponentFlags()
         
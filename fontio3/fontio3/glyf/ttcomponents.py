@@ -136,6 +136,38 @@ class TTComponents(list, metaclass=seqmeta.FontDataMetaclass):
         ci['hasHints'] = anyHints
         return r
     
+    def packedComponents(self):
+        """
+        Returns a list of tuples, one per component, in the form the fastmath
+        backend's fmFlattenComposites() expects: (glyphIndex, a, b, c, d, dx,
+        dy, compoundAnchor, componentAnchor, roundToGrid). The values a through
+        dy come from the transformation matrix, and the anchors are -1 if the
+        component is placed by offset.
+        
+        >>> for t in _testingValues[1].packedComponents(): print(t)
+        (100, 1.25, 0.75, 0.0, 1.5, 300.0, 0.0, -1, -1, False)
+        (80, 1, 0, 0, 1, 0, -40, -1, -1, True)
+        """
+        
+        v = []
+        
+        for obj in self:
+            m = obj.transformationMatrix
+            
+            if obj.compoundAnchor is None:
+                anchors = (-1, -1)
+            else:
+                anchors = (obj.compoundAnchor, obj.componentAnchor)
+            
+            v.append((
+              obj.glyphIndex,
+              m[0][0], m[0][1], m[1][0], m[1][1], m[2][0], m[2][1],
+              anchors[0],
+              anchors[1],
+              bool(obj.roundToGrid)))
+        
+        return v
+    
     @classmethod
     def fromwalker(cls, w, **kwArgs):
         """
@@ -14,7 +14,7 @@ import itertools
 import logging
 
 # Other imports
-from fontio3 import utilities
+from fontio3 import fastmathbackend, utilities
 from fontio3.fontdata import simplemeta
 from fontio3.fontmath import matrix, rectangle
 
@@ -29,7 +29,7 @@ from fontio3.hints import hints_tt
 from fontio3.SparkHints import hints as sparkhints
 
 try:
-    import intersectionlibbackend
+    from fontio3 import intersectionlibbackend
     useIntLibOK = True
 
 except ImportError:
@@ -56,15 +56,19 @@ def _recalc(obj, **kwArgs):
     origBounds = obj.bounds
     
     try:
-        simples, matrices = zip(*list(obj.pieceIterator(**kwArgs)))
-    except (BadOrCircularComponents, BadEditorOrGlyf):
+        t = obj.flattenedArrays(**kwArgs)
+    except BadEditorOrGlyf:
         return False, obj
     
-    fc = ttcontour.TTContour
+    if t is None:
+        return False, obj
     
-    obj.bounds = ttbounds.TTBounds.fromcontours(
-      [fc(x.pointIterator()) for x in simples],
-      mxIter=matrices)
+    b = fastmathbackend.fmQuadBounds(*t)
+    
+    if b is None:
+        obj.bounds = ttbounds.TTBounds()
+    else:
+        obj.bounds = ttbounds.TTBounds(*[int(n) for n in b])
     
     return origBounds != obj.bounds, obj
 
@@ -232,6 +236,53 @@ def _validate(obj, **kwArgs):
 
 # -----------------------------------------------------------------------------
 
+#
+# Public functions
+#
+
+def packedSources(glyfTable, compositeGlyphs, simples=None):
+    """
+    Returns a pair (simples, composites) of dicts covering every glyph
+    reachable through the components of the specified composite glyphs, in the
+    form the fastmath backend's fmFlattenComposites() call expects. Simple
+    glyphs map to TTContours.packedArrays() tuples, and composite glyphs to
+    TTComponents.packedComponents() lists. Glyphs that are missing from
+    glyfTable are simply left out. If a simples dict is passed in it is used
+    (and added to) rather than starting afresh.
+    
+    >>> s, c = packedSources(_fakeGlyf_3, [_testingValues[2]])
+    >>> sorted(s), sorted(c)
+    ([902, 905], [901, 903, 904])
+    """
+    
+    if simples is None:
+        simples = {}
+    
+    composites = {}
+    stack = [c.glyphIndex for g in compositeGlyphs for c in g.components]
+    
+    while stack:
+        glyphIndex = stack.pop()
+        
+        if (glyphIndex in simples) or (glyphIndex in composites):
+            continue
+        
+        obj = glyfTable.get(glyphIndex)
+        
+        if obj is None:
+            continue
+        
+        if obj.isComposite:
+            composites[glyphIndex] = obj.components.packedComponents()
+            stack.extend(c.glyphIndex for c in obj.components)
+        
+        else:
+            simples[glyphIndex] = obj.contours.packedArrays()
+    
+    return simples, composites
+
+# -----------------------------------------------------------------------------
+
 #
 # Classes
 #
@@ -427,6 +478,65 @@ class TTCompositeGlyph(object, metaclass=simplemeta.FontDataMetaclass):
         
         w.alignToByteMultiple(2)
     
+    def flattenedArrays(self, **kwArgs):
+        """
+        Returns the fully decomposed outline of the glyph as a tuple (xs, ys,
+        onCurve, contourEnds), in the same form TTContours.packedArrays()
+        uses, with coordinates rounded to integers. Nested components are
+        resolved, and components positioned via anchor points are placed by
+        matching those points. Returns None if the components cannot be
+        resolved (missing glyphs, circular references or bad anchor indices).
+        
+        The editor keyword argument is required. This call may raise a
+        BadEditorOrGlyf exception.
+        
+        >>> xs, ys, onCurve, ends = _testingValues[1].flattenedArrays(
+        ...   editor=_fakeEditor_5)
+        >>> list(xs[:4]), list(ys[:4])
+        ([1075.0, 1075.0, 1525.0, 1525.0], [1380.0, 2100.0, 2370.0, 1650.0])
+        >>> list(xs[8:12]), list(ys[8:12])
+        ([620.0, 620.0, 980.0, 980.0], [570.0, 1050.0, 1050.0, 570.0])
+        >>> list(ends)
+        [3, 7, 11, 15]
+        
+        >>> print(_testingValues[2].flattenedArrays(editor=_fakeEditor_2))
+        None
+        
+        >>> print(_testingValues[2].flattenedArrays(editor=_fakeEditor_4))
+        None
+        
+        Compound anchor indices count from the composite's own first point,
+        even when the composite is itself a component. Here glyph 7 places a
+        second copy of glyph 80 so its point 0 sits on its first copy's point
+        2, at (980, 1090), and glyph 7 follows a shifted copy of glyph 80:
+        
+        >>> xs, ys, onCurve, ends = _testingValues[6].flattenedArrays(
+        ...   editor=_fakeEditor_6)
+        >>> list(xs[:3]), list(ys[:3])
+        ([1620.0, 1620.0, 1980.0], [610.0, 1090.0, 1090.0])
+        >>> list(xs[8:11]), list(ys[8:11])
+        ([620.0, 620.0, 980.0], [610.0, 1090.0, 1090.0])
+        >>> xs[16], ys[16]
+        (980.0, 1090.0)
+        """
+        
+        editor = kwArgs.get('editor')
+        
+        if not editor:
+            raise BadEditorOrGlyf()
+        
+        g = editor.get(b'glyf')
+        
+        if not g:
+            raise BadEditorOrGlyf()
+        
+        simples, composites = packedSources(g, [self])
+        
+        return fastmathbackend.fmFlattenComposites(
+          simples,
+          composites,
+          [self.components.packedComponents()])[0]
+    
     @classmethod
     def fromvalidatedwalker(cls, w, **kwArgs):
         """
@@ -688,7 +798,14 @@ if __debug__:
         TTCompositeGlyph(components=_cstv[2]),  # glyph 901
         TTCompositeGlyph(components=_cstv[3]),  # glyphs 902, 903
         TTCompositeGlyph(components=_cstv[4]),  # glyph 904
-        TTCompositeGlyph(components=_cstv[5]))  # glyph 905
+        TTCompositeGlyph(components=_cstv[5]),  # glyph 905
+        
+        TTCompositeGlyph(  # glyphs 80 and 7
+          components = ttcomponents.TTComponents([
+            ttcomponent.TTComponent(
+              glyphIndex = 80,
+              transformationMatrix = matrix.Matrix.forShift(1000, 0)),
+            ttcomponent.TTComponent(glyphIndex=7)])))
     
     class _FakeEditor:
         def __init__(self, g): self.glyf = g
@@ -726,6 +843,26 @@ if __debug__:
     
     _fakeEditor_4 = _FakeEditor(_fakeGlyf_4)
     
+    _fakeGlyf_5 = {  # like _fakeGlyf_1, but the components have contours
+      5: _testingValues[1],
+      80: _stv[2],
+      100: _stv[2]}
+    
+    _fakeEditor_5 = _FakeEditor(_fakeGlyf_5)
+    
+    _fakeGlyf_6 = {  # glyph 7 is a composite positioned by anchors
+      7: TTCompositeGlyph(
+        components = ttcomponents.TTComponents([
+          ttcomponent.TTComponent(glyphIndex=80),
+          ttcomponent.TTComponent(
+            glyphIndex = 80,
+            compoundAnchor = 2,
+            componentAnchor = 0)])),
+      
+      80: _stv[2]}
+    
+    _fakeEditor_6 = _FakeEditor(_fakeGlyf_6)
+    
     del _cstv, _stv, _FakeEditor
 
 def _test():
@@ -534,6 +534,52 @@ class TTContour(list, metaclass=seqmeta.FontDataMetaclass):
         Point 3: (400, 30), on-curve
         >>> _testingValues[0].intersects(shifted)
         True
+        
+        The native intersectionlibbackend, which validation uses when it is
+        available, gives the same answers for crossings and touches. Pieces
+        touching only where an end of one meets an end of the other do not
+        cross; any other contact does, including the end of one piece resting
+        on the inside of another, and overlapping collinear lines:
+        
+        >>> sq = _square(0, 0, 100)
+        >>> cases = [
+        ...   _square(50, 50, 100),                           # crossing
+        ...   _square(25, 25, 50),                            # inside
+        ...   _square(100, 0, 100),                           # shared edge
+        ...   _square(100, 50, 100),                          # part of an edge
+        ...   _polygon((100, 50), (150, 100), (150, 0)),      # tip on an edge
+        ...   _polygon((100, 50), (50, 75), (50, 25)),        # tip inside
+        ...   _polygon((100, 0), (150, 50), (200, 0), (150, -50)),  # corners
+        ...   _circle(150, 50, 80),                           # curve crossing
+        ...   _circle(200, 50, 100),                          # curve tangent
+        ...   _circle(50, 50, 20)]                            # curve inside
+        >>> [sq.intersects(c) for c in cases]
+        [True, False, True, True, True, True, False, True, True, False]
+        >>> [_nativeIntersects(sq, c) for c in cases]
+        [True, False, True, True, True, True, False, True, True, False]
+        
+        The one place they differ is collinear lines that meet end to end.
+        The native code never counts these, while this method counts them
+        or not depending on the lines' directions:
+        
+        >>> corner = _square(100, 100, 100)
+        >>> sq.intersects(corner), _nativeIntersects(sq, corner)
+        (True, False)
+        >>> corner = _polygon((100, 100), (200, 100), (200, 200))
+        >>> sq.intersects(corner), _nativeIntersects(sq, corner)
+        (False, False)
+        
+        VerifyQuadOutline() also lists the pairs of contours that cross, and
+        the contours that cross themselves if includeSelf is True:
+        
+        >>> bowTie = _polygon((900, 0), (1000, 100), (1000, 0), (900, 100))
+        >>> v = [sq, _square(50, 50, 100), _square(500, 0, 10), bowTie]
+        >>> _nativeVerify(v)
+        (True, [(0, 1)])
+        >>> _nativeVerify(v, includeSelf=True)
+        (True, [(0, 1), (3, 3)])
+        >>> _nativeVerify(v[2:3], includeSelf=True)
+        (False, [])
         """
         
         splineGroup1 = list(self.splineIterator())
@@ -873,6 +919,39 @@ if __debug__:
     from fontio3.glyf import ttpoint
     from fontio3.fontmath import matrix
     
+    def _circle(x, y, r):
+        P = ttpoint.TTPoint
+        
+        return TTContour([
+          P(x, y - r),
+          P(x - r, y - r, onCurve=False),
+          P(x - r, y),
+          P(x - r, y + r, onCurve=False),
+          P(x, y + r),
+          P(x + r, y + r, onCurve=False),
+          P(x + r, y),
+          P(x + r, y - r, onCurve=False)])
+    
+    def _nativeIntersects(c1, c2):
+        return _nativeVerify([c1, c2])[0]
+    
+    def _nativeVerify(contours, includeSelf=False):
+        # Imported here so that loading this module (where __debug__ is
+        # almost always true) doesn't load the native library as well.
+        from fontio3 import intersectionlibbackend
+        
+        cv = [
+          tuple((float(p.x), float(p.y), (not p.onCurve)) for p in c)
+          for c in contours]
+        
+        return intersectionlibbackend.VerifyQuadOutline(cv, includeSelf)
+    
+    def _polygon(*t):
+        return TTContour([ttpoint.TTPoint(x, y) for x, y in t])
+    
+    def _square(x, y, size):
+        return _polygon((x, y), (x, y + size), (x + size, y + size), (x + size, y))
+    
     pv = ttpoint._testingValues
     
     _testingValues = (
@@ -9,15 +9,15 @@ Support for sequences of TrueType contours (both full and stroke).
 """
 
 # System imports
+import array
 import itertools
 import logging
 import operator
 
 # Other imports
-from fontio3 import utilities
+from fontio3 import utilities, utilitiesbackend
 from fontio3.fontdata import seqmeta
 from fontio3.glyf import ttcontour, ttpoint
-from fontio3.utilities import writer
 
 try:
     import intersectionlib
@@ -25,6 +25,12 @@ try:
 except ImportError:
     useIntLibOK = False
 
+try:
+    from fontio3 import intersectionlibbackend
+    useIntLibBackendOK = True
+except ImportError:
+    useIntLibBackendOK = False
+
 # -----------------------------------------------------------------------------
 
 #
@@ -86,6 +92,13 @@ def _validate(obj, **kwArgs):
               (),
               "Not all extrema are marked with on-curve points."))
 
+    elif useIntLibBackendOK:
+        cv = [
+          tuple((float(p.x), float(p.y), (not p.onCurve)) for p in c)
+          for c in obj]
+        
+        hasIntersections = intersectionlibbackend.VerifyQuadOutline(cv)[0]
+    
     else:
         for c1, c2 in itertools.combinations(obj, 2):
             if c1.intersects(c2):
@@ -107,6 +120,24 @@ def _validate(obj, **kwArgs):
     
     return isOK
 
+def _makeExpandingMethod(name):
+    """
+    Returns a wrapper for the list method with the specified name that first
+    expands a compact TTContours object into real TTContour objects.
+    """
+    
+    listMethod = getattr(list, name)
+    
+    def f(self, *args, **kwArgs):
+        if self._packed is not None:
+            self._expand()
+        
+        return listMethod(self, *args, **kwArgs)
+    
+    f.__name__ = name
+    f.__doc__ = listMethod.__doc__
+    return f
+
 # -----------------------------------------------------------------------------
 
 #
@@ -136,6 +167,26 @@ class TTContours(list, metaclass=seqmeta.FontDataMetaclass):
       Point 1: (850, 700), off-curve
       Point 2: (950, 750), on-curve
       Point 3: (850, 1000), on-curve
+    
+    Objects made via frompackedarrays() (which is how glyphs are read from a
+    binary 'glyf' table) are compact: the x, y and onCurve values are kept in
+    typed arrays, and the TTContour and TTPoint objects are only made the
+    first time the contents are actually accessed as a list. The binary
+    output, packedArrays(), pointIterator(), pointCount() and endPoints()
+    methods, as well as comparisons between two compact objects, all work
+    directly from the arrays.
+    
+    >>> obj = TTContours.frompackedarrays(*_testingValues[1].packedArrays())
+    >>> obj.isCompact(), len(obj), obj.pointCount(), obj.endPoints()
+    (True, 2, 8, [3, 7])
+    >>> obj.binaryString() == _testingValues[1].binaryString()
+    True
+    >>> obj.isCompact()
+    True
+    >>> print(obj[1][1])
+    (850, 700), off-curve
+    >>> obj.isCompact(), obj == _testingValues[1]
+    (False, True)
     """
     
     #
@@ -156,44 +207,133 @@ class TTContours(list, metaclass=seqmeta.FontDataMetaclass):
             attr_label = "High bit",
             attr_showonlyiftrue = True))
     
+    _packed = None  # (xs, ys, onCurve, contourEnds) while compact
+    
     #
-    # Methods
+    # Special methods
     #
     
-    @staticmethod
-    def _combineRepeats(v):
+    def __copy__(self):
+        """
+        Returns a shallow copy of self. A compact object's copy is also
+        compact; the arrays are shared, since they are never changed in place.
+        
+        >>> t = _testingValues[1].packedArrays()
+        >>> obj = TTContours.frompackedarrays(*t)
+        >>> obj2 = obj.__copy__()
+        >>> obj2 == obj, obj2 is obj, obj2.isCompact()
+        (True, False, True)
         """
-        Takes a vector of one-byte strings (flags) and coalesces repeats.
+        
+        if self._packed is not None:
+            return self._compactCopy()
+        
+        return seqmeta.SM_copy(self)
     
-        Note that this method does its work in-place within the specified
-        vector.
+    def __deepcopy__(self, memo=None):
+        """
+        Returns a deep copy of self. As with __copy__(), a compact object's
+        copy is also compact.
         
-        >>> v = [0x11, 0x11, 0x11, 0x01, 0x11]
-        >>> TTContours._combineRepeats(v)
-        >>> v
-        [25, 2, 1, 17]
+        >>> import copy
+        >>> t = _testingValues[1].packedArrays()
+        >>> obj = copy.deepcopy(TTContours.frompackedarrays(*t))
+        >>> obj == _testingValues[1]
+        True
         """
         
-        prevValue = v[0]
-        i = 1
+        if self._packed is not None:
+            return self._compactCopy()
         
-        while i < len(v):
-            if v[i] == prevValue:
-                v[i-1] |= 0x08
-                j = i + 1
-                
-                while j < len(v):
-                    if v[j] != v[i]:
-                        break
-                    j += 1
-                
-                v[i] = j - i    # number of additional repeats
-                v[i+1:j] = []
-            
-            else:
-                prevValue = v[i]
+        return seqmeta.SM_deepcopy(self, memo)
+    
+    def __eq__(self, other):
+        """
+        Returns True if self and other are equal. If both are compact, only
+        the arrays are compared.
+        
+        >>> t = _testingValues[2].packedArrays()
+        >>> obj1 = TTContours.frompackedarrays(*t)
+        >>> obj2 = TTContours.frompackedarrays(*t)
+        >>> obj1 == obj2, obj1.isCompact(), obj2.isCompact()
+        (True, True, True)
+        >>> obj1 == _testingValues[1]
+        False
+        """
+        
+        if self._packed is not None and getattr(other, '_packed', None) is not None:
+            return self._packed == other._packed
+        
+        return seqmeta.SM_eq(self, other)
+    
+    def __len__(self):
+        """
+        Returns the number of contours, without expanding a compact object.
+        
+        >>> len(TTContours.frompackedarrays(*_testingValues[2].packedArrays()))
+        3
+        """
+        
+        if self._packed is not None:
+            return len(self._packed[3])
+        
+        return list.__len__(self)
+    
+    def __ne__(self, other):
+        """
+        Returns True if self and other are not equal.
+        
+        >>> t = _testingValues[1].packedArrays()
+        >>> TTContours.frompackedarrays(*t) != _testingValues[1]
+        False
+        """
+        
+        return not (self == other)
+    
+    #
+    # Private methods
+    #
+    
+    def _compactCopy(self):
+        """
+        Returns a new compact object sharing self's arrays.
+        
+        >>> t = _testingValues[0].packedArrays()
+        >>> TTContours.frompackedarrays(*t)._compactCopy().isCompact()
+        True
+        """
+        
+        r = type(self)(highBit=self.highBit)
+        r._packed = self._packed
+        return r
+    
+    def _expand(self):
+        """
+        Converts a compact object into an ordinary list of TTContour objects.
+        This is done automatically the first time the object is used as a
+        list.
+        
+        >>> obj = TTContours.frompackedarrays(*_testingValues[0].packedArrays())
+        >>> obj._expand()
+        >>> obj.isCompact(), list.__len__(obj), obj[0][0]
+        (False, 1, TTPoint(x=20, y=10))
+        """
+        
+        xs, ys, onCurve, ends = self._packed
+        self._packed = None
+        f = ttpoint.TTPoint
+        v = []
+        startPoint = 0
+        
+        for endPoint in ends:
+            v.append(
+              ttcontour.TTContour(
+                f((xs[i], ys[i]), onCurve=bool(onCurve[i]))
+                for i in range(startPoint, endPoint + 1)))
             
-            i += 1
+            startPoint = endPoint + 1
+        
+        list.extend(self, v)
     
     def _makeIndexList(self):
         """
@@ -466,11 +606,21 @@ class TTContours(list, metaclass=seqmeta.FontDataMetaclass):
             raise ValueError(
               "One or more contours deleted by point renumbering!")
     
+    #
+    # Public methods
+    #
+    
     def buildBinary(self, w, **kwArgs):
         """
         Adds the binary data to the specified LinkedWriter. Note that this is
         the flags, xCoordinates, and yCoordinates portions of a simple glyph.
         
+        The encoding is done natively, and picks the short, long or same-as-
+        previous form of each coordinate so that the flags (with their REPEAT
+        runs) and coordinates take the fewest bytes overall. If the keyword
+        argument overlapSimple is True, the OVERLAP_SIMPLE bit (0x40) is set in
+        the first flag.
+        
         >>> utilities.hexdump(_testingValues[0].binaryString())
                0 | 3711 2111 1401 680A  01E0 FE20           |7.!...h....     |
         
@@ -482,66 +632,81 @@ class TTContours(list, metaclass=seqmeta.FontDataMetaclass):
                0 | 3711 2111 1311 2111  2716 3727 1401 68F0 |7.!...!.'.7'..h.|
               10 | 0168 E664 6464 0A01  E0FE 2002 5801 E0FE |.h.ddd.... .X...|
               20 | 208C 3232 FA                             | .22.           |
+        
+        Here writing every point with long coordinates lets all four flags
+        share one REPEAT run, which is a byte smaller than the greedy choice:
+        
+        >>> P = ttpoint.TTPoint
+        >>> c = ttcontour.TTContour(
+        ...   [P((300, 300)), P((10, 10)), P((300, 0)), P((0, 300))])
+        >>> utilities.hexdump(TTContours([c]).binaryString())
+               0 | 0903 012C FEDE 0122  FED4 012C FEDE FFF6 |...,...\"...,....|
+              10 | 012C                                     |.,              |
+        
+        >>> utilities.hexdump(TTContours([c]).binaryString(overlapSimple=True))
+               0 | 4101 0501 012C FEDE  0122 FED4 012C FEDE |A....,...\"...,..|
+              10 | 0A01 2C                                  |..,             |
         """
         
-        numPoints = sum(len(c) for c in self)
-        vFlags = [0] * numPoints
-        xw = writer.LinkedWriter()
-        yw = writer.LinkedWriter()
-        lastX = 0
-        lastY = 0
+        if self._packed is not None:
+            xs, ys, onCurve = self._packed[0:3]
         
-        for i, p in enumerate(self.pointIterator()):
-            f = (1 if p.onCurve else 0)
-            
-            if self.highBit:
-                f += 0x80
-            
-            deltaX = p.x - lastX
-            deltaY = p.y - lastY
-            
-            if deltaX:
-                a = abs(deltaX)
-                
-                if a < 256:
-                    f += 0x02
-                    
-                    if deltaX >= 0:
-                        f += 0x10
-                    
-                    xw.add("B", a)
-                
-                else:
-                    xw.add("h", deltaX)
-            
-            else:
-                f += 0x10
-            
-            if deltaY:
-                a = abs(deltaY)
-                
-                if a < 256:
-                    f += 0x04
-                    
-                    if deltaY >= 0:
-                        f += 0x20
-                    
-                    yw.add("B", a)
-                
-                else:
-                    yw.add("h", deltaY)
-            
-            else:
-                f += 0x20
-            
-            lastX = p.x
-            lastY = p.y
-            vFlags[i] = f
+        else:
+            xs = array.array('l', (p.x for p in self.pointIterator()))
+            ys = array.array('l', (p.y for p in self.pointIterator()))
+            onCurve = bytes(bool(p.onCurve) for p in self.pointIterator())
+        
+        w.addString(
+          utilitiesbackend.utEncodeSimpleGlyph(
+            xs,
+            ys,
+            onCurve,
+            (0x80 if self.highBit else 0),
+            kwArgs.get('overlapSimple', False)))
+    
+    def compacted(self, **kwArgs):
+        """
+        Returns a new object with empty contours removed. A compact object
+        with no empty contours is simply copied, still compact.
+        
+        >>> obj = TTContours.frompackedarrays(*_testingValues[1].packedArrays())
+        >>> obj2 = obj.compacted()
+        >>> obj2 == obj, obj2 is obj, obj2.isCompact()
+        (True, False, True)
+        
+        >>> c = ttcontour._testingValues
+        >>> len(TTContours([c[0], ttcontour.TTContour(), c[2]]).compacted())
+        2
+        
+        A repeated end in a compact object is an empty contour:
+        
+        >>> xs, ys, onCurve, ends = _testingValues[1].packedArrays()
+        >>> obj = TTContours.frompackedarrays(xs, ys, onCurve, [3, 3, 7])
+        >>> obj2 = obj.compacted()
+        >>> len(obj), len(obj2), obj2 == _testingValues[1]
+        (3, 2, True)
+        """
+        
+        ends = (self._packed[3] if self._packed is not None else None)
+        
+        if ends is not None and all(a < b for a, b in zip(ends, ends[1:])):
+            return self._compactCopy()
         
-        self._combineRepeats(vFlags)  # works in-place
-        w.addGroup("B", vFlags)
-        w.addString(xw.binaryString())
-        w.addString(yw.binaryString())
+        return seqmeta.M_compacted(self, **kwArgs)
+    
+    def endPoints(self):
+        """
+        Returns a list with the index of the last point in each contour, as in
+        the endPtsOfContours array of a simple glyph.
+        
+        >>> _testingValues[2].endPoints()
+        [3, 7, 11]
+        """
+        
+        if self._packed is not None:
+            return list(self._packed[3])
+        
+        return [n - 1 for n in itertools.accumulate(len(c) for c in self)]
     
     @classmethod
     def fromcontourgroups(cls, cgObjs, **kwArgs):
@@ -705,6 +870,175 @@ class TTContours(list, metaclass=seqmeta.FontDataMetaclass):
         
         return cls(v, highBit=highBit)
     
+    @classmethod
+    def frompackedarrays(cls, xs, ys, onCurve, contourEnds, **kwArgs):
+        """
+        Creates and returns a new compact TTContours object from packed
+        arrays, the inverse of packedArrays(). Integer arrays are kept as they
+        are (so the caller should not change them afterwards); other sequences
+        of coordinates are converted to int.
+        
+        >>> t = _testingValues[1].packedArrays()
+        >>> obj = TTContours.frompackedarrays(*t)
+        >>> obj == _testingValues[1], obj.isCompact()
+        (True, False)
+        """
+        
+        if getattr(xs, 'typecode', None) not in {'h', 'i', 'l'}:
+            xs = array.array('l', map(int, xs))
+        
+        if getattr(ys, 'typecode', None) not in {'h', 'i', 'l'}:
+            ys = array.array('l', map(int, ys))
+        
+        if not isinstance(onCurve, bytes):
+            onCurve = bytes(bool(b) for b in onCurve)
+        
+        r = cls(**utilities.filterKWArgs(cls, kwArgs))
+        r._packed = (xs, ys, onCurve, array.array('H', contourEnds))
+        return r
+    
+    def isCompact(self):
+        """
+        Returns True if self is still held as packed arrays, i.e. it has not
+        yet been expanded into TTContour and TTPoint objects.
+        
+        >>> _testingValues[1].isCompact()
+        False
+        >>> t = _testingValues[1].packedArrays()
+        >>> TTContours.frompackedarrays(*t).isCompact()
+        True
+        """
+        
+        return self._packed is not None
+    
+    def lrSegments(self, packed=False):
+        """
+        Returns a list with the segments of self in the form the fastmath
+        backend's fmFindLRExtrema() call takes: (1, on1X, on1Y, offX, offY,
+        on2X, on2Y) for a curve, and (0, on1X, on1Y, on2X, on2Y) for a line.
+        If packed is True, an array('d') with 7 values per segment (the curve
+        form, with the off-curve pair unused for lines) is returned instead,
+        as fmFindLRExtremaBatch() takes.
+        
+        >>> v = _testingValues[1].lrSegments()
+        >>> v[3], v[4]
+        ((0, 980, 610, 620, 610), (1, 750, 750, 850, 700, 950, 750))
+        
+        The asArrays form of fmFindLRExtrema() has the same rows as the
+        dictionary form, with NaN for the rows the dictionary skips:
+        
+        >>> for obj in _testingValues:
+        ...     d = fastmathbackend.fmFindLRExtrema(obj.lrSegments())
+        ...     yMin, lefts, rights = fastmathbackend.fmFindLRExtrema(
+        ...       obj.lrSegments(),
+        ...       True)
+        ...     d2 = {
+        ...       int(yMin) + i: (x1, x2)
+        ...       for i, (x1, x2) in enumerate(zip(lefts, rights))
+        ...       if x1 == x1}
+        ...     print(len(d), d == d2)
+        481 True
+        481 True
+        962 True
+        
+        fmFindLRExtremaBatch() gives the same results for the packed form,
+        however many threads it uses (the arrays are compared as bytes, since
+        NaN never compares equal):
+        
+        >>> def asBytes(v): return [(t[0], t[1].tobytes(), t[2].tobytes()) for t in v]
+        >>> single = asBytes(
+        ...   fastmathbackend.fmFindLRExtrema(obj.lrSegments(), True)
+        ...   for obj in _testingValues)
+        >>> bufs = [obj.lrSegments(packed=True) for obj in _testingValues]
+        >>> len(bufs[1]), bufs[1][21:28].tolist()
+        (49, [0.0, 980.0, 610.0, 0.0, 0.0, 620.0, 610.0])
+        >>> for n in (1, 2, 0):
+        ...     print(asBytes(fastmathbackend.fmFindLRExtremaBatch(bufs, n)) == single)
+        True
+        True
+        True
+        """
+        
+        r = []
+        
+        for c in self:
+            for b in c.splineIterator():
+                p1, p2 = b.onCurve1, b.onCurve2
+                
+                if b.offCurve is None:
+                    if packed:
+                        r.extend((0, p1.x, p1.y, 0, 0, p2.x, p2.y))
+                    else:
+                        r.append((0, p1.x, p1.y, p2.x, p2.y))
+                
+                else:
+                    t = (1, p1.x, p1.y, b.offCurve.x, b.offCurve.y, p2.x, p2.y)
+                    
+                    if packed:
+                        r.extend(t)
+                    else:
+                        r.append(t)
+        
+        return (array.array('d', r) if packed else r)
+    
+    def packedArrays(self):
+        """
+        Returns a tuple (xs, ys, onCurve, contourEnds) with the points of self
+        packed into arrays, as the fastmath backend expects them: xs and ys are
+        array('d'), onCurve is a bytes object with 1 for on-curve points, and
+        contourEnds is an array('i') of inclusive last-point indices.
+        
+        >>> xs, ys, onCurve, ends = _testingValues[1].packedArrays()
+        >>> list(xs)
+        [620.0, 620.0, 980.0, 980.0, 750.0, 850.0, 950.0, 850.0]
+        >>> list(ys)
+        [610.0, 1090.0, 1090.0, 610.0, 750.0, 700.0, 750.0, 1000.0]
+        >>> list(onCurve), list(ends)
+        ([1, 1, 1, 1, 1, 0, 1, 1], [3, 7])
+        
+        The fastmath calls raise ValueError for contour ends that are
+        negative, out of order, or past the last point:
+        
+        >>> dxs = array.array('d', [0.0] * 8)
+        >>> for badEnds in ([-100000000, 7], [5, 3], [3, 8]):
+        ...     badEnds = array.array('l', badEnds)
+        ...     for f, extra in (
+        ...       (fastmathbackend.fmQuadBounds, ()),
+        ...       (fastmathbackend.fmOptimizeIUP, (dxs, dxs, 0.5)),
+        ...       (fastmathbackend.fmInterpolateUntouched, (
+        ...         array.array('l', [0]),
+        ...         array.array('d', [5.0]),
+        ...         array.array('d', [5.0])))):
+        ...         try:
+        ...             f(xs, ys, onCurve, badEnds, *extra)
+        ...         except ValueError as e:
+        ...             print(e)
+        Contour end indices are out of order or out of range!
+        Contour end indices are out of order or out of range!
+        Contour end indices are out of order or out of range!
+        Contour end indices are out of order or out of range!
+        Contour end indices are out of order or out of range!
+        Contour end indices are out of order or out of range!
+        Contour end indices are out of order or out of range!
+        Contour end indices are out of order or out of range!
+        Contour end indices are out of order or out of range!
+        """
+        
+        if self._packed is not None:
+            xs, ys, onCurve, ends = self._packed
+            
+            return (
+              array.array('d', xs),
+              array.array('d', ys),
+              onCurve,
+              array.array('i', ends))
+        
+        xs = array.array('d', (p.x for p in self.pointIterator()))
+        ys = array.array('d', (p.y for p in self.pointIterator()))
+        onCurve = bytes(bool(p.onCurve) for p in self.pointIterator())
+        ends = array.array('i', self.endPoints())
+        return xs, ys, onCurve, ends
+    
     def pointIterator(self):
         """
         Returns an iterator which yields individual TTPoint objects, without
@@ -715,11 +1049,39 @@ class TTContours(list, metaclass=seqmeta.FontDataMetaclass):
         20
         380
         380
+        
+        For a compact object the points are made on the fly, and the object
+        stays compact:
+        
+        >>> obj = TTContours.frompackedarrays(*_testingValues[0].packedArrays())
+        >>> [p.y for p in obj.pointIterator()], obj.isCompact()
+        ([10, 490, 490, 10], True)
         """
         
-        for c in self:
-            for p in c:
-                yield p
+        if self._packed is not None:
+            xs, ys, onCurve = self._packed[0:3]
+            f = ttpoint.TTPoint
+            
+            for i in range(len(xs)):
+                yield f((xs[i], ys[i]), onCurve=bool(onCurve[i]))
+        
+        else:
+            for c in self:
+                for p in c:
+                    yield p
+    
+    def pointCount(self):
+        """
+        Returns the total number of points in all the contours.
+        
+        >>> _testingValues[2].pointCount()
+        12
+        """
+        
+        if self._packed is not None:
+            return len(self._packed[0])
+        
+        return sum(len(c) for c in self)
     
     def pointsRenumbered(self, mapData, **kwArgs):
         """
@@ -790,6 +1152,18 @@ class TTContours(list, metaclass=seqmeta.FontDataMetaclass):
         
         return TTContours(r)
 
+for _name in (
+  '__add__', '__contains__', '__delitem__', '__ge__', '__getitem__',
+  '__gt__', '__iadd__', '__imul__', '__iter__', '__le__', '__lt__',
+  '__mul__', '__reversed__', '__rmul__', '__setitem__', 'append', 'clear',
+  'copy', 'count', 'extend', 'index', 'insert', 'pop', 'remove', 'reverse',
+  'sort'):
+
+    if getattr(TTContours, _name) is getattr(list, _name):
+        setattr(TTContours, _name, _makeExpandingMethod(_name))
+
+del _name
+
 # -----------------------------------------------------------------------------
 
 #
@@ -800,6 +1174,8 @@ if 0:
     def __________________(): pass
 
 if __debug__:
+    from fontio3 import fastmathbackend
+    
     def _makeCGTest():
         from fontio3.glyf import ttcontourgroups
         
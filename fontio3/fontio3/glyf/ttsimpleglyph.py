@@ -154,7 +154,8 @@ class TTSimpleGlyph(object, metaclass=simplemeta.FontDataMetaclass):
     def buildBinary(self, w, **kwArgs):
         """
         Adds the binary data for the TTSimpleGlyph object to the specified
-        LinkedWriter.
+        LinkedWriter. If the keyword argument overlapSimple is True, the
+        OVERLAP_SIMPLE bit is set in the glyph's first flag.
         
         >>> utilities.hexdump(_testingValues[1].binaryString())
                0 | 0000 0000 0000 0000  0000 0002 0001      |..............  |
@@ -163,6 +164,11 @@ class TTSimpleGlyph(object, metaclass=simplemeta.FontDataMetaclass):
                0 | 0002 026C 0262 03D4  0442 0003 0007 0002 |...l.b...B......|
               10 | 0001 0111 2111 2716  3727 026C 0168 E664 |....!.'.7'.l.h.d|
               20 | 6464 0262 01E0 FE20  8C32 32FA           |dd.b... .22.    |
+        
+        >>> utilities.hexdump(_testingValues[2].binaryString(overlapSimple=True))
+               0 | 0002 026C 0262 03D4  0442 0003 0007 0002 |...l.b...B......|
+              10 | 0001 4111 2111 2716  3727 026C 0168 E664 |..A.!.'.7'.l.h.d|
+              20 | 6464 0262 01E0 FE20  8C32 32FA           |dd.b... .22.    |
         """
         
         if 'stakeValue' in kwArgs:
@@ -171,6 +177,7 @@ class TTSimpleGlyph(object, metaclass=simplemeta.FontDataMetaclass):
         else:
             stakeValue = w.stakeCurrent()
         
+        overlapSimple = kwArgs.pop('overlapSimple', False)
         self.contours = self.contours.compacted()
         
         if self.contours or self.hintBytes:
@@ -182,14 +189,16 @@ class TTSimpleGlyph(object, metaclass=simplemeta.FontDataMetaclass):
                 w.add("HHHH", 0, 0, 0, 0)  # *must* have data for 'bounds'
             
             if self.contours:
-                it = map(len, iter(self.contours))
-                w.addGroup("H", utilities.cumulCount(it, wantEndIndices=True))
+                w.addGroup("H", self.contours.endPoints())
             
             w.add("H", len(self.hintBytes))
             w.addString(self.hintBytes)
             
             if self.contours:
-                self.contours.buildBinary(w, **kwArgs)
+                self.contours.buildBinary(
+                  w,
+                  overlapSimple = overlapSimple,
+                  **kwArgs)
             
             w.alignToByteMultiple(2)
     
@@ -201,18 +210,18 @@ class TTSimpleGlyph(object, metaclass=simplemeta.FontDataMetaclass):
         """
         
         try:
-            v = list(compositeGlyph.pieceIterator(**kwArgs))
+            t = compositeGlyph.flattenedArrays(**kwArgs)
         except:
-            v = None
+            t = None
         
-        if v is None:
+        if t is None:
             return cls()
         
-        vx = [c.transformed(m) for obj, m in v for c in obj]
+        contours = ttcontours.TTContours.frompackedarrays(*t)
         
         return cls(
-          bounds = ttbounds.TTBounds.fromcontours(vx),
-          contours = ttcontours.TTContours(vx),
+          bounds = ttbounds.TTBounds.fromcontours(contours),
+          contours = contours,
           hintBytes = compositeGlyph.hintBytes)
 
 
@@ -428,8 +437,51 @@ class TTSimpleGlyph(object, metaclass=simplemeta.FontDataMetaclass):
         
         >>> _testingValues[2] == TTSimpleGlyph.frombytes(_testingValues[2].binaryString())
         True
+        
+        Walkers with a native unpackSimpleGlyph() method decode the whole glyph
+        in one call; the result is the same as the Python path below.
+        
+        >>> w = walkerbit.StringWalkerBit(_testingValues[2].binaryString())
+        >>> hasattr(w, 'unpackSimpleGlyph')
+        True
+        >>> TTSimpleGlyph.fromwalker(w) == _testingValues[2]
+        True
+        
+        Repeated contour ends (empty contours) are read just as the Python
+        path reads them:
+        
+        >>> s = utilities.fromhex(
+        ...   "00 02 00 00 00 00 00 64 00 64 00 02 00 02 00 00 31 33 27 64 32 64")
+        >>> g1 = TTSimpleGlyph.fromwalker(walkerbit.StringWalkerBit(s))
+        >>> g2 = TTSimpleGlyph.fromwalker(walker.StringWalker(s))
+        >>> g1 == g2, [len(c) for c in g1.contours]
+        (True, [3, 0])
         """
         
+        t = None
+        
+        if hasattr(w, 'unpackSimpleGlyph'):
+            t = w.unpackSimpleGlyph()
+        
+        if t is not None:
+            bounds, xs, ys, onCurve, ends, h, highBit = t
+            b = ttbounds.TTBounds(*bounds)
+            
+            if not ends:
+                if b == ttbounds.TTBounds():  # special case
+                    b = None
+                
+                return cls(b, ttcontours.TTContours(), h)
+            
+            c = ttcontours.TTContours.frompackedarrays(
+              xs,
+              ys,
+              onCurve,
+              ends,
+              highBit = highBit)
+            
+            return cls(b, c, h)
+        
         numContours = w.unpack("H")
         assert numContours != 0xFFFF, "Composite glyph passed to simple glyph walker!"
         b = ttbounds.TTBounds.fromwalker(w, **kwArgs)
@@ -461,7 +513,7 @@ class TTSimpleGlyph(object, metaclass=simplemeta.FontDataMetaclass):
             runCheck    This is ignored here.
         """
         
-        return sum(len(c) for c in self.contours)
+        return self.contours.pointCount()
 
 # -----------------------------------------------------------------------------
 
@@ -474,6 +526,7 @@ if 0:
 
 if __debug__:
     from fontio3 import utilities
+    from fontio3.utilities import walker, walkerbit
     
     _cstv = ttcontours._testingValues
     
@@ -9,15 +9,16 @@ Support for 'gvar' tables.
 """
 
 # System imports
+import array
 import collections
-import itertools
 import operator
 
 # Other imports
-from fontio3 import utilities
+from fontio3 import fastmathbackend, utilities, utilitiesbackend
 from fontio3.fontdata import simplemeta
 
 from fontio3.gvar import (
+  axial_coordinate,
   axial_coordinates,
   deltas,
   deltas_dict,
@@ -26,7 +27,7 @@ from fontio3.gvar import (
   packed_points,
   point_dict)
 
-from fontio3.utilities import writer
+from fontio3.utilities import walkerbit, writer
     
 # -----------------------------------------------------------------------------
 
@@ -81,7 +82,9 @@ class Gvar(object, metaclass=simplemeta.FontDataMetaclass):
     @staticmethod
     def _emitDeltaBand(w, v):
         """
-        Emit a group of delta values.
+        Emit a group of delta values. The runs are packed natively; a single
+        zero among byte values, or a single byte value among word values, is
+        left inside the surrounding run, since that is never larger.
         
         >>> v = [
         ...   -29, 15, 27, -26, -30, 36, 21, 22, -34, -36, -30, -3, -4, 11,
@@ -97,40 +100,42 @@ class Gvar(object, metaclass=simplemeta.FontDataMetaclass):
               20 | F126 1BD7 DF22 1CED  DCDC E1EA FA01 02FC |.&..."..........|
               30 | 02FC FF15 1318 FBE6  EE1B 2022 E8EB EC1E |.......... "....|
               40 | EF00 E4                                  |...             |
+        
+        >>> w = writer.LinkedWriter()
+        >>> Gvar._emitDeltaBand(w, [5, 0, 7, 0, 0, 0, 300, 2, 400, 1, 1])
+        >>> utilities.hexdump(w.binaryString())
+               0 | 0205 0007 8242 012C  0002 0190 0101 01   |.....B.,....... |
         """
         
-        for k, g in itertools.groupby(v, bool):
-            group = list(g)
-            
-            if not k:
-                while len(group) > 64:
-                    w.add("B", 0xBF)  # 64 zeroes
-                    del group[:64]
-                
-                w.add("B", 0x80 + len(group) - 1)
-                continue
-            
-            funcFitsByte = (lambda x: -128 <= x < 128)
-            
-            for k2, g2 in itertools.groupby(group, funcFitsByte):
-                subGroup = list(g2)
-                mask = (0 if k2 else 0x40)
-                fmt = ("b" if k2 else "h")
-                
-                while len(subGroup) > 64:
-                    w.add("B", mask + 63)
-                    w.addGroup(fmt, subGroup[:64])
-                    del subGroup[:64]
-                
-                w.add("B", mask + len(subGroup) - 1)
-                w.addGroup(fmt, subGroup)
+        w.addString(utilitiesbackend.utPackDeltas(v))
     
     def _fillGlyph(self, w, glyphIndex, globalCoords, pointCount, **kwArgs):
         """
         Given a walker whose base is the start of the header for a single
-        glyph, add the entry for self.glyphData[glyphIndex].
+        glyph, add the entry for self.glyphData[glyphIndex]. If the walker can
+        decode a glyph's variations natively, all of them are unpacked in a
+        single call.
+        
+        >>> from fontio3.utilities import walkerbit
+        >>> s = utilities.fromhex(
+        ...   "00 01 00 0A 00 08 A0 00 40 00 02 01 00 02 01 0A F6 81")
+        >>> obj = Gvar(axisOrder=('wght',))
+        >>> obj._fillGlyph(walkerbit.StringWalkerBit(s), 5, [], 3)
+        >>> obj.glyphData[5].pprint()
+        Point 0:
+          (wght 1.0):
+            Delta X: 10
+            Delta Y: 0
+        Point 2:
+          (wght 1.0):
+            Delta X: -10
+            Delta Y: 0
         """
         
+        if hasattr(w, 'unpackGlyphVariations'):
+            self._fillGlyph_native(w, glyphIndex, globalCoords, pointCount)
+            return
+        
         nTuples, dataOffset = w.unpack("2H")
         sharedPointCase = bool(nTuples & 0x8000)
         nTuples &= 0x0FFF
@@ -188,6 +193,41 @@ class Gvar(object, metaclass=simplemeta.FontDataMetaclass):
             
             nTuples -= 1
     
+    def _fillGlyph_native(self, w, glyphIndex, globalCoords, pointCount):
+        """
+        Fills self.glyphData[glyphIndex] from the list of decoded variations
+        returned by the walker's unpackGlyphVariations() method.
+        """
+        
+        ao = self.axisOrder
+        AC = axial_coordinate.AxialCoordinate
+        ACs = axial_coordinates.AxialCoordinates
+        pd = self.glyphData[glyphIndex] = point_dict.PointDict()
+        v = w.unpackGlyphVariations(len(ao), pointCount)
+        
+        for tupleIndex, peak, start, end, points, xs, ys in v:
+            if peak is not None:
+                coord = ACs([AC(n / 16384) for n in peak], axisOrder=ao)
+            else:
+                coord = globalCoords[tupleIndex & 0x0FFF]
+            
+            if start is not None:
+                effDomain = domain.Domain(
+                  ACs([AC(n / 16384) for n in start], axisOrder=ao),
+                  ACs([AC(n / 16384) for n in end], axisOrder=ao))
+            
+            else:
+                effDomain = None
+            
+            for pointIndex, xDelta, yDelta in zip(points, xs, ys):
+                if pointIndex not in pd:
+                    pd[pointIndex] = deltas_dict.DeltasDict()
+                
+                pd[pointIndex][coord] = deltas.Deltas(
+                  xDelta,
+                  yDelta,
+                  effectiveDomain=effDomain)
+    
     def _fillGlyph_unpack(self, w, pointCount, prefilled):
         """
         """
@@ -201,6 +241,9 @@ class Gvar(object, metaclass=simplemeta.FontDataMetaclass):
             pointIndices = prefilled
         
         # Now that we have the point indices, process the deltas.
+        if hasattr(w, 'unpackPackedDeltas'):
+            return self._fillGlyph_unpack_native(w, pointIndices)
+        
         xDeltas = []
         
         while len(xDeltas) < len(pointIndices):
@@ -240,6 +283,42 @@ class Gvar(object, metaclass=simplemeta.FontDataMetaclass):
         
         return r
     
+    def _fillGlyph_unpack_native(self, w, pointIndices, logger=None):
+        """
+        Returns a dict mapping the specified point indices to (xDelta, yDelta)
+        pairs, using the walker's unpackPackedDeltas() method. If a logger is
+        specified, running out of data is logged and None is returned;
+        otherwise the IndexError propagates.
+        
+        >>> from fontio3.utilities import walkerbit
+        >>> w = walkerbit.StringWalkerBit(utilities.fromhex("01 0A F6 81"))
+        >>> Gvar()._fillGlyph_unpack_native(w, [0, 2])
+        {0: (10, 0), 2: (-10, 0)}
+        
+        >>> logger = utilities.makeDoctestLogger("test")
+        >>> w = walkerbit.StringWalkerBit(utilities.fromhex("01 0A"))
+        >>> print(Gvar()._fillGlyph_unpack_native(w, [0, 2], logger))
+        test - ERROR - Delta data ended too early.
+        None
+        """
+        
+        try:
+            xDeltas = w.unpackPackedDeltas(len(pointIndices))
+            yDeltas = w.unpackPackedDeltas(len(pointIndices))
+        
+        except IndexError:
+            if logger is None:
+                raise
+            
+            logger.error(('V1049', (), "Delta data ended too early."))
+            return None
+        
+        if logger is not None:
+            logger.debug(('Vxxxx', (list(xDeltas),), "xDeltas are %s"))
+            logger.debug(('Vxxxx', (list(yDeltas),), "yDeltas are %s"))
+        
+        return dict(zip(pointIndices, zip(xDeltas, yDeltas)))
+    
     def _fillGlyph_unpack_validated(self, w, pointCount, prefilled, logger):
         """
         """
@@ -257,6 +336,9 @@ class Gvar(object, metaclass=simplemeta.FontDataMetaclass):
             pointIndices = prefilled
         
         # Now that we have the point indices, process the deltas.
+        if hasattr(w, 'unpackPackedDeltas'):
+            return self._fillGlyph_unpack_native(w, pointIndices, logger)
+        
         xDeltas = []
         
         while len(xDeltas) < len(pointIndices):
@@ -457,6 +539,40 @@ class Gvar(object, metaclass=simplemeta.FontDataMetaclass):
         
         return True
     
+    @staticmethod
+    def _findBestSharedPoints(invDict, pointCount):
+        """
+        Returns the frozenset of points that saves the most bytes when shared
+        by the tuples in invDict (as made by PointDict.makeInvertDict()), or
+        None if no point set is used by more than one tuple. The pointCount
+        includes the 4 phantom points.
+        
+        >>> AC = axial_coordinate.AxialCoordinate
+        >>> ACs = axial_coordinates.AxialCoordinates
+        >>> c1, c2, c3 = (ACs([AC(v)], axisOrder=('wght',)) for v in (-1.0, 0.5, 1.0))
+        >>> d = deltas.Deltas(1, 1)
+        >>> invDict = {
+        ...   c1: {0: d, 4: d},
+        ...   c2: {1: d, 2: d, 3: d},
+        ...   c3: {1: d, 2: d, 3: d}}
+        >>> sorted(Gvar._findBestSharedPoints(invDict, 20))
+        [1, 2, 3]
+        >>> del invDict[c3]
+        >>> print(Gvar._findBestSharedPoints(invDict, 20))
+        None
+        """
+        
+        counts = collections.Counter(frozenset(d) for d in invDict.values())
+        best, bestSaving = None, 0
+        
+        for ptSet, count in counts.items():
+            size = len(utilitiesbackend.utPackPoints(sorted(ptSet), pointCount))
+            
+            if (count - 1) * size > bestSaving:
+                best, bestSaving = ptSet, (count - 1) * size
+        
+        return best
+    
     def _findGlobalCoords(self, **kwArgs):
         """
         Analyze the coordinates present in the data, and return a dict of them
@@ -518,12 +634,240 @@ class Gvar(object, metaclass=simplemeta.FontDataMetaclass):
           pointCount = pointCount,
           logger = logger)
     
+    def _glyphBinary(self, invDict, pointCount, dGlobalCoords, sharingEnabled):
+        """
+        Returns the binary data for one glyph's tuples in invDict (as made by
+        PointDict.makeInvertDict()), or an empty bytes object if there are no
+        tuples. The pointCount includes the 4 phantom points.
+        
+        >>> AC = axial_coordinate.AxialCoordinate
+        >>> peak = axial_coordinates.AxialCoordinates(
+        ...   [AC(1.0)],
+        ...   axisOrder = ('wght',))
+        >>> d = deltas.Deltas(1, -1)
+        >>> utilities.hexdump(Gvar()._glyphBinary({peak: {0: d, 2: d}}, 7, {}, True))
+               0 | 0001 000A 000A A000  4000 0201 0002 0101 |........@.......|
+              10 | 0101 FFFF                                |....            |
+        >>> Gvar()._glyphBinary({}, 7, {}, True)
+        b''
+        
+        IUP can cut each tuple down differently, so their points are no longer
+        shared, which is why buildBinary() keeps the smaller of the two forms:
+        
+        >>> c1, c2 = (
+        ...   axial_coordinates.AxialCoordinates([AC(v)], axisOrder=('wght',))
+        ...   for v in (-1.0, 1.0))
+        >>> v1 = [5, 5, 10, -5, 0, 0, -5, 10]
+        >>> v2 = [5, 5, -5, -5, -5, 5, 5, 5]
+        >>> invDict = {
+        ...   c1: {i: deltas.Deltas(v, 0) for i, v in enumerate(v1)},
+        ...   c2: {i: deltas.Deltas(0, v) for i, v in enumerate(v2)}}
+        >>> g = ttsimpleglyph._testingValues[2]
+        >>> optimized = Gvar._iupOptimized(invDict, g, 12, 0.5)
+        >>> [sorted(optimized[c]) for c in (c1, c2)]
+        [[1, 2, 3, 4, 5, 6, 7], [0, 1, 2, 3, 4, 5, 7]]
+        >>> len(Gvar()._glyphBinary(invDict, 12, {}, True))
+        46
+        >>> len(Gvar()._glyphBinary(optimized, 12, {}, True))
+        52
+        """
+        
+        if not invDict:
+            return bytes()
+        
+        w = writer.LinkedWriter()
+        glyphStake = w.stakeCurrent()
+        
+        if sharingEnabled:
+            commonPoints = self._findBestSharedPoints(invDict, pointCount)
+        else:
+            commonPoints = None
+        
+        tupleCount = len(invDict)
+        
+        if commonPoints is not None:
+            tupleCount |= 0x8000
+        
+        w.add("H", tupleCount)
+        sortedCoords = sorted(invDict)
+        tupleDataStake = w.getNewStake()
+        w.addUnresolvedOffset("H", glyphStake, tupleDataStake)
+        tupleSizeStakes = []
+        privatePoints = []  # bools
+        
+        for coord in sortedCoords:
+            dPointToDelta = invDict[coord]
+            tupleSizeStakes.append(w.addDeferredValue("H"))
+            mask = 0
+            
+            if coord not in dGlobalCoords:
+                mask |= 0x8000
+            else:
+                mask = dGlobalCoords[coord]
+            
+            if any(obj.effectiveDomain for obj in dPointToDelta.values()):
+                mask |= 0x4000
+            
+            if commonPoints is not None and frozenset(dPointToDelta) == commonPoints:
+            #if commonPoints is not None and set(dPointToDelta) in commonPoints:
+                privatePoints.append(False)
+            
+            else:
+                mask |= 0x2000
+                privatePoints.append(True)
+            
+            w.add("H", mask)
+            
+            if mask & 0x8000:
+                coord.buildBinary(w)
+            
+            if mask & 0x4000:
+                # we assume there's one unique domain; check this?
+                domPts = [
+                  p
+                  for p, delta in dPointToDelta.items()
+                  if delta.effectiveDomain]
+                
+                dom = dPointToDelta[domPts[0]]
+                dom.effectiveDomain.edge1.buildBinary(w)
+                dom.effectiveDomain.edge2.buildBinary(w)
+        
+        # The array header is now done, so put out the shared points (if
+        # any), and then stake the start of the actual tuple data.
+        
+        w.stakeCurrentWithValue(tupleDataStake)
+        
+        if commonPoints is not None:
+            w.addString(
+              utilitiesbackend.utPackPoints(
+                sorted(commonPoints),
+                pointCount))
+        
+        # Now that the header is done, emit the actual points/deltas
+        
+        for t in zip(sortedCoords, tupleSizeStakes, privatePoints):
+            coord, stake, isPrivate = t
+            wSub = writer.LinkedWriter()
+            dPointToDelta = invDict[coord]
+            sortedPoints = sorted(dPointToDelta)
+            
+            if isPrivate:
+                wSub.addString(
+                  utilitiesbackend.utPackPoints(sortedPoints, pointCount))
+            
+            # Emit x-deltas, in order, to wSub
+            
+            vx = [dPointToDelta[i].x for i in sortedPoints]
+            self._emitDeltaBand(wSub, vx)
+            
+            # Emit y-deltas, in order, to wSub
+            
+            vy = [dPointToDelta[i].y for i in sortedPoints]
+            self._emitDeltaBand(wSub, vy)
+            
+            bs = wSub.binaryString()
+            w.setDeferredValue(stake, "H", len(bs))
+            w.addString(bs)
+        
+        return w.binaryString()
+    
+    @staticmethod
+    def _iupOptimized(invDict, glyphObj, pointCount, tolerance):
+        """
+        Returns a new dict like invDict (as made by PointDict.makeInvertDict())
+        where each tuple only keeps the points whose deltas cannot be inferred
+        by IUP to within tolerance units of their current values, as chosen by
+        fastmathbackend.fmOptimizeIUP(). The current values include the deltas
+        already being inferred for any untouched points. Since the deltas IUP
+        infers are rounded when checked, the tolerance also holds once the
+        font is decoded and rounded. Composite glyphs are
+        not interpolated, so their tuples just lose their zero deltas. Tuples
+        left with no points at all are dropped. The pointCount includes the 4
+        phantom points, whose nonzero deltas are always kept.
+        
+        >>> AC = axial_coordinate.AxialCoordinate
+        >>> peak = axial_coordinates.AxialCoordinates(
+        ...   [AC(1.0)],
+        ...   axisOrder = ('wght',))
+        >>> g = ttsimpleglyph._testingValues[2]
+        >>> xs, ys, onCurve, ends = g.contours.packedArrays()
+        >>> d = {
+        ...   i: deltas.Deltas(round((x - 620) / 10), 0)
+        ...   for i, x in enumerate(xs)}
+        >>> d[9] = deltas.Deltas(36, 0)
+        >>> r = Gvar._iupOptimized({peak: d}, g, 12, 0.5)
+        >>> sorted(r[peak])
+        [1, 3, 4, 6, 9]
+        >>> r[peak][6] is d[6]
+        True
+        >>> d = {i: deltas.Deltas(0, 0) for i in range(12)}
+        >>> Gvar._iupOptimized({peak: d}, g, 12, 0.5)
+        {}
+        """
+        
+        r = {}
+        
+        if not glyphObj.isComposite:
+            packed = glyphObj.contours.packedArrays()
+            n = len(packed[0])
+        
+        for coord, dPointToDelta in invDict.items():
+            dom = next(iter(dPointToDelta.values())).effectiveDomain
+            
+            if glyphObj.isComposite:
+                keep = [p for p, obj in dPointToDelta.items() if obj.x or obj.y]
+                dx = {p: dPointToDelta[p].x for p in keep}
+                dy = {p: dPointToDelta[p].y for p in keep}
+            
+            else:
+                pts = sorted(p for p in dPointToDelta if p < pointCount)
+                
+                dx, dy = fastmathbackend.fmInterpolateUntouched(
+                  *packed,
+                  array.array('l', pts),
+                  array.array('d', (dPointToDelta[p].x for p in pts)),
+                  array.array('d', (dPointToDelta[p].y for p in pts)))
+                
+                dx = array.array('d', (round(x) for x in dx))
+                dy = array.array('d', (round(y) for y in dy))
+                keep = list(fastmathbackend.fmOptimizeIUP(*packed, dx, dy, tolerance))
+                keep.extend(p for p in range(n, pointCount) if dx[p] or dy[p])
+            
+            if not keep:
+                continue
+            
+            dNew = r[coord] = {}
+            
+            for p in keep:
+                x, y = int(dx[p]), int(dy[p])
+                obj = dPointToDelta.get(p)
+                
+                if obj is None or obj.x != x or obj.y != y:
+                    obj = deltas.Deltas(x, y, effectiveDomain=dom)
+                
+                dNew[p] = obj
+        
+        return r
+    
     def buildBinary(self, w, **kwArgs):
         """
         Add the binary data for the Gvar object to the specified writer.
         
         Apart from the usual keyword argument ('stakeValue'), this method also
-        supports the 'sharedPointsAllowed' keyword argument (default True).
+        supports these keyword arguments:
+        
+            iupTolerance            If specified (default None), each tuple's
+                                    points are cut down to those whose deltas
+                                    IUP cannot infer to within this many units
+                                    (0.5 is a good choice); see _iupOptimized()
+                                    for details. A glyph only gets the cut
+                                    down points if they take fewer bytes than
+                                    its points just as they are in self, which
+                                    is what the default writes.
+            
+            sharedPointsAllowed     Default True. If True, the set of points
+                                    that saves the most space is shared by the
+                                    tuples that use it.
         """
         
         if 'stakeValue' in kwArgs:
@@ -533,6 +877,7 @@ class Gvar(object, metaclass=simplemeta.FontDataMetaclass):
             stakeValue = w.stakeCurrent()
         
         sharingEnabled = kwArgs.pop('sharedPointsAllowed', True)
+        iupTolerance = kwArgs.pop('iupTolerance', None)
         e = kwArgs['editor']
         w.add("L", self.VERSION)
         w.add("H", len(self.axisOrder))
@@ -593,98 +938,33 @@ class Gvar(object, metaclass=simplemeta.FontDataMetaclass):
             else:
                 pointCount = glyphObj.pointCount(editor=e) + 4
             
-            pd = gd[glyphIndex]
-            
-            if sharingEnabled:
-                commonPoints = pd.findCommonPoints()
-            else:
-                commonPoints = None
-            
-            invDict = pd.makeInvertDict()
-            tupleCount = len(invDict)
-            
-            if commonPoints is not None:
-                tupleCount |= 0x8000
+            invDict = gd[glyphIndex].makeInvertDict()
             
-            w.add("H", tupleCount)
-            sortedCoords = sorted(invDict)
-            tupleDataStake = w.getNewStake()
-            w.addUnresolvedOffset("H", glyphStakes[glyphIndex], tupleDataStake)
-            tupleSizeStakes = []
-            privatePoints = []  # bools
-            
-            for coord in sortedCoords:
-                dPointToDelta = invDict[coord]
-                tupleSizeStakes.append(w.addDeferredValue("H"))
-                mask = 0
-                
-                if coord not in dGlobalCoords:
-                    mask |= 0x8000
-                else:
-                    mask = dGlobalCoords[coord]
-                
-                if any(obj.effectiveDomain for obj in dPointToDelta.values()):
-                    mask |= 0x4000
-                
-                if commonPoints is not None and frozenset(dPointToDelta) == commonPoints:
-                #if commonPoints is not None and set(dPointToDelta) in commonPoints:
-                    privatePoints.append(False)
-                
-                else:
-                    mask |= 0x2000
-                    privatePoints.append(True)
-                
-                w.add("H", mask)
-                
-                if mask & 0x8000:
-                    coord.buildBinary(w)
+            bs = self._glyphBinary(
+              invDict,
+              pointCount,
+              dGlobalCoords,
+              sharingEnabled)
+            
+            # Optimizing each tuple on its own can leave the tuples with
+            # different point sets, which then can no longer be shared, so
+            # the optimized form is only used if it really is smaller.
+            
+            if iupTolerance is not None:
+                bsIUP = self._glyphBinary(
+                  self._iupOptimized(
+                    invDict,
+                    glyphObj,
+                    pointCount,
+                    iupTolerance),
+                  pointCount,
+                  dGlobalCoords,
+                  sharingEnabled)
                 
-                if mask & 0x4000:
-                    # we assume there's one unique domain; check this?
-                    domPts = [
-                      p
-                      for p, delta in dPointToDelta.items()
-                      if delta.effectiveDomain]
-                    
-                    dom = dPointToDelta[domPts[0]]
-                    dom.effectiveDomain.edge1.buildBinary(w)
-                    dom.effectiveDomain.edge2.buildBinary(w)
-            
-            # The array header is now done, so put out the shared points (if
-            # any), and then stake the start of the actual tuple data.
-            
-            w.stakeCurrentWithValue(tupleDataStake)
+                if len(bsIUP) < len(bs):
+                    bs = bsIUP
             
-            if commonPoints is not None:
-                packedCommons = packed_points.PackedPoints(commonPoints)
-                packedCommons.buildBinary(w, pointCount=pointCount-4)
-            
-            # Now that the header is done, emit the actual points/deltas
-            
-            for t in zip(sortedCoords, tupleSizeStakes, privatePoints):
-                coord, stake, isPrivate = t
-                wSub = writer.LinkedWriter()
-                dPointToDelta = invDict[coord]
-                sortedPoints = sorted(dPointToDelta)
-                
-                if isPrivate:
-                    packed_points.PackedPoints(dPointToDelta).buildBinary(
-                      wSub,
-                      pointCount = pointCount - 4)
-                
-                # Emit x-deltas, in order, to wSub
-                
-                vx = [dPointToDelta[i].x for i in sortedPoints]
-                self._emitDeltaBand(wSub, vx)
-                
-                # Emit y-deltas, in order, to wSub
-                
-                vy = [dPointToDelta[i].y for i in sortedPoints]
-                self._emitDeltaBand(wSub, vy)
-                
-                bs = wSub.binaryString()
-                w.setDeferredValue(stake, "H", len(bs))
-                w.addString(bs)
+            w.addString(bs)
         
         w.alignToByteMultiple(2)
         w.stakeCurrentWithValue(glyphStakes[-1])
@@ -916,7 +1196,11 @@ class Gvar(object, metaclass=simplemeta.FontDataMetaclass):
             else:
                 pointCount = glyphObj.pointCount()
             
-            wSub = w.subWalker(off1 + dataOff)
+            wSub = w.subWalker(off1 + dataOff, newLimit=off2 + dataOff)
+            
+            if not hasattr(wSub, 'unpackGlyphVariations'):
+                wSub = walkerbit.StringWalkerBit(wSub.rest())
+            
             r._fillGlyph(wSub, glyphIndex, globalCoords, pointCount, **kwArgs)
         
         return r
@@ -930,6 +1214,9 @@ class Gvar(object, metaclass=simplemeta.FontDataMetaclass):
 if 0:
     def __________________(): pass
 
+if __debug__:
+    from fontio3.glyf import ttsimpleglyph
+
 def _test():
     import doctest
     doctest.testmod()
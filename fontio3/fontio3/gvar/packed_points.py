@@ -8,11 +8,8 @@
 Support for arrays of points as represented in 'gvar' tables.
 """
 
-# System imports
-import itertools
-
 # Other imports
-from fontio3 import utilities
+from fontio3 import utilities, utilitiesbackend
 from fontio3.fontdata import seqmeta
 from fontio3.utilities import span2
 
@@ -103,35 +100,7 @@ class PackedPoints(tuple, metaclass=seqmeta.FontDataMetaclass):
         pointCount = kwArgs['pointCount']
         v = sorted(set(self))  # probably is already, but just in case...
         
-        if v[-1] >= (pointCount + 4):
-            raise ValueError("Largest point index exceeds glyph's count!")
-        
-        if v == list(range(pointCount + 4)):
-            w.add("B", 0)
-            return
-        
-        if len(v) < 128:
-            w.add("B", len(v))
-        else:
-            w.add("H", 0x8000 + len(v))
-        
-        # Remember that the values here are actually deltas, not raw point
-        # indices; this means that we can't simply use a Span to break things
-        # into groups.
-        
-        deltas = v[0:1] + [b - a for a, b in utilities.pairwise(v)]
-        
-        for k, g in itertools.groupby(deltas, (lambda x: x > 255)):
-            bigGroup = list(g)
-            fmt = ("H" if k else "B")
-            
-            while len(bigGroup) > 128:
-                w.add("B", (0xFF if k else 0x7F))
-                w.addGroup(fmt, bigGroup[:128])
-                del bigGroup[0:128]
-            
-            w.add("B", len(bigGroup) - 1 + (0x80 if k else 0))
-            w.addGroup(fmt, bigGroup)
+        w.addString(utilitiesbackend.utPackPoints(v, pointCount + 4))
     
     @classmethod
     def fromvalidatedwalker(cls, w, **kwArgs):
@@ -269,6 +238,10 @@ class PackedPoints(tuple, metaclass=seqmeta.FontDataMetaclass):
         """
         
         pointCount = kwArgs['pointCount']
+        
+        if hasattr(w, 'unpackPackedPoints'):
+            return cls(w.unpackPackedPoints(pointCount))
+        
         totalPoints = w.unpack("B")
         pointIndices = []
         
@@ -10,15 +10,64 @@ given glyph.
 """
 
 # System imports
+import array
 import collections
 
 # Other imports
+from fontio3 import fastmathbackend
 from fontio3.fontdata import mapmeta
-from fontio3.fontmath import interpolation
 from fontio3.gvar import deltas
     
 # -----------------------------------------------------------------------------
 
+#
+# Private functions
+#
+
+def _tupleScalar(peak, coord, ed):
+    """
+    Returns the scalar for a tuple variation with the specified peak at the
+    specified coord. If ed is not None it is the tuple's intermediate Domain.
+    """
+    
+    factor = 1
+    
+    for i, (peakValue, coordValue) in enumerate(zip(peak, coord)):
+        if not factor:
+            break
+        
+        if ed is not None:
+            ed1 = min(ed.edge1[i], ed.edge2[i])
+            ed2 = max(ed.edge1[i], ed.edge2[i])
+        
+        if not peakValue:
+            continue
+        
+        if (
+          (not coordValue) or 
+          (coordValue < 0 and peakValue > 0) or 
+          (coordValue > 0 and peakValue < 0) or
+          ((ed is None) and (abs(coordValue) > abs(peakValue)))):
+          
+            factor = 0
+        
+        elif ed is None:
+            factor *= (coordValue / peakValue)
+        
+        elif (coordValue < ed1) or (coordValue > ed2):
+            factor = 0
+        
+        elif coordValue < peakValue:
+            if peakValue != ed1:
+                factor *= (coordValue - ed1) / (peakValue - ed1)
+        
+        elif ed2 != peakValue:
+            factor *= (ed2 - coordValue) / (ed2 - peakValue)
+    
+    return factor
+
+# -----------------------------------------------------------------------------
+
 #
 # Classes
 #
@@ -61,132 +110,57 @@ class PointDict(dict, metaclass=mapmeta.FontDataMetaclass):
     
     def deltasForCoord_simple(self, coord, glyphObj):
         """
-        """
+        Returns a dict mapping every point index in glyphObj (including the 4
+        phantom points) to a Deltas object with the rounded sum of all the
+        tuple variations at the specified coord. Deltas for points that are
+        not explicitly present in a tuple are inferred from the neighbouring
+        points in the same contour, as the 'gvar' IUP rules specify; this work
+        is done in a single fastmath backend call.
         
-        allPts = [p for c in glyphObj.contours for p in c]
-        r = {p: [0, 0] for p in range(len(allPts)+4)}
-        d = self.makeInvertDict()  # {coord: {pt: dlt, pt: dlt...}, ...}
+        >>> g = ttsimpleglyph._testingValues[2]
+        >>> [(p.x, p.y) for p in g.contours[0]]
+        [(620, 610), (620, 1090), (980, 1090), (980, 610)]
+        >>> AC = axial_coordinate.AxialCoordinate
+        >>> ACs = axial_coordinates.AxialCoordinates
+        >>> peak = ACs([AC(1.0)], axisOrder=('wght',))
+        >>> pd = PointDict({
+        ...   0: deltas_dict.DeltasDict({peak: deltas.Deltas(-20, -20)}),
+        ...   2: deltas_dict.DeltasDict({peak: deltas.Deltas(40, 40)})})
+        >>> d = pd.deltasForCoord_simple((0.5,), g)
+        >>> [tuple(d[p]) for p in range(4)]
+        [(-10, -10), (-10, 20), (20, 20), (20, -10)]
         
-        for keyCoord, keySubDict in d.items():
-            kDeltas = {}
-            
-            # This loop can go over all points at once
-            
-            for p, dlt in keySubDict.items():
-                factor = 1
-                ed = dlt.effectiveDomain
-                it = enumerate(zip(keyCoord, coord))
-                
-                for i, (peakValue, coordValue) in it:
-                    if not factor:
-                        break
-                    
-                    if ed is not None:
-                        ed1 = min(ed.edge1[i], ed.edge2[i])
-                        ed2 = max(ed.edge1[i], ed.edge2[i])
-                    
-                    if not peakValue:
-                        continue
-                
-                    if (
-                      (not coordValue) or 
-                      (coordValue < 0 and peakValue > 0) or 
-                      (coordValue > 0 and peakValue < 0) or
-                      ((ed is None) and (abs(coordValue) > abs(peakValue)))):
-                  
-                        factor = 0
-                
-                    elif ed is None:
-                        factor *= (coordValue / peakValue)
-                
-                    elif (coordValue < ed1) or (coordValue > ed2):
-                        factor = 0
-                
-                    elif coordValue < peakValue:
-                        if peakValue != ed1:
-                            factor *= (coordValue - ed1) / (peakValue - ed1)
-                
-                    elif ed2 != peakValue:
-                        factor *= (ed2 - coordValue) / (ed2 - peakValue)
-                
-                kDeltas[p] = [factor * dlt.x, factor * dlt.y]
-            
-            # Now need to interpolate for all keys missing from kDeltas
-            # Note we don't need to interpolate phantoms (single points)
-            #
-            # Note that unlike above, this loop needs to respect contours
-            
-            hadActualDeltas = set(kDeltas)
-            walkPoint = 0
-            
-            for c in glyphObj.contours:
-                pointsFull = set(range(walkPoint, walkPoint + len(c)))
-                basePoint = walkPoint
-                walkPoint += len(c)
-                pointsPresent = hadActualDeltas & pointsFull
-                
-                if not pointsPresent:
-                    continue
-                
-                pointsMissing = pointsFull - pointsPresent
-                sortedPresent = sorted(pointsPresent)
-                dPrevNext = {}
-            
-                for p in pointsMissing:
-                    if p < sortedPresent[0]:
-                        pPrev = sortedPresent[-1]
-                    else:
-                        pPrev = max(q for q in pointsPresent if q < p)
-                
-                    if p > sortedPresent[-1]:
-                        pNext = sortedPresent[0]
-                    else:
-                        pNext = min(q for q in pointsPresent if q > p)
-                
-                    dPrevNext[p] = (pPrev, pNext)
-            
-                for p in pointsMissing:
-                    if p not in kDeltas:
-                        kDeltas[p] = [0, 0]
-                
-                    for xy in (0, 1):
-                        xyCoord = c[p-basePoint][xy]
-                        pPrev, pNext = dPrevNext[p]
-                        xyPrev = c[pPrev-basePoint][xy]
-                        xyNext = c[pNext-basePoint][xy]
-                    
-                        if xyPrev > xyNext:
-                            xyNext, xyPrev = xyPrev, xyNext
-                            pNext, pPrev = pPrev, pNext
-                    
-                        if xyPrev <= xyCoord <= xyNext:
-                            # it lies between; do interpolation
-                            if xyNext == xyPrev:
-                                kDeltas[p][xy] = (kDeltas[pPrev][xy] + kDeltas[pNext][xy]) / 2
-                            
-                            else:
-                                portion = (xyCoord - xyPrev) / (xyNext - xyPrev)
-                                totalDist = kDeltas[pNext][xy] - kDeltas[pPrev][xy]
-                                kDeltas[p][xy] = kDeltas[pPrev][xy] + portion * totalDist
-                    
-                        elif abs(xyPrev-xyCoord) < abs(xyNext-xyCoord):
-                            # it lies outside; shift by xyPrev's shift
-                            kDeltas[p][xy] = kDeltas[pPrev][xy]
-                    
-                        else:
-                            # it lies outside; shift by xyNext's shift
-                            kDeltas[p][xy] = kDeltas[pNext][xy]
-            
-            for p, dlt in kDeltas.items():
-                if p not in r:  # handle Zycon glyph 34 and similar cases
-                    continue
-                
-                r[p][0] += dlt[0]
-                r[p][1] += dlt[1]
+        The second contour has no explicit deltas, so it doesn't move:
+        
+        >>> sorted(d) == list(range(12)), set(tuple(d[p]) for p in range(4, 12))
+        (True, {(0, 0)})
         
+        When the two touched points on either side of an untouched point have
+        the same coordinate, and so does the untouched point, it gets the
+        average of their deltas (here in x; y is interpolated as usual):
+        
+        >>> c = ttcontours.TTContours.frompackedarrays(
+        ...   [0, 0, 0, 100],
+        ...   [0, 50, 100, 50],
+        ...   bytes([1, 1, 1, 1]),
+        ...   [3])
+        >>> g = ttsimpleglyph.TTSimpleGlyph(contours=c)
+        >>> pd = PointDict({
+        ...   0: deltas_dict.DeltasDict({peak: deltas.Deltas(10, 10)}),
+        ...   2: deltas_dict.DeltasDict({peak: deltas.Deltas(30, 50)})})
+        >>> d = pd.deltasForCoord_simple((1.0,), g)
+        >>> [tuple(d[p]) for p in range(4)]
+        [(10, 10), (20, 30), (30, 50), (10, 30)]
+        """
+        
+        packed = glyphObj.contours.packedArrays()
+        job = (packed, self.scaledTuples(coord))
+        xs, ys = fastmathbackend.fmInterpolateUntouchedBatch([job])[0]
         D = deltas.Deltas
-        r = {p: D(int(round(v[0])), int(round(v[1]))) for p, v in r.items()}
-        return r
+        
+        return {
+          p: D(int(round(x)), int(round(y)))
+          for p, (x, y) in enumerate(zip(xs, ys))}
     
     def findCommonPoints(self):
         """
@@ -238,6 +212,85 @@ class PointDict(dict, metaclass=mapmeta.FontDataMetaclass):
                 r.setdefault(coord, {})[pointIndex] = deltasObj
         
         return r
+    
+    def scaledTuples(self, coord, scalarCache=None):
+        """
+        Returns a list of (scalar, points, xDeltas, yDeltas) tuples, one for
+        each tuple variation in self whose scalar at the specified coord is not
+        zero, in the form fastmathbackend.fmInterpolateUntouchedBatch() takes.
+        The points are an array('l') and the deltas are array('d') objects.
+        
+        If scalarCache is specified it should be a dict, which is used to look
+        up (and remember) the scalar for each (peak, domain) pair at coord.
+        Passing the same dict for every glyph being instanced means each
+        distinct tuple's scalar is only computed once for the whole font.
+        
+        >>> AC = axial_coordinate.AxialCoordinate
+        >>> ACs = axial_coordinates.AxialCoordinates
+        >>> ao = ('wght', 'wdth')
+        >>> peak1 = ACs([AC(1.0), AC(0.0)], axisOrder=ao)
+        >>> peak2 = ACs([AC(0.0), AC(-1.0)], axisOrder=ao)
+        >>> pd = PointDict({
+        ...   3: deltas_dict.DeltasDict({
+        ...     peak1: deltas.Deltas(10, 4),
+        ...     peak2: deltas.Deltas(-8, 0)}),
+        ...   5: deltas_dict.DeltasDict({peak1: deltas.Deltas(0, 6)})})
+        >>> for t in pd.scaledTuples((0.5, 0.0)):
+        ...   print(t[0], list(t[1]), list(t[2]), list(t[3]))
+        0.5 [3, 5] [10.0, 0.0] [4.0, 6.0]
+        >>> pd.scaledTuples((0.0, 0.5))
+        []
+        
+        >>> cache = {}
+        >>> len(pd.scaledTuples((0.5, 0.0), scalarCache=cache)), len(cache)
+        (1, 2)
+        """
+        
+        if scalarCache is None:
+            scalarCache = {}
+        
+        r = []
+        
+        for keyCoord, keySubDict in self.makeInvertDict().items():
+            factors = {}
+            
+            for dlt in keySubDict.values():
+                ed = dlt.effectiveDomain
+                k = (None if ed is None else (ed.edge1, ed.edge2))
+                
+                if k not in factors:
+                    ck = (keyCoord, k)
+                    
+                    if ck not in scalarCache:
+                        scalarCache[ck] = _tupleScalar(keyCoord, coord, ed)
+                    
+                    factors[k] = scalarCache[ck]
+            
+            if not any(factors.values()):
+                continue
+            
+            points = array.array('l', keySubDict)
+            
+            if len(factors) == 1:
+                scalar = next(iter(factors.values()))
+                xs = array.array('d', (dlt.x for dlt in keySubDict.values()))
+                ys = array.array('d', (dlt.y for dlt in keySubDict.values()))
+            
+            else:
+                # Different domains in one tuple; scale each delta here.
+                scalar = 1.0
+                xs = array.array('d')
+                ys = array.array('d')
+                
+                for dlt in keySubDict.values():
+                    ed = dlt.effectiveDomain
+                    f = factors[None if ed is None else (ed.edge1, ed.edge2)]
+                    xs.append(f * dlt.x)
+                    ys.append(f * dlt.y)
+            
+            r.append((scalar, points, xs, ys))
+        
+        return r
 
 # -----------------------------------------------------------------------------
 
@@ -248,6 +301,10 @@ class PointDict(dict, metaclass=mapmeta.FontDataMetaclass):
 if 0:
     def __________________(): pass
 
+if __debug__:
+    from fontio3.glyf import ttcontours, ttsimpleglyph
+    from fontio3.gvar import axial_coordinate, axial_coordinates, deltas_dict
+
 def _test():
     import doctest
     doctest.testmod()
@@ -9,12 +9,13 @@ Support for the TrueType 'head' table.
 """
 
 # System imports
+import array
 import datetime
 import logging
 import time
 
 # Other imports
-from fontio3 import utilities
+from fontio3 import fastmathbackend, utilities
 
 from fontio3.fontdata import simplemeta
 from fontio3.head import flags, macstyle
@@ -93,11 +94,33 @@ def _pprint_time(p, timeInSeconds, label, **kwArgs):
         p.simple("0x%x" % (timeInSeconds,), label=label)
 
 def _recalc(obj, **kwArgs):
+    """
+    Recalculates the font bounding box from the glyphs. CFF outlines are
+    bounded in one native call, which gives the same box as recalculating
+    each glyph's bounds in Python (glyph 2 here has a contour that starts
+    off-curve, so it is recalculated instead):
+    
+    >>> e = _makeCFFEditor()
+    >>> r = Head().recalculated(editor=e)
+    >>> r.xMin, r.yMin, r.xMax, r.yMax
+    (-40, 0, 500, 700)
+    >>> v = [g.recalculated().bounds for g in e[b'CFF '].values()]
+    >>> v = [b for b in v if b]
+    >>> print((r.xMin, r.yMin, r.xMax, r.yMax) == (
+    ...   min(b.xMin for b in v),
+    ...   min(b.yMin for b in v),
+    ...   max(b.xMax for b in v),
+    ...   max(b.yMax for b in v)))
+    True
+    """
+    
     editor = kwArgs['editor']
     r = obj.__deepcopy__()
     
     if editor is not None:
-        if editor.reallyHas(b'glyf'):
+        isGlyf = editor.reallyHas(b'glyf')
+        
+        if isGlyf:
             glyphTbl = editor.glyf
         elif editor.reallyHas(b'CFF '):
             glyphTbl = editor['CFF ']
@@ -110,14 +133,69 @@ def _recalc(obj, **kwArgs):
             r.xMax = -32767
             r.yMin = 32767
             r.yMax = -32767
-            for gl in list(glyphTbl.values()):
-                if gl:
+            packed = []
+            
+            if isGlyf:
+                # all glyphs (composites included) are decomposed and then
+                # bounded in native batches
+                d = glyphTbl.flattenedArrays()
+                
+                for glyphIndex, t in d.items():
+                    if t is not None:
+                        packed.append(t)
+                    
+                    elif glyphTbl[glyphIndex].bounds:
+                        # unresolvable composite; keep its stored bounds
+                        b = glyphTbl[glyphIndex].bounds
+                        r.xMin = min(r.xMin, b.xMin)
+                        r.xMax = max(r.xMax, b.xMax)
+                        r.yMin = min(r.yMin, b.yMin)
+                        r.yMax = max(r.yMax, b.yMax)
+            
+            else:
+                # CFF outlines are packed into a single buffer of cubic
+                # segments and bounded in one native call; composites and
+                # irregular contours are still recalculated
+                cubics = array.array('d')
+                
+                for gl in list(glyphTbl.values()):
+                    if not gl:
+                        continue
+                    
+                    if not gl.isComposite:
+                        if not gl.contours:
+                            continue
+                        
+                        segs = gl.contours.packedSegments()
+                        
+                        if segs is not None:
+                            cubics.extend(segs)
+                            continue
+                    
                     glr = gl.recalculated(editor=editor)
+                    
                     if glr.bounds:
                         r.xMin = min(r.xMin, glr.bounds.xMin)
                         r.xMax = max(r.xMax, glr.bounds.xMax)
                         r.yMin = min(r.yMin, glr.bounds.yMin)
                         r.yMax = max(r.yMax, glr.bounds.yMax)
+                
+                b = fastmathbackend.fmCubicBounds(cubics)
+                
+                if b is not None:
+                    # CFFBounds rounds each glyph's extrema; rounding is
+                    # monotonic, so rounding the union gives the same result
+                    r.xMin = min(r.xMin, int(round(b[0])))
+                    r.yMin = min(r.yMin, int(round(b[1])))
+                    r.xMax = max(r.xMax, int(round(b[2])))
+                    r.yMax = max(r.yMax, int(round(b[3])))
+            
+            for b in fastmathbackend.fmQuadBoundsBatch(packed):
+                if b is not None:
+                    r.xMin = min(r.xMin, utilities.truncateRound(b[0], int))
+                    r.yMin = min(r.yMin, utilities.truncateRound(b[1], int))
+                    r.xMax = max(r.xMax, utilities.ceilingRound(b[2], int))
+                    r.yMax = max(r.yMax, utilities.ceilingRound(b[3], int))
     
     return r != obj, r
 
@@ -1099,7 +1177,40 @@ if 0:
     def __________________(): pass
 
 if __debug__:
-    from fontio3 import utilities
+    from fontio3 import fontedit, utilities
+    from fontio3.CFF import CFF, cffcontours, cffglyph
+    from fontio3.fontmath import contour_cubic, pointwithonoff
+    from fontio3.utilities import walker
+    
+    def _makeCFFEditor():
+        # an Editor with only a 'CFF ' table, holding one ordinary glyph and
+        # one whose contour starts with an off-curve point
+        cffObj = CFF.CFF.fromwalker(
+          walker.StringWalker(utilities.fromhex(CFF._testingData)))
+        
+        cffObj[1] = cffglyph.CFFGlyph.fromcffdata(
+          utilities.fromhex(
+            "8C 8B BD F7 ED 77 F7 A7 BD 01 8B BD F8 24 BD 03 "
+            "8B 04 F8 88 F9 50 FC 88 06 F7 8E FB C5 15 FB 3E "
+            "F7 93 05 F7 E8 06 FB 20 FB C0 15 F7 3E F7 93 05 "
+            "FC 92 07 FC 06 5E 15 F7 3E F7 93 F7 3E FB 93 05 "
+            "FC 06 F8 BF 15 F7 3E FB 93 FB 3E FB 93 05 0E"),
+          {'nominalWidthX': 499},
+          [],
+          {})
+        
+        P = pointwithonoff.PointWithOnOff
+        
+        cffObj[2] = cffglyph.CFFGlyph(
+          contours = cffcontours.CFFContours([
+            contour_cubic.Contour_cubic([
+              P((-40, 10), onCurve=False),
+              P((20, 30), onCurve=True),
+              P((60, 10), onCurve=True)])]))
+        
+        e = fontedit.Editor()
+        e[b'CFF '] = cffObj
+        return e
     
     _testingValues = (
         Head(),
@@ -9,6 +9,7 @@ Functions and classes for displaying and editing data from the 'loca' table.
 """
 
 # System imports
+import array
 import itertools
 import logging
 import operator
@@ -268,23 +269,10 @@ class Loca(list, metaclass=seqmeta.FontDataMetaclass):
         
         bytesAvailable = int(w.length())
         assert bytesAvailable == w.length()  # can't be non-byte aligned
-        
-        if kwArgs['isLongOffsets']:
-            assert (bytesAvailable % 4) == 0
-            entryCount = bytesAvailable // 4
-            v = w.group("L", entryCount)
-            r = cls((v[i], v[i + 1] - v[i]) for i in range(entryCount - 1))
-        
-        else:
-            assert (bytesAvailable % 2) == 0
-            entryCount = bytesAvailable // 2
-            v = w.group("H", entryCount)
-            
-            r = cls(
-              (2 * v[i], 2 * (v[i + 1] - v[i]))
-              for i in range(entryCount - 1))
-        
-        return r
+        isLong = kwArgs['isLongOffsets']
+        assert (bytesAvailable % (4 if isLong else 2)) == 0
+        v = w.unpackLocaOffsets(isLong)
+        return cls((v[i], v[i + 1] - v[i]) for i in range(len(v) - 1))
     
     def needsLongOffsets(self):
         """
@@ -303,6 +291,30 @@ class Loca(list, metaclass=seqmeta.FontDataMetaclass):
             return (last[0] + last[1]) >= 0x20000
         
         return False
+    
+    def offsets(self):
+        """
+        Returns an array('L') with the starting byte offset of each glyph,
+        followed by the offset just past the last glyph. This is the form the
+        walker's glyphSlice() method uses.
+        
+        >>> _testingValues[0].offsets()
+        array('L', [0])
+        
+        >>> _testingValues[1].offsets()
+        array('L', [0, 50, 250, 400])
+        """
+        
+        r = array.array('L', (t[0] for t in self))
+        
+        if self:
+            last = self[-1]
+            r.append(last[0] + last[1])
+        
+        else:
+            r.append(0)
+        
+        return r
 
 # -----------------------------------------------------------------------------
 
@@ -50,7 +50,7 @@ def _deepwalk(n, depth, simpleCount, glyfTable):
         return totalPoints, totalContours, retDepth, simpleCount
     
     return (
-      sum([len(c) for c in d.contours]),
+      d.contours.pointCount(),
       len(d.contours),
       retDepth,
       max(1, simpleCount))
@@ -108,7 +108,7 @@ def _recalc(obj, **kwArgs):
         else:
             obj2.maxPoints = max(
               obj2.maxPoints,
-              sum(len(c) for c in d.contours))
+              d.contours.pointCount())
             
             obj2.maxContours = max(obj2.maxContours, len(d.contours))
         
@@ -440,6 +440,56 @@ class FileWalkerBit:
     
     def getPhase(self): return self.getBitOffset() % 8
     
+    def glyphSlice(self, offsets, index):
+        """
+        Returns a bytestring with entry index of a table like 'glyf', whose
+        entries are located by offsets, an array('L') of byte offsets relative
+        to the start of this walker. See StringWalkerBit.glyphSlice(); since
+        the data have to be read from the file this is a copy, not a view.
+        
+        >>> wb = FileWalkerBit(_tempPath, bitStart=8 * 65)
+        >>> offsets = array.array('L', [0, 3, 3, 10])
+        >>> wb.glyphSlice(offsets, 0), wb.glyphSlice(offsets, 2)
+        (b'ABC', b'DEFGHIJ')
+        >>> wb.glyphSlice(offsets, 3)
+        Traceback (most recent call last):
+          ...
+        IndexError: Glyph index out of range!
+        
+        >>> wb.glyphSlice(array.array('L', [10, 3]), 0)
+        Traceback (most recent call last):
+          ...
+        ValueError: Glyph offsets are out of order!
+        
+        >>> wb.glyphSlice(array.array('L', [190, 192]), 0)
+        Traceback (most recent call last):
+          ...
+        ValueError: Glyph data extend past the end of the table!
+        """
+        
+        if not (0 <= index < len(offsets) - 1):
+            raise IndexError("Glyph index out of range!")
+        
+        start, limit = offsets[index], offsets[index + 1]
+        
+        if start > limit:
+            raise ValueError("Glyph offsets are out of order!")
+        
+        here = self.getOffset(relative=True)
+        
+        if limit > here + int(self.length()):
+            raise ValueError("Glyph data extend past the end of the table!")
+        
+        if start == limit:
+            return b''
+        
+        base = self.getOffset() - here
+        
+        return self.subWalker(
+          base + start,
+          absoluteAnchor = True,
+          newLimit = base + limit).rest()
+    
     def group(self, format, count, finalCoerce=False):
         """
         Unpacks count records, each of which has format, and returns them in a
@@ -903,6 +953,24 @@ class FileWalkerBit:
           itemCount,
           signed)
 
+    def unpackLocaOffsets(self, isLong):
+        """
+        Decodes the rest of the walker as a 'loca' table and returns its byte
+        offsets as an array('L'). See StringWalkerBit.unpackLocaOffsets(); the
+        decoding itself is done on the bytes remaining in this walker.
+        
+        >>> wb = FileWalkerBit(_tempPath, bitStart=8 * 250)
+        >>> list(wb.unpackLocaOffsets(False)), wb.atEnd()
+        ([128502, 129530, 130558], True)
+        """
+        
+        from fontio3.utilities import walkerbit
+        
+        w = walkerbit.StringWalkerBit(self.piece(int(self.length())))
+        v = w.unpackLocaOffsets(isLong)
+        self.skip(int(w.getOffset()))
+        return v
+    
     def unpackRest(self, format, coerce=True, strict=True):
         """
         Returns a tuple with values from the remainder of the file, as per the
@@ -936,6 +1004,29 @@ class FileWalkerBit:
           format,
           coerce,
           strict)
+    
+    def unpackSimpleGlyph(self):
+        """
+        Decodes the TrueType simple glyph starting at the current (byte-aligned)
+        offset and advances past it. See StringWalkerBit.unpackSimpleGlyph() for
+        a description of the returned tuple; the decoding itself is done on the
+        bytes remaining in this walker.
+        
+        >>> wb = FileWalkerBit(_tempPath)
+        >>> wb.unpackSimpleGlyph()
+        Traceback (most recent call last):
+          ...
+        IndexError: Attempt to unpack past end of string!
+        >>> wb.getOffset()
+        0
+        """
+        
+        from fontio3.utilities import walkerbit
+        
+        w = walkerbit.StringWalkerBit(self.piece(int(self.length())))
+        t = w.unpackSimpleGlyph()
+        self.skip(int(w.getOffset()))
+        return t
 
 # -----------------------------------------------------------------------------
 
@@ -975,6 +1066,7 @@ if 0:
 
 
 if __name__ == "__main__" and __debug__:
+    import array
     import os
     import tempfile
     
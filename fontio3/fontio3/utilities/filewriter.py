@@ -13,6 +13,7 @@ without having to worry about slowing down the rest of Python.
 
 # System imports
 import collections
+import os
 import sys
 import tempfile
 
@@ -21,6 +22,14 @@ from fontio3 import utilities, utilitiesbackend
 
 # -----------------------------------------------------------------------------
 
+#
+# Private constants
+#
+
+_COPY_CHUNK = 1 << 20  # bytes per read when a file range is read or copied
+
+# -----------------------------------------------------------------------------
+
 #
 # Classes
 #
@@ -45,6 +54,7 @@ class LinkedFileWriter:
     #
     
     def __del__(self):
+        self._closeSourceFiles()
         self.backingFile.close()
         self.backingFile = None
     
@@ -58,6 +68,7 @@ class LinkedFileWriter:
         # is closed in the __del__() method.
         
         self.backingFile = tempfile.TemporaryFile()
+        self.sourceFiles = {}
         self.reset()
     
     @staticmethod
@@ -130,6 +141,67 @@ class LinkedFileWriter:
     
     byteLength = property(_byteLength)
     
+    def _closeSourceFiles(self):
+        """
+        Closes any files opened for addFileRange() calls.
+        """
+        
+        for f in self.sourceFiles.values():
+            f.close()
+        
+        self.sourceFiles = {}
+    
+    @staticmethod
+    def _copyRange(fIn, fOut, offset, length):
+        """
+        Copies length bytes starting at offset in the file fIn to the current
+        position of the file fOut, letting the kernel move the data where it
+        can (via copy_file_range or sendfile), so they never pass through
+        Python. If neither is available, or the files don't support it, the
+        data are copied in bounded chunks instead.
+        """
+        
+        fOut.flush()
+        inFD, outFD = fIn.fileno(), fOut.fileno()
+        outPos = fOut.tell()
+        
+        for f in ('copy_file_range', 'sendfile'):
+            if length and hasattr(os, f):
+                try:
+                    while length:
+                        if f == 'sendfile':
+                            os.lseek(outFD, outPos, os.SEEK_SET)
+                            n = os.sendfile(outFD, inFD, offset, length)
+                        else:
+                            n = os.copy_file_range(
+                              inFD,
+                              outFD,
+                              length,
+                              offset,
+                              outPos)
+                        
+                        if not n:
+                            break
+                        
+                        offset += n
+                        outPos += n
+                        length -= n
+                
+                except OSError:
+                    pass
+        
+        fOut.seek(outPos)
+        fIn.seek(offset)
+        
+        while length:
+            bs = fIn.read(min(length, _COPY_CHUNK))
+            
+            if not bs:
+                raise IOError("Source file is shorter than expected!")
+            
+            fOut.write(bs)
+            length -= len(bs)
+    
     def _makeResolvedIterator(self, **kwArgs):
         """
         Returns an iterator over bytes objects, based on self.pieces but with
@@ -161,46 +233,88 @@ class LinkedFileWriter:
         # Now create the actual string list to be returned
         rememberTell = f.tell()
         
-        if any((t[2] is not None) and (t[2] & 7) for t in v):
-            partial = []
-            implode = utilitiesbackend.utImplode
-            explode = utilitiesbackend.utExplode
-            
-            for offset, byteLen, bitCount in v:
-                if not byteLen:
-                    continue
-                
-                f.seek(offset)
-                bs = f.read(byteLen)
+        # The reads below move the backing file's position, and new pieces are
+        # always written at that position; so it has to be restored even if
+        # the client stops iterating early (as checkSum() does).
+        
+        try:
+            if any((t[2] is not None) and (t[2] & 7) for t in v):
+                partial = []
+                implode = utilitiesbackend.utImplode
+                explode = utilitiesbackend.utExplode
                 
-                if bitCount is None:
-                    if partial:
-                        thisBitLen = 8 * len(bs)
-                        partial += explode(bs)
-                        yield implode(partial[0:thisBitLen])
-                        partial = partial[thisBitLen:]
+                for i, (offset, byteLen, bitCount) in enumerate(v):
+                    if not byteLen:
+                        continue
                     
-                    else:  # this is purely an accelerator
-                        yield bs
-                
-                else:
-                    partial += explode(bs)[0:bitCount]
+                    if i in self.fileRanges:
+                        fIn = self.sourceFiles[self.fileRanges[i]]
+                        bs = b''.join(self._readRange(fIn, offset, byteLen))
                     
-                    if len(partial) > 7:
-                        thisBitLen = 8 * (len(partial) // 8)
-                        yield implode(partial[0:thisBitLen])
-                        partial = partial[thisBitLen:]
+                    else:
+                        f.seek(offset)
+                        bs = f.read(byteLen)
+                    
+                    if bitCount is None:
+                        if partial:
+                            thisBitLen = 8 * len(bs)
+                            partial += explode(bs)
+                            yield implode(partial[0:thisBitLen])
+                            partial = partial[thisBitLen:]
+                        
+                        else:  # this is purely an accelerator
+                            yield bs
+                    
+                    else:
+                        partial += explode(bs)[0:bitCount]
+                        
+                        if len(partial) > 7:
+                            thisBitLen = 8 * (len(partial) // 8)
+                            yield implode(partial[0:thisBitLen])
+                            partial = partial[thisBitLen:]
+                
+                if partial:
+                    yield implode(partial)
             
-            if partial:
-                yield implode(partial)
+            else:
+                fileRanges = self.fileRanges
+                asTuples = kwArgs.get('rangesAsTuples', False)
+                
+                for i, (offset, byteLen, bitCount) in enumerate(v):
+                    if i in fileRanges:
+                        fIn = self.sourceFiles[fileRanges[i]]
+                        
+                        if asTuples:
+                            yield (fIn, offset, byteLen)
+                        else:
+                            yield from self._readRange(fIn, offset, byteLen)
+                        
+                        continue
+                    
+                    f.seek(offset)
+                    bs = f.read(byteLen)
+                    yield bs
         
-        else:
-            for offset, byteLen, bitCount in v:
-                f.seek(offset)
-                bs = f.read(byteLen)
-                yield bs
+        finally:
+            f.seek(rememberTell)
+    
+    @staticmethod
+    def _readRange(fIn, offset, length):
+        """
+        Yields the length bytes starting at offset in the file fIn, in chunks
+        of bounded size.
+        """
+        
+        fIn.seek(offset)
         
-        f.seek(rememberTell)
+        while length:
+            bs = fIn.read(min(length, _COPY_CHUNK))
+            
+            if not bs:
+                raise IOError("Source file is shorter than expected!")
+            
+            yield bs
+            length -= len(bs)
     
     def _resolveVariableFormatOffsets(self, **kwArgs):
         """
@@ -457,6 +571,34 @@ class LinkedFileWriter:
         self.add(format, value)
         return stake
     
+    def addFileRange(self, path, offset, length):
+        """
+        Adds length bytes from the file at path, starting at byte offset. The
+        bytes are not read here; they're read (or, in writeToFile(), copied
+        file-to-file by the kernel where possible) only when the writer's
+        contents are finally needed, so large pieces of an existing file can be
+        written without ever being held in memory.
+        
+        >>> w = LinkedFileWriter()
+        >>> w.addString(b"ab")
+        >>> w.addFileRange(_tempPath, 65, 5)
+        >>> w.add("H", 0x7A7A)
+        >>> w.byteLength
+        9
+        >>> utilities.hexdump(w.binaryString())
+               0 | 6162 4142 4344 457A  7A                  |abABCDEzz       |
+        
+        >>> print(hex(w.checkSum(start=2, stop=6)))
+        0x41424344
+        """
+        
+        if path not in self.sourceFiles:
+            self.sourceFiles[path] = open(path, "rb")
+        
+        self.fileRanges[len(self.pieces)] = path
+        self.pieces.append((offset, length, None))
+        self.bitLength += (8 * length)
+    
     def addGroup(self, format, iterable):
         """
         Adds a group according to the specified format.
@@ -925,8 +1067,10 @@ class LinkedFileWriter:
         """
         """
         
+        self._closeSourceFiles()
         self.backingFile.seek(0)
         self.backingFile.truncate()
+        self.fileRanges = {}  # index in self.pieces -> path
         self.pieces = []
         self.links = []
         self.linkHistory = None
@@ -1044,11 +1188,26 @@ class LinkedFileWriter:
     
     def writeToFile(self, path):
         """
+        Writes the resolved contents of the writer to the file at path. Pieces
+        added via addFileRange() are copied directly from their source files.
+        
+        >>> w = LinkedFileWriter()
+        >>> w.addFileRange(_tempPath, 250, 6)
+        >>> w.addString(b"!")
+        >>> fd, path = tempfile.mkstemp()
+        >>> os.close(fd)
+        >>> w.writeToFile(path)
+        >>> with open(path, "rb") as f: utilities.hexdump(f.read())
+               0 | FAFB FCFD FEFF 21                        |......!         |
+        >>> os.remove(path)
         """
         
         with open(path, "wb") as f:
-            for bs in self._makeResolvedIterator():
-                f.write(bs)
+            for bs in self._makeResolvedIterator(rangesAsTuples=True):
+                if isinstance(bs, tuple):
+                    self._copyRange(bs[0], f, bs[1], bs[2])
+                else:
+                    f.write(bs)
 
 # -----------------------------------------------------------------------------
 
@@ -1059,9 +1218,22 @@ class LinkedFileWriter:
 if 0:
     def __________________(): pass
 
+if __name__ == "__main__" and __debug__:
+    fd, _tempPath = tempfile.mkstemp()
+    os.close(fd)
+    f = open(_tempPath, "wb")
+    f.write(bytearray(range(256)))
+    f.close()
+    del f, fd
+
 def _test():
     import doctest
     doctest.testmod()
 
 if __name__ == "__main__":
-    _test()
+    try:
+        _test()
+    
+    finally:
+        if __debug__:
+            os.remove(_tempPath)
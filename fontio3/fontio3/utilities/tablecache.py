@@ -0,0 +1,185 @@
+#
+# tablecache.py
+#
+# Copyright © 2017 Monotype Imaging Inc. All Rights Reserved.
+#
+
+"""
+Support for a persistent, on-disk cache of the tables made by an Editor, so
+that reopening a font whose tables haven't changed doesn't mean parsing them
+all over again.
+"""
+
+# System imports
+import array
+import hashlib
+import os
+import pickle
+import tempfile
+
+# Other imports
+import fontio3
+
+# -----------------------------------------------------------------------------
+
+#
+# Private constants
+#
+
+_plainTypes = (bool, int, float, str, bytes, type(None), array.array)
+
+# -----------------------------------------------------------------------------
+
+#
+# Private functions
+#
+
+def _isPlain(obj):
+    if isinstance(obj, tuple):
+        return all(_isPlain(x) for x in obj)
+    
+    return isinstance(obj, _plainTypes)
+
+# -----------------------------------------------------------------------------
+
+#
+# Classes
+#
+
+class TableCache(object):
+    """
+    Objects representing a directory of cached tables. Each entry is a table
+    pickled with the highest protocol this Python supports, in a file whose
+    name is a BLAKE2b digest of the
+    fontio3 version, the table's tag and length, its binary data, and the
+    keyword arguments it was made with (which is how tables like 'hmtx' see
+    values from other tables).
+    
+    Keyword arguments are only keyed when they're plain values (numbers,
+    strings, arrays and the like); for anything else, like another table,
+    key() returns None, and the table shouldn't be cached. (An Editor keys
+    tables it passes as arguments by their raw data's digest instead.)
+    
+    The hits attribute counts the entries load() has found.
+    
+    >>> c = TableCache(_testDir)
+    >>> k = c.key(b'test', b'abcd', {'fontGlyphCount': 5})
+    >>> print(c.load(k))
+    None
+    >>> c.store(k, {'a': [1, 2]})
+    >>> c.load(k)
+    {'a': [1, 2]}
+    >>> c.hits
+    1
+    >>> k == c.key(b'test', b'abcd', {'fontGlyphCount': 6})
+    False
+    >>> k == c.key(b'tst2', b'abcd', {'fontGlyphCount': 5})
+    False
+    >>> print(c.key(b'test', b'abcd', {'editor': c}))
+    None
+    
+    Objects that can't be pickled are just not stored:
+    
+    >>> k = c.key(b'test', b'efgh', {})
+    >>> c.store(k, (lambda: None))
+    >>> print(c.load(k))
+    None
+    """
+    
+    #
+    # Initialization method
+    #
+    
+    def __init__(self, directory):
+        """
+        Initializes the TableCache with the specified directory, which is
+        created if it doesn't already exist.
+        """
+        
+        os.makedirs(directory, exist_ok=True)
+        self.directory = directory
+        self.hits = 0
+    
+    #
+    # Public methods
+    #
+    
+    def key(self, tag, data, kwArgs):
+        """
+        Returns the key (a hex string) for the table with the specified tag,
+        binary data and keyword arguments, or None if the keyword arguments
+        aren't all plain values.
+        """
+        
+        if not all(_isPlain(v) for v in kwArgs.values()):
+            return None
+        
+        h = hashlib.blake2b(digest_size=20)
+        h.update(fontio3.__version__.encode('ascii'))
+        h.update(tag)
+        h.update(len(data).to_bytes(8, 'big'))
+        h.update(data)
+        h.update(repr(sorted(kwArgs.items())).encode('utf-8'))
+        return h.hexdigest()
+    
+    def load(self, key):
+        """
+        Returns the table cached with the specified key, or None if there
+        isn't one (or it can't be read).
+        """
+        
+        try:
+            with open(os.path.join(self.directory, key), 'rb') as f:
+                obj = pickle.load(f)
+        
+        except Exception:
+            return None
+        
+        self.hits += 1
+        return obj
+    
+    def store(self, key, obj):
+        """
+        Caches obj with the specified key. The file is written under a
+        temporary name and then renamed, so other processes reading the cache
+        at the same time never see a partial entry.
+        """
+        
+        try:
+            s = pickle.dumps(obj, pickle.HIGHEST_PROTOCOL)
+        except Exception:
+            return
+        
+        fd, tempPath = tempfile.mkstemp(dir=self.directory)
+        
+        try:
+            with os.fdopen(fd, 'wb') as f:
+                f.write(s)
+            
+            os.replace(tempPath, os.path.join(self.directory, key))
+        
+        except OSError:
+            os.remove(tempPath)
+
+# -----------------------------------------------------------------------------
+
+#
+# Test code
+#
+
+if 0:
+    def __________________(): pass
+
+if __name__ == "__main__" and __debug__:
+    import shutil
+    
+    _testDir = tempfile.mkdtemp()
+
+def _test():
+    import doctest
+    doctest.testmod()
+
+if __name__ == "__main__":
+    if __debug__:
+        _test()
+        shutil.rmtree(_testDir)
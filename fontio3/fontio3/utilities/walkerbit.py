@@ -432,6 +432,44 @@ class StringWalkerBit:
     
     def getPhase(self): return self.getBitOffset() % 8
     
+    def glyphSlice(self, offsets, index):
+        """
+        Returns a memoryview of the bytes for entry index of a table like
+        'glyf', whose entries are located by offsets, an array('L') of byte
+        offsets relative to the start of this walker (as returned by
+        unpackLocaOffsets). The view shares the walker's underlying buffer, so
+        nothing is copied. The current offset of the walker is not used and is
+        not changed. An IndexError is raised if there is no entry index, and a
+        ValueError if the entry's offsets are out of order or run past the end
+        of the walker.
+        
+        >>> wb = StringWalkerBit(bytes(range(256)), bitStart=8 * 65)
+        >>> offsets = array.array('L', [0, 3, 3, 10])
+        >>> bytes(wb.glyphSlice(offsets, 0)), bytes(wb.glyphSlice(offsets, 1))
+        (b'ABC', b'')
+        >>> v = wb.glyphSlice(offsets, 2)
+        >>> v.tobytes(), v.obj is wb.asStringAndOffset()[0]
+        (b'DEFGHIJ', True)
+        >>> wb.glyphSlice(offsets, 3)
+        Traceback (most recent call last):
+          ...
+        IndexError: Glyph index out of range!
+        
+        >>> wb.glyphSlice(array.array('L', [10, 3]), 0)
+        Traceback (most recent call last):
+          ...
+        ValueError: Glyph offsets are out of order!
+        
+        >>> bytes(wb.glyphSlice(array.array('L', [190, 191]), 0))
+        b'\\xff'
+        >>> wb.glyphSlice(array.array('L', [190, 192]), 0)
+        Traceback (most recent call last):
+          ...
+        ValueError: Glyph data extend past the end of the table!
+        """
+        
+        return walkerbitbackend.wkbGlyphSlice(self.context, offsets, index)
+    
     def group(self, format, count, finalCoerce=False):
         """
         Unpacks count records, each of which has format, and returns them in a
@@ -918,6 +956,85 @@ class StringWalkerBit:
           itemCount,
           signed)
     
+    def unpackGlyphVariations(self, axisCount, pointCount):
+        """
+        Decodes all the tuple variations for one glyph in a 'gvar' table in a
+        single call. The walker must be at the start of the glyph's variation
+        data, and will be left just past the tuple variation headers. The
+        pointCount should not include the 4 phantom points.
+        
+        Returns a list with one (tupleIndex, peak, start, end, points, xs, ys)
+        tuple per variation: tupleIndex is the raw header value (including its
+        flags), peak, start and end are tuples of raw F2Dot14 values (or None
+        if not present in the header), points is an array('I') of point
+        indices, and xs and ys are array('h') of the corresponding deltas.
+        
+        >>> s = utilities.fromhex(
+        ...   "00 01 00 0A 00 08 A0 00 40 00 02 01 00 02 01 0A F6 81")
+        >>> wb = StringWalkerBit(s)
+        >>> v = wb.unpackGlyphVariations(1, 3)
+        >>> [(t[0], t[1], t[2], t[3], list(t[4]), list(t[5]), list(t[6])) for t in v]
+        [(40960, (16384,), None, None, [0, 2], [10, -10], [0, 0])]
+        >>> wb.getOffset()
+        10
+        
+        >>> StringWalkerBit(s[:-1]).unpackGlyphVariations(1, 3)
+        Traceback (most recent call last):
+          ...
+        IndexError: Attempt to unpack past end of string!
+        """
+        
+        return walkerbitbackend.wkbUnpackGlyphVariations(
+          self.context,
+          axisCount,
+          pointCount)
+    
+    def unpackLocaOffsets(self, isLong):
+        """
+        Decodes the rest of the walker as a 'loca' table and returns its byte
+        offsets as an array('L'); if isLong is False the entries are 16-bit
+        word offsets and are doubled. The walker is advanced past the entries
+        that were read.
+        
+        >>> wb = StringWalkerBit(utilities.fromhex("00 00 00 19 00 7D 00 C8"))
+        >>> list(wb.unpackLocaOffsets(False)), wb.atEnd()
+        ([0, 50, 250, 400], True)
+        >>> wb.reset()
+        >>> list(wb.unpackLocaOffsets(True))
+        [25, 8192200]
+        """
+        
+        return walkerbitbackend.wkbUnpackLocaOffsets(self.context, isLong)
+    
+    def unpackPackedDeltas(self, count):
+        """
+        Decodes count packed deltas, as used in 'gvar' and 'cvar' tables, and
+        returns them as an array('h'). The walker is advanced past all the runs
+        that were read.
+        
+        >>> wb = StringWalkerBit(utilities.fromhex("01 0A F6 81 40 01 00 80"))
+        >>> list(wb.unpackPackedDeltas(2)), list(wb.unpackPackedDeltas(2))
+        ([10, -10], [0, 0])
+        >>> list(wb.unpackPackedDeltas(2))
+        [256, 0]
+        """
+        
+        return walkerbitbackend.wkbUnpackPackedDeltas(self.context, count)
+    
+    def unpackPackedPoints(self, pointCount):
+        """
+        Decodes packed point numbers, as used in 'gvar' and 'cvar' tables, and
+        returns the absolute point indices as an array('I'). The pointCount
+        should not include the 4 phantom points; it is used when the packed
+        data specify all the points in the glyph.
+        
+        >>> wb = StringWalkerBit(utilities.fromhex("03 02 03 02 0E 00"))
+        >>> list(wb.unpackPackedPoints(20)), list(wb.unpackPackedPoints(2))
+        ([3, 5, 19], [0, 1, 2, 3, 4, 5])
+        """
+        
+        return walkerbitbackend.wkbUnpackPackedPoints(self.context, pointCount)
+    
     def unpackRest(self, format, coerce=True, strict=True):
         """
         Returns a tuple with values from the remainder of the string, as per
@@ -953,6 +1070,46 @@ class StringWalkerBit:
         """
         
         return walkerbitbackend.wkbUnpackRest(self.context, format, coerce, strict)
+    
+    def unpackSimpleGlyph(self):
+        """
+        Decodes the TrueType simple glyph starting at the current (byte-aligned)
+        offset and advances past it. Returns a tuple (bounds, xs, ys, onCurve,
+        contourEnds, hintBytes, highBit): bounds is (xMin, yMin, xMax, yMax), xs
+        and ys are array('h') of absolute coordinates, onCurve is a bytes object
+        with 1 for on-curve points, contourEnds is an array('H') of inclusive
+        last-point indices, and highBit is True if any flag had the 0x80 bit set.
+        
+        >>> s = utilities.fromhex(
+        ...   "00 01 00 00 00 00 00 64 00 64 00 02 00 00 31 33 27 64 32 64 FF")
+        >>> wb = StringWalkerBit(s)
+        >>> bounds, xs, ys, onCurve, ends, hints, highBit = wb.unpackSimpleGlyph()
+        >>> bounds, list(xs), list(ys), list(onCurve), list(ends)
+        ((0, 0, 100, 100), [0, 100, 50], [0, 0, 100], [1, 1, 1], [2])
+        >>> hints, highBit, int(wb.length())
+        (b'', False, 1)
+        
+        >>> StringWalkerBit(s[:-3]).unpackSimpleGlyph()
+        Traceback (most recent call last):
+          ...
+        IndexError: Attempt to unpack past end of string!
+        
+        Contour ends may repeat (for empty contours), but none may be past the
+        last one. A glyph with a negative number of contours is a composite;
+        None is returned for it, and the walker is not advanced.
+        
+        >>> s2 = utilities.fromhex(
+        ...   "00 02 00 00 00 00 00 64 00 64 00 03 00 02 00 00 31 33 27 64 32 64")
+        >>> StringWalkerBit(s2).unpackSimpleGlyph()
+        Traceback (most recent call last):
+          ...
+        ValueError: Contour end points are out of range!
+        >>> wb = StringWalkerBit(bytes([255, 255]) + s[2:])
+        >>> print(wb.unpackSimpleGlyph(), int(wb.getOffset()))
+        None 0
+        """
+        
+        return walkerbitbackend.wkbUnpackSimpleGlyph(self.context)
 
 # -----------------------------------------------------------------------------
 
@@ -991,6 +1148,7 @@ if 0:
     def __________________(): pass
 
 if __debug__:
+    import array
     from fontio3 import utilities
 
 def _test():
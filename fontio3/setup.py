@@ -35,6 +35,11 @@ fileWalkerHelper = Extension(
     sources = ["fontio3/backend/filewalker.c"],
     extra_compile_args = eca)
 
+intersectionLibHelper = Extension(
+    "fontio3.intersectionlibbackend",
+    sources = ["fontio3/backend/intersectionlib.c"],
+    extra_compile_args = eca)
+
 walkerBitHelper = Extension(
     "fontio3.walkerbitbackend",
     sources = ["fontio3/backend/walkerbit.c"],
@@ -136,6 +141,7 @@ setup(
     fastMathHelper,
     fileWalkerBitHelper,
     fileWalkerHelper,
+    intersectionLibHelper,
     walkerBitHelper,
     walkerHelper,
     utilitiesHelper,